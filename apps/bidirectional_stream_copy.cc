@@ -2,6 +2,7 @@
 
 #include "byte_stream.hh"
 #include "eventloop.hh"
+#include "shm_stream.hh"
 
 #include <algorithm>
 #include <iostream>
@@ -9,7 +10,8 @@
 
 using namespace std;
 
-void bidirectional_stream_copy(Socket &socket) {
+template <typename StreamT>
+static void stream_copy(StreamT &socket) {
     constexpr size_t max_copy_length = 65536;
     constexpr size_t buffer_size = 1048576;
 
@@ -39,8 +41,9 @@ void bidirectional_stream_copy(Socket &socket) {
         [&] { _outbound.end_input(); });
 
     // rule 2: read from outbound byte stream into socket
-    _eventloop.add_rule(socket,
-                        Direction::Out,
+    const auto [writable_fd, writable_direction] = poll_for_write(socket);
+    _eventloop.add_rule(writable_fd,
+                        writable_direction,
                         [&] {
                             const size_t bytes_to_write = min(max_copy_length, _outbound.buffer_size());
                             const size_t bytes_written = socket.write(_outbound.peek_output(bytes_to_write), false);
@@ -89,3 +92,7 @@ void bidirectional_stream_copy(Socket &socket) {
         }
     }
 }
+
+void bidirectional_stream_copy(Socket &socket) { stream_copy(socket); }
+
+void bidirectional_stream_copy(ShmStream &stream) { stream_copy(stream); }
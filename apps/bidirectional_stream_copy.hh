@@ -1,9 +1,13 @@
 #ifndef SPONGE_APPS_BIDIRECTIONAL_STREAM_COPY_HH
 #define SPONGE_APPS_BIDIRECTIONAL_STREAM_COPY_HH
 
+#include "shm_stream.hh"
 #include "socket.hh"
 
 //! Copy socket input/output to stdin/stdout until finished
 void bidirectional_stream_copy(Socket &socket);
 
+//! Copy stream input/output to stdin/stdout until finished
+void bidirectional_stream_copy(ShmStream &stream);
+
 #endif  // SPONGE_APPS_BIDIRECTIONAL_STREAM_COPY_HH
@@ -50,7 +50,8 @@ string summary(const EthernetFrame &frame) {
         case EthernetHeader::TYPE_IPv4: {
             InternetDatagram dgram;
             if (dgram.parse(frame.payload()) == ParseResult::NoError) {
-                ret += " " + dgram.header().summary();
+                ret += " ";
+                ret += dgram.header().summary();
                 ret += " payload=\"" + string(dgram.payload().concatenate()) + "\"";
             } else {
                 ret += " (bad IPv4)";
@@ -59,7 +60,8 @@ string summary(const EthernetFrame &frame) {
         case EthernetHeader::TYPE_ARP: {
             ARPMessage arp;
             if (arp.parse(frame.payload()) == ParseResult::NoError) {
-                ret += " " + arp.to_string();
+                ret += " ";
+                ret += arp.to_string();
             } else {
                 ret += " (bad ARP)";
             }
@@ -0,0 +1,162 @@
+#include "bidirectional_stream_copy.hh"
+#include "shm_stream.hh"
+#include "socket.hh"
+#include "util.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace std;
+using namespace std::chrono;
+
+static constexpr size_t CHUNK = 65536;
+
+//! A connected pair of streams of the given kind
+template <typename StreamT>
+static pair<StreamT, StreamT> make_streams();
+
+template <>
+pair<LocalStreamSocket, LocalStreamSocket> make_streams() {
+    int fds[2];
+    SystemCall("socketpair", ::socketpair(AF_UNIX, SOCK_STREAM, 0, static_cast<int *>(fds)));
+    return {LocalStreamSocket(FileDescriptor(fds[0])), LocalStreamSocket(FileDescriptor(fds[1]))};
+}
+
+template <>
+pair<ShmStream, ShmStream> make_streams() {
+    return ShmStream::connected_pair();
+}
+
+//! Stand-in for the TCP thread: send back everything that arrives, then end the stream
+template <typename StreamT>
+static void echo(StreamT &stream) {
+    string data;
+    while (true) {
+        stream.read(data, CHUNK);
+        if (stream.eof()) {
+            break;
+        }
+        stream.write(data);
+    }
+    stream.shutdown(SHUT_WR);
+}
+
+static void print_result(const string &label, const size_t bytes, const high_resolution_clock::duration elapsed) {
+    const auto ms = duration_cast<microseconds>(elapsed).count() / 1000.0;
+    const double gbps = double(bytes) * 8 / (ms / 1000.0) / 1e9;
+    cout << "  " << left << setw(30) << label << right << fixed << setprecision(2) << setw(9) << ms << " ms  "
+         << setw(7) << gbps << " Gbit/s\n";
+}
+
+//! One-way bulk transfer between two threads
+template <typename StreamT>
+static void one_way(const string &label, const size_t len) {
+    auto [a, b] = make_streams<StreamT>();
+    const string chunk(CHUNK, 'x');
+
+    const auto first_time = high_resolution_clock::now();
+    thread writer([&] {
+        for (size_t sent = 0; sent < len; sent += CHUNK) {
+            a.write(chunk);
+        }
+        a.shutdown(SHUT_WR);
+    });
+    size_t received = 0;
+    string data;
+    while (not b.eof()) {
+        b.read(data, CHUNK);
+        received += data.size();
+    }
+    writer.join();
+    const auto final_time = high_resolution_clock::now();
+
+    if (received != len) {
+        throw runtime_error(label + ": received " + to_string(received) + " bytes, expected " + to_string(len));
+    }
+    print_result(label, len, final_time - first_time);
+}
+
+//! \brief stdin -> stream -> echo thread -> stream -> stdout, through bidirectional_stream_copy
+//! \details stdin and stdout are pipes, fed and drained by two more threads, so the only
+//! difference between runs is the transport between bidirectional_stream_copy and the echo thread.
+template <typename StreamT>
+static void echo_through_stdio(const string &label, const size_t len) {
+    auto [near, far] = make_streams<StreamT>();
+    cout.flush();  // stdout is about to be redirected
+
+    int in_pipe[2], out_pipe[2];
+    SystemCall("pipe", ::pipe(static_cast<int *>(in_pipe)));
+    SystemCall("pipe", ::pipe(static_cast<int *>(out_pipe)));
+    // bidirectional_stream_copy closes stdin and stdout; keep the originals to restore afterwards
+    const int saved_stdin = SystemCall("dup", ::dup(STDIN_FILENO));
+    const int saved_stdout = SystemCall("dup", ::dup(STDOUT_FILENO));
+    SystemCall("dup2", ::dup2(in_pipe[0], STDIN_FILENO));
+    SystemCall("dup2", ::dup2(out_pipe[1], STDOUT_FILENO));
+    SystemCall("close", ::close(in_pipe[0]));
+    SystemCall("close", ::close(out_pipe[1]));
+    FileDescriptor source{in_pipe[1]}, sink{out_pipe[0]};
+
+    const auto first_time = high_resolution_clock::now();
+    thread echo_thread([&] { echo(far); });
+    thread source_thread([&] {
+        const string chunk(CHUNK, 'x');
+        for (size_t sent = 0; sent < len; sent += CHUNK) {
+            source.write(chunk);
+        }
+        source.close();
+    });
+    size_t received = 0;
+    thread sink_thread([&] {
+        string data;
+        while (not sink.eof()) {
+            sink.read(data, CHUNK);
+            received += data.size();
+        }
+    });
+
+    bidirectional_stream_copy(near);
+
+    source_thread.join();
+    sink_thread.join();
+    echo_thread.join();
+    const auto final_time = high_resolution_clock::now();
+
+    SystemCall("dup2", ::dup2(saved_stdin, STDIN_FILENO));
+    SystemCall("dup2", ::dup2(saved_stdout, STDOUT_FILENO));
+    SystemCall("close", ::close(saved_stdin));
+    SystemCall("close", ::close(saved_stdout));
+
+    if (received != len) {
+        throw runtime_error(label + ": received " + to_string(received) + " bytes, expected " + to_string(len));
+    }
+    print_result(label, len, final_time - first_time);
+}
+
+int main(int argc, char *argv[]) {
+    try {
+        if (argc > 2 or (argc == 2 and string(argv[1]) == "-h")) {
+            cerr << "Usage: " << argv[0] << " [megabytes (256)]\n";
+            return EXIT_FAILURE;
+        }
+        const size_t len = (argc == 2 ? stoul(argv[1]) : 256) * 1024 * 1024;
+
+        cout << "One-way transfer of " << len / (1024 * 1024) << " MiB between two threads:\n";
+        one_way<LocalStreamSocket>("socketpair", len);
+        one_way<ShmStream>("shared-memory rings", len);
+
+        cout << "Echo through bidirectional_stream_copy:\n";
+        echo_through_stdio<LocalStreamSocket>("socketpair", len);
+        echo_through_stdio<ShmStream>("shared-memory rings", len);
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -13,7 +13,10 @@ constexpr size_t len = 100 * 1024 * 1024;
 
 void move_segments(TCPConnection &x, TCPConnection &y, vector<TCPSegment> &segments, const bool reorder) {
     while (not x.segments_out().empty()) {
-        segments.emplace_back(move(x.segments_out().front()));
+        // TSO super-segments are split here, as an adapter would before writing them to the wire
+        for (TCPSegment &wire_seg : x.segments_out().front().wire_segments()) {
+            segments.emplace_back(move(wire_seg));
+        }
         x.segments_out().pop();
     }
     if (reorder) {
@@ -28,8 +31,10 @@ void move_segments(TCPConnection &x, TCPConnection &y, vector<TCPSegment> &segme
     segments.clear();
 }
 
-void main_loop(const bool reorder) {
+void main_loop(const bool reorder, const size_t tso_max_size = 0, const bool header_prediction = false) {
     TCPConfig config;
+    config.tso_max_size = tso_max_size;
+    config.header_prediction = header_prediction;
     TCPConnection x{config}, y{config};
 
     string string_to_send(len, 'x');
@@ -94,19 +99,78 @@ void main_loop(const bool reorder) {
 
     const auto gigabits_per_second = len * 8.0 / double(duration);
 
+    const char *variant = reorder             ? " with reordering: "
+                          : tso_max_size      ? " with TSO       : "
+                          : header_prediction ? " with prediction: "
+                                              : "                : ";
     cout << fixed << setprecision(2);
-    cout << "CPU-limited throughput" << (reorder ? " with reordering: " : "                : ") << gigabits_per_second
-         << " Gbit/s\n";
+    cout << "CPU-limited throughput" << variant << gigabits_per_second << " Gbit/s";
+    if (header_prediction) {
+        const HeaderPredictionStats &acks = x.header_prediction(), &data = y.header_prediction();
+        cout << " (fast path: " << acks.pure_acks << " of " << acks.pure_acks + acks.misses << " ACKs, "
+             << data.pure_data << " of " << data.pure_data + data.misses << " data segments)";
+    }
+    cout << "\n";
 
     while (x.active() or y.active()) {
         loop();
     }
 }
 
+//! A receiving application that reads only `read_rate` bytes per millisecond: how many segments,
+//! and how large, does the transfer take?
+void throttled_reader(const bool sws_avoidance) {
+    constexpr size_t total = 4 * 1024 * 1024, read_rate = 300;
+    TCPConfig config;
+    config.sws_avoidance = sws_avoidance;
+    TCPConnection x{config}, y{config};
+    x.connect();
+    y.end_input_stream();
+
+    size_t written = 0, segments = 0, payload_bytes = 0;
+    uint64_t elapsed_ms = 0;
+    while (not y.inbound_stream().eof()) {
+        while (written < total and x.remaining_outbound_capacity()) {
+            written += x.write(string(min(x.remaining_outbound_capacity(), total - written), 'x'));
+            if (written == total) {
+                x.end_input_stream();
+            }
+        }
+
+        while (not x.segments_out().empty()) {
+            if (x.segments_out().front().payload().size() > 0) {
+                segments++;
+                payload_bytes += x.segments_out().front().payload().size();
+            }
+            y.segment_received(x.segments_out().front());
+            x.segments_out().pop();
+        }
+        while (not y.segments_out().empty()) {
+            x.segment_received(y.segments_out().front());
+            y.segments_out().pop();
+        }
+
+        y.inbound_stream().pop_output(min(read_rate, y.inbound_stream().buffer_size()));
+
+        x.tick(1);
+        y.tick(1);
+        elapsed_ms++;
+    }
+
+    cout << fixed << setprecision(2);
+    cout << "Throttled reader (" << read_rate << " B/ms), SWS avoidance " << (sws_avoidance ? "on " : "off") << ": "
+         << segments << " segments, mean payload " << payload_bytes / segments << " bytes, "
+         << double(elapsed_ms) / 1000 << " s\n";
+}
+
 int main() {
     try {
         main_loop(false);
         main_loop(true);
+        main_loop(false, 64 * 1024);
+        main_loop(false, 0, true);
+        throttled_reader(false);
+        throttled_reader(true);
     } catch (const exception &e) {
         cerr << e.what() << "\n";
         return EXIT_FAILURE;
@@ -1,4 +1,5 @@
 #include "bidirectional_stream_copy.hh"
+#include "congestion_control.hh"
 #include "tcp_config.hh"
 #include "tcp_sponge_socket.hh"
 #include "tun.hh"
@@ -37,6 +38,14 @@ static void show_usage(const char *argv0, const char *msg) {
          << "   -Lu <loss>      Set uplink loss to <rate> (float in 0..1)       (no loss)\n"
          << "   -Ld <loss>      Set downlink loss to <rate> (float in 0..1)     (no loss)\n\n"
 
+         << "   -C <algorithm>  Congestion control: none, reno, newreno,        none\n"
+         << "                   cubic or bbr\n"
+         << "   -E              Negotiate ECN (RFC 3168)                        (no ECN)\n"
+         << "   -Q <Mbit/s>     Mark (or drop) datagrams beyond a virtual queue (no AQM)\n"
+         << "                   draining at this rate, in both directions\n"
+         << "   -Qt <bytes>     Queue size beyond which -Q marks                " << FdAdapterConfig{}.aqm_threshold
+         << "\n\n"
+
          << "   -h              Show this message.\n\n";
 
     if (msg != nullptr) {
@@ -109,6 +118,25 @@ static tuple<TCPConfig, FdAdapterConfig, bool, char *> get_config(int argc, char
                 static_cast<LossRateDnT>(static_cast<float>(numeric_limits<LossRateDnT>::max()) * lossrate);
             curr += 2;
 
+        } else if (strncmp("-C", argv[curr], 3) == 0) {
+            check_argc(argc, argv, curr, "ERROR: -C requires one argument.");
+            c_fsm.congestion_control = congestion_control_algorithm(argv[curr + 1]);
+            curr += 2;
+
+        } else if (strncmp("-E", argv[curr], 3) == 0) {
+            c_fsm.ecn = true;
+            curr += 1;
+
+        } else if (strncmp("-Q", argv[curr], 3) == 0) {
+            check_argc(argc, argv, curr, "ERROR: -Q requires one argument.");
+            c_filt.aqm_rate = uint64_t(strtod(argv[curr + 1], nullptr) * 1e6 / 8);
+            curr += 2;
+
+        } else if (strncmp("-Qt", argv[curr], 3) == 0) {
+            check_argc(argc, argv, curr, "ERROR: -Qt requires one argument.");
+            c_filt.aqm_threshold = strtoul(argv[curr + 1], nullptr, 0);
+            curr += 2;
+
         } else if (strncmp("-h", argv[curr], 3) == 0) {
             show_usage(argv[0], nullptr);
             exit(0);
@@ -142,7 +170,7 @@ int main(int argc, char **argv) {
         }
 
         auto [c_fsm, c_filt, listen, tun_dev_name] = get_config(argc, argv);
-        LossyTCPOverIPv4SpongeSocket tcp_socket(LossyTCPOverIPv4OverTunFdAdapter(
+        AqmTCPOverIPv4SpongeSocket tcp_socket(AqmTCPOverIPv4OverTunFdAdapter(
             TCPOverIPv4OverTunFdAdapter(TunFD(tun_dev_name == nullptr ? TUN_DFLT : tun_dev_name))));
 
         if (listen) {
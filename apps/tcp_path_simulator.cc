@@ -0,0 +1,251 @@
+#include "congestion_control.hh"
+#include "path_simulator.hh"
+#include "tcp_config.hh"
+
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static void show_usage(const char *argv0, const char *msg) {
+    cout << "Usage: " << argv0 << " [options] [algorithm...]\n\n"
+
+         << "Simulates one bulk transfer per congestion-control algorithm (none, reno, newreno, cubic, bbr)\n"
+         << "over the same bottleneck path, and prints the goodput of each over time.\n\n"
+
+         << "   Option                                                          Default\n"
+         << "   --                                                              --\n\n"
+
+         << "   -r <Mbit/s>     Bottleneck rate                                 1\n"
+         << "   -d <ms>         Round-trip propagation delay                    500\n"
+         << "   -q <bytes>      Bottleneck buffer                               32000\n"
+         << "   -L <loss>       Random loss rate (float in 0..1)                0.001\n"
+         << "   -m <bytes>      Path MTU (larger datagrams are dropped)         (no limit)\n"
+         << "   -s <seconds>    Length of each transfer                         120\n"
+         << "   -i <seconds>    Reporting interval                              5\n"
+         << "   -w <winsz>      Receive window, in bytes                        " << TCPConfig::DEFAULT_CAPACITY
+         << "\n"
+         << "   -p <Mbit/s>     Pace the sender at this rate                    (no pacing)\n"
+         << "   -b <bytes>      Pacing burst allowance                          " << TCPConfig{}.pacing_burst << "\n"
+         << "   -A              Adapt the RTO to measured RTTs (RFC 6298)       (fixed RTO)\n"
+         << "   -S              Use selective acknowledgments (RFC 2018)        (no SACK)\n"
+         << "   -M <bytes>      Maximum segment size (both ends)                " << TCPConfig::MAX_PAYLOAD_SIZE << "\n"
+         << "   -W              Use window scaling (RFC 7323)                   (no scaling)\n"
+         << "   -T              Use timestamps (RFC 7323)                       (no timestamps)\n"
+         << "   -D              Discover the path MTU (RFC 4821)                (fixed segment size)\n"
+         << "   -G <bytes>      Send bursts as TSO super-segments of this size  (no TSO)\n"
+         << "   -K              Delay the receiver's ACKs                       (QUICKACK)\n"
+         << "   -R              Auto-tune the receive window, from -w up to     (fixed window)\n"
+         << "                   " << TCPConfig{}.recv_capacity_max << " bytes\n\n"
+
+         << "   -h              Show this message and quit.\n\n";
+
+    if (msg != nullptr) {
+        cout << msg;
+    }
+    cout << endl;
+}
+
+//! Parameters of one run of the program
+struct Settings {
+    PathConfig path{};
+    uint64_t duration_us = 120'000'000;
+    uint64_t interval_us = 5'000'000;
+    size_t window = TCPConfig::DEFAULT_CAPACITY;
+    uint64_t pacing_rate = 0;
+    size_t pacing_burst = TCPConfig{}.pacing_burst;
+    bool adaptive_rto = false;
+    bool sack = false;
+    optional<uint16_t> mss{};
+    bool window_scaling = false;
+    bool timestamps = false;
+    bool plpmtud = false;
+    size_t tso_max_size = 0;
+    bool delayed_ack = false;
+    bool recv_autotune = false;
+    vector<string> algorithms{};
+};
+
+static Settings get_settings(int argc, char **argv) {
+    Settings settings;
+    settings.path.rate_bps = 1'000'000;
+    settings.path.rtt_us = 500'000;
+    settings.path.queue_bytes = 32'000;
+    settings.path.loss_rate = 0.001;
+    settings.path.step_us = 100;
+
+    int curr = 1;
+    const auto argument = [&](const char *err) {
+        if (curr + 1 >= argc) {
+            show_usage(argv[0], err);
+            exit(1);
+        }
+        curr += 2;
+        return argv[curr - 1];
+    };
+    while (curr < argc) {
+        if (strncmp("-r", argv[curr], 3) == 0) {
+            settings.path.rate_bps = uint64_t(strtod(argument("ERROR: -r requires one argument."), nullptr) * 1e6);
+        } else if (strncmp("-d", argv[curr], 3) == 0) {
+            settings.path.rtt_us = uint64_t(strtod(argument("ERROR: -d requires one argument."), nullptr) * 1000);
+        } else if (strncmp("-q", argv[curr], 3) == 0) {
+            settings.path.queue_bytes = strtoul(argument("ERROR: -q requires one argument."), nullptr, 0);
+        } else if (strncmp("-L", argv[curr], 3) == 0) {
+            settings.path.loss_rate = strtod(argument("ERROR: -L requires one argument."), nullptr);
+        } else if (strncmp("-m", argv[curr], 3) == 0) {
+            settings.path.mtu = strtoul(argument("ERROR: -m requires one argument."), nullptr, 0);
+        } else if (strncmp("-s", argv[curr], 3) == 0) {
+            settings.duration_us = uint64_t(strtod(argument("ERROR: -s requires one argument."), nullptr) * 1e6);
+        } else if (strncmp("-i", argv[curr], 3) == 0) {
+            settings.interval_us = uint64_t(strtod(argument("ERROR: -i requires one argument."), nullptr) * 1e6);
+        } else if (strncmp("-w", argv[curr], 3) == 0) {
+            settings.window = strtoul(argument("ERROR: -w requires one argument."), nullptr, 0);
+        } else if (strncmp("-p", argv[curr], 3) == 0) {
+            settings.pacing_rate = uint64_t(strtod(argument("ERROR: -p requires one argument."), nullptr) * 1e6 / 8);
+        } else if (strncmp("-b", argv[curr], 3) == 0) {
+            settings.pacing_burst = strtoul(argument("ERROR: -b requires one argument."), nullptr, 0);
+        } else if (strncmp("-A", argv[curr], 3) == 0) {
+            settings.adaptive_rto = true;
+            curr++;
+        } else if (strncmp("-S", argv[curr], 3) == 0) {
+            settings.sack = true;
+            curr++;
+        } else if (strncmp("-M", argv[curr], 3) == 0) {
+            settings.mss = uint16_t(strtoul(argument("ERROR: -M requires one argument."), nullptr, 0));
+        } else if (strncmp("-W", argv[curr], 3) == 0) {
+            settings.window_scaling = true;
+            curr++;
+        } else if (strncmp("-T", argv[curr], 3) == 0) {
+            settings.timestamps = true;
+            curr++;
+        } else if (strncmp("-D", argv[curr], 3) == 0) {
+            settings.plpmtud = true;
+            curr++;
+        } else if (strncmp("-G", argv[curr], 3) == 0) {
+            settings.tso_max_size = strtoul(argument("ERROR: -G requires one argument."), nullptr, 0);
+        } else if (strncmp("-K", argv[curr], 3) == 0) {
+            settings.delayed_ack = true;
+            curr++;
+        } else if (strncmp("-R", argv[curr], 3) == 0) {
+            settings.recv_autotune = true;
+            curr++;
+        } else if (strncmp("-h", argv[curr], 3) == 0) {
+            show_usage(argv[0], nullptr);
+            exit(0);
+        } else if (argv[curr][0] == '-') {
+            show_usage(argv[0], string("ERROR: unrecognized option " + string(argv[curr])).c_str());
+            exit(1);
+        } else {
+            settings.algorithms.emplace_back(argv[curr++]);
+        }
+    }
+    if (settings.algorithms.empty()) {
+        settings.algorithms = {"reno", "cubic", "bbr"};
+    }
+    if (settings.interval_us == 0 or settings.path.rate_bps == 0) {
+        show_usage(argv[0], "ERROR: the rate and the reporting interval must be positive.");
+        exit(1);
+    }
+    return settings;
+}
+
+//! Goodput of one transfer, per reporting interval, plus the totals
+struct Curve {
+    vector<double> mbps{};
+    PathStats stats{};
+    size_t mss = 0;  //!< The sender's segment size at the end
+};
+
+static Curve run(const Settings &settings, const string &algorithm) {
+    TCPConfig sender_cfg;
+    sender_cfg.congestion_control = congestion_control_algorithm(algorithm);
+    sender_cfg.send_capacity = 1'000'000;
+    sender_cfg.pacing_rate = settings.pacing_rate;
+    sender_cfg.pacing_burst = settings.pacing_burst;
+    sender_cfg.adaptive_rto = settings.adaptive_rto;
+    sender_cfg.sack = settings.sack;
+    sender_cfg.mss = settings.mss;
+    sender_cfg.window_scaling = settings.window_scaling;
+    sender_cfg.timestamps = settings.timestamps;
+    sender_cfg.plpmtud = settings.plpmtud;
+    sender_cfg.tso_max_size = settings.tso_max_size;
+    TCPConfig receiver_cfg;
+    receiver_cfg.recv_capacity = settings.window;
+    receiver_cfg.sack = settings.sack;
+    receiver_cfg.mss = settings.mss;
+    receiver_cfg.window_scaling = settings.window_scaling;
+    receiver_cfg.timestamps = settings.timestamps;
+    receiver_cfg.quickack = !settings.delayed_ack;
+    receiver_cfg.recv_autotune = settings.recv_autotune;
+
+    PathSimulator sim{sender_cfg, receiver_cfg, settings.path};
+    Curve curve;
+    uint64_t delivered = 0;
+    for (uint64_t t = 0; t < settings.duration_us; t += settings.interval_us) {
+        sim.run_for(settings.interval_us);
+        curve.mbps.push_back(double(sim.stats().bytes_delivered - delivered) * 8 / double(settings.interval_us));
+        delivered = sim.stats().bytes_delivered;
+    }
+    curve.stats = sim.stats();
+    curve.mss = sim.sender().sender().mss();
+    return curve;
+}
+
+int main(int argc, char **argv) {
+    try {
+        const Settings settings = get_settings(argc, argv);
+        const PathConfig &path = settings.path;
+        cout << "Path: " << double(path.rate_bps) / 1e6 << " Mbit/s, RTT " << double(path.rtt_us) / 1000 << " ms, "
+             << path.queue_bytes << "-byte buffer, loss " << path.loss_rate * 100 << "%, window "
+             << settings.window << " bytes";
+        if (path.mtu != 0) {
+            cout << ", MTU " << path.mtu << " bytes";
+        }
+        if (settings.pacing_rate != 0) {
+            cout << ", paced at " << double(settings.pacing_rate) * 8 / 1e6 << " Mbit/s";
+        }
+        cout << "\n\n";
+
+        vector<Curve> curves;
+        for (const auto &algorithm : settings.algorithms) {
+            curves.push_back(run(settings, algorithm));
+        }
+
+        cout << "Goodput (Mbit/s)\n" << setw(8) << "time(s)";
+        for (const auto &algorithm : settings.algorithms) {
+            cout << setw(10) << algorithm;
+        }
+        cout << "\n" << fixed;
+        for (size_t i = 0; i < curves.front().mbps.size(); i++) {
+            cout << setw(8) << setprecision(0) << double((i + 1) * settings.interval_us) / 1e6;
+            for (const auto &curve : curves) {
+                cout << setw(10) << setprecision(3) << curve.mbps.at(i);
+            }
+            cout << "\n";
+        }
+
+        cout << "\n"
+             << setw(10) << "algorithm" << setw(12) << "Mbit/s" << setw(10) << "sent" << setw(8) << "lost"
+             << setw(10) << "dropped" << setw(9) << "too big" << setw(14) << "mean queue" << setw(12) << "max queue"
+             << setw(7) << "MSS\n";
+        for (size_t i = 0; i < curves.size(); i++) {
+            const PathStats &stats = curves[i].stats;
+            cout << setw(10) << settings.algorithms[i] << setw(12) << setprecision(3)
+                 << double(stats.bytes_delivered) * 8 / double(settings.duration_us) << setw(10)
+                 << stats.segments_sent << setw(8) << stats.segments_lost << setw(10) << stats.segments_dropped
+                 << setw(9) << stats.segments_too_big << setw(11) << setprecision(1)
+                 << stats.mean_queue_delay_us() / 1000 << " ms" << setw(9) << double(stats.queue_delay_max_us) / 1000
+                 << " ms" << setw(7) << curves[i].mss << "\n";
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
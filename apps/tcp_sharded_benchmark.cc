@@ -0,0 +1,135 @@
+#include "address.hh"
+#include "tcp_sharded_engine.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+static constexpr uint16_t SERVER_PORT = 80;
+static constexpr uint16_t CLIENT_PORT_BASE = 10000;
+
+//! Per-flow progress; each field is only written by the shard that owns the corresponding endpoint
+struct FlowProgress {
+    size_t bytes_written{0};             //!< client: bytes accepted by TCPConnection::write
+    bool client_closed{false};           //!< client: has the outbound stream been ended?
+    bool server_closed{false};           //!< server: has the outbound stream been ended?
+    atomic<uint64_t> bytes_received{0};  //!< server: bytes read from the inbound stream
+};
+
+static void run(const size_t n_shards, const size_t n_flows, const size_t bytes_per_flow) {
+    const string payload(65536, 'x');
+    vector<FlowProgress> flows(n_flows);
+
+    const auto app = [&](const FlowKey &key, TCPConnection &conn) {
+        if (key.local_port == SERVER_PORT) {
+            FlowProgress &flow = flows.at(key.remote_port - CLIENT_PORT_BASE);
+            ByteStream &inbound = conn.inbound_stream();
+            flow.bytes_received += inbound.buffer_size();
+            inbound.pop_output(inbound.buffer_size());
+            if (inbound.eof() and not flow.server_closed) {
+                conn.end_input_stream();
+                flow.server_closed = true;
+            }
+            return;
+        }
+
+        FlowProgress &flow = flows.at(key.local_port - CLIENT_PORT_BASE);
+        conn.inbound_stream().pop_output(conn.inbound_stream().buffer_size());
+        while (flow.bytes_written < bytes_per_flow and conn.remaining_outbound_capacity() > 0) {
+            const size_t len =
+                min({conn.remaining_outbound_capacity(), bytes_per_flow - flow.bytes_written, payload.size()});
+            flow.bytes_written += conn.write(payload.substr(0, len));
+        }
+        if (flow.bytes_written == bytes_per_flow and not flow.client_closed) {
+            conn.end_input_stream();
+            flow.client_closed = true;
+        }
+    };
+
+    TCPConfig config;
+    config.rt_timeout = 100;
+    TCPShardedEngine engine{n_shards, config, app, 65536};
+    engine.listen(SERVER_PORT);
+    engine.start();
+
+    const uint32_t client_address = Address("10.0.0.1").ipv4_numeric();
+    const uint32_t server_address = Address("10.0.0.2").ipv4_numeric();
+
+    const auto first_time = high_resolution_clock::now();
+    for (size_t i = 0; i < n_flows; i++) {
+        engine.connect({client_address, server_address, uint16_t(CLIENT_PORT_BASE + i), SERVER_PORT});
+    }
+
+    // the dispatcher: every outbound segment is looped back to the connection at the other end of its flow
+    const auto loop_back = [&] {
+        if (0 == engine.poll_outbound([&](TCPShardedEngine::FlowSegment &&out) {
+                engine.dispatch(out.key.reversed(), move(out.segment));
+            })) {
+            this_thread::yield();
+        }
+    };
+
+    const auto all_received = [&] {
+        return all_of(flows.begin(), flows.end(), [&](const FlowProgress &f) {
+            return f.bytes_received.load() == bytes_per_flow;
+        });
+    };
+
+    while (not all_received()) {
+        loop_back();
+    }
+
+    const auto final_time = high_resolution_clock::now();
+    const auto duration = duration_cast<nanoseconds>(final_time - first_time).count();
+    const auto gigabits_per_second = double(n_flows * bytes_per_flow) * 8.0 / double(duration);
+
+    uint64_t min_segments = UINT64_MAX, max_segments = 0;
+    for (size_t i = 0; i < engine.shard_count(); i++) {
+        const uint64_t segments = engine.stats(i).segments_received.load();
+        min_segments = min(min_segments, segments);
+        max_segments = max(max_segments, segments);
+    }
+
+    cout << fixed << setprecision(2);
+    cout << setw(3) << n_shards << " shard(s): " << setw(8) << gigabits_per_second << " Gbit/s"
+         << "  (segments per shard: " << min_segments << " .. " << max_segments << ")\n";
+
+    // let the connections close cleanly (including the active closer's linger period)
+    while (engine.active_connections() > 0) {
+        loop_back();
+    }
+    engine.stop();
+}
+
+int main(int argc, char *argv[]) {
+    try {
+        if (argc > 4 or (argc > 1 and string(argv[1]) == "-h")) {
+            cerr << "Usage: " << argv[0] << " [flows (64)] [bytes per flow (1048576)] [max shards (#cores)]\n";
+            return EXIT_FAILURE;
+        }
+
+        const size_t n_flows = argc > 1 ? stoul(argv[1]) : 64;
+        const size_t bytes_per_flow = argc > 2 ? stoul(argv[2]) : 1048576;
+        const size_t max_shards =
+            argc > 3 ? stoul(argv[3]) : max(1u, min(thread::hardware_concurrency(), unsigned(16)));
+
+        cout << "Loopback throughput of " << n_flows << " flows x " << bytes_per_flow << " bytes:\n";
+        for (size_t n_shards = 1; n_shards <= max_shards; n_shards *= 2) {
+            run(n_shards, n_flows, bytes_per_flow);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
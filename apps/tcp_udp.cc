@@ -1,4 +1,5 @@
 #include "bidirectional_stream_copy.hh"
+#include "congestion_control.hh"
 #include "tcp_config.hh"
 #include "tcp_sponge_socket.hh"
 
@@ -26,7 +27,31 @@ static void show_usage(const char *argv0, const char *msg) {
          << "   -w <winsz>      Use a window of <winsz> bytes                   " << TCPConfig::MAX_PAYLOAD_SIZE
          << "\n\n"
 
-         << "   -t <tmout>      Set rt_timeout to tmout                         " << TCPConfig::TIMEOUT_DFLT << "\n\n"
+         << "   -t <tmout>      Set rt_timeout to tmout                         " << TCPConfig::TIMEOUT_DFLT << "\n"
+         << "   -A              Adapt the RTO to measured RTTs (RFC 6298)       (fixed RTO)\n"
+         << "   -S              Offer selective acknowledgments (RFC 2018)      (no SACK)\n"
+         << "   -M <bytes>      Advertise this maximum segment size             (no MSS option)\n"
+         << "   -W              Offer window scaling (RFC 7323)                 (no scaling)\n"
+         << "   -T              Offer timestamps (RFC 7323)                     (no timestamps)\n"
+         << "   -D              Discover the path MTU (RFC 4821)                (fixed segment size)\n"
+         << "   -G <bytes>      Send bursts as TSO super-segments of this size  (no TSO)\n"
+         << "   -N              Coalesce small writes (Nagle's algorithm)       (NODELAY)\n"
+         << "   -K              Delay ACKs                                      (QUICKACK)\n"
+         << "   -R              Auto-tune the receive window, from -w up to     (fixed window)\n"
+         << "                   " << TCPConfig{}.recv_capacity_max << " bytes\n"
+         << "   -Y              Avoid silly-window syndrome (RFC 1122)          (no SWS avoidance)\n"
+         << "   -Z              Probe zero windows with a backed-off persist    (probe every RTO)\n"
+         << "                   timer\n"
+         << "   -L              Detect losses by time, and probe tail losses    (dupacks and RTO)\n"
+         << "                   (RACK-TLP, RFC 8985; needs -S and -C)\n"
+         << "   -H              Take common segments on a fast path (header     (general path)\n"
+         << "                   prediction)\n\n"
+
+         << "   -C <algorithm>  Congestion control: none, reno, newreno,        none\n"
+         << "                   cubic or bbr\n\n"
+
+         << "   -P <Mbit/s>     Pace new segments at this rate                  (no pacing)\n"
+         << "   -B <bytes>      Pacing burst allowance                          " << TCPConfig{}.pacing_burst << "\n\n"
 
          << "   -Lu <loss>      Set uplink loss to <rate> (float in 0..1)       (no loss)\n"
          << "   -Ld <loss>      Set downlink loss to <rate> (float in 0..1)     (no loss)\n\n"
@@ -68,6 +93,79 @@ static tuple<TCPConfig, FdAdapterConfig, bool> get_config(int argc, char **argv)
             c_fsm.rt_timeout = strtol(argv[curr + 1], nullptr, 0);
             curr += 2;
 
+        } else if (strncmp("-A", argv[curr], 3) == 0) {
+            c_fsm.adaptive_rto = true;
+            curr += 1;
+
+        } else if (strncmp("-S", argv[curr], 3) == 0) {
+            c_fsm.sack = true;
+            curr += 1;
+
+        } else if (strncmp("-M", argv[curr], 3) == 0) {
+            check_argc(argc, argv, curr, "ERROR: -M requires one argument.");
+            c_fsm.mss = uint16_t(strtoul(argv[curr + 1], nullptr, 0));
+            curr += 2;
+
+        } else if (strncmp("-W", argv[curr], 3) == 0) {
+            c_fsm.window_scaling = true;
+            curr += 1;
+
+        } else if (strncmp("-T", argv[curr], 3) == 0) {
+            c_fsm.timestamps = true;
+            curr += 1;
+
+        } else if (strncmp("-D", argv[curr], 3) == 0) {
+            c_fsm.plpmtud = true;
+            curr += 1;
+
+        } else if (strncmp("-G", argv[curr], 3) == 0) {
+            check_argc(argc, argv, curr, "ERROR: -G requires one argument.");
+            c_fsm.tso_max_size = strtoul(argv[curr + 1], nullptr, 0);
+            curr += 2;
+
+        } else if (strncmp("-N", argv[curr], 3) == 0) {
+            c_fsm.nodelay = false;
+            curr += 1;
+
+        } else if (strncmp("-K", argv[curr], 3) == 0) {
+            c_fsm.quickack = false;
+            curr += 1;
+
+        } else if (strncmp("-R", argv[curr], 3) == 0) {
+            c_fsm.recv_autotune = true;
+            curr += 1;
+
+        } else if (strncmp("-Y", argv[curr], 3) == 0) {
+            c_fsm.sws_avoidance = true;
+            curr += 1;
+
+        } else if (strncmp("-Z", argv[curr], 3) == 0) {
+            c_fsm.persist_timer = true;
+            curr += 1;
+
+        } else if (strncmp("-L", argv[curr], 3) == 0) {
+            c_fsm.rack_tlp = true;
+            curr += 1;
+
+        } else if (strncmp("-H", argv[curr], 3) == 0) {
+            c_fsm.header_prediction = true;
+            curr += 1;
+
+        } else if (strncmp("-C", argv[curr], 3) == 0) {
+            check_argc(argc, argv, curr, "ERROR: -C requires one argument.");
+            c_fsm.congestion_control = congestion_control_algorithm(argv[curr + 1]);
+            curr += 2;
+
+        } else if (strncmp("-P", argv[curr], 3) == 0) {
+            check_argc(argc, argv, curr, "ERROR: -P requires one argument.");
+            c_fsm.pacing_rate = uint64_t(strtod(argv[curr + 1], nullptr) * 1e6 / 8);
+            curr += 2;
+
+        } else if (strncmp("-B", argv[curr], 3) == 0) {
+            check_argc(argc, argv, curr, "ERROR: -B requires one argument.");
+            c_fsm.pacing_burst = strtoul(argv[curr + 1], nullptr, 0);
+            curr += 2;
+
         } else if (strncmp("-Lu", argv[curr], 3) == 0) {
             check_argc(argc, argv, curr, "ERROR: -Lu requires one argument.");
             float lossrate = strtof(argv[curr + 1], nullptr);
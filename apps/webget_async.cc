@@ -0,0 +1,48 @@
+#include "async_eventloop.hh"
+#include "async_tcp_socket.hh"
+#include "task.hh"
+#include "tcp_sponge_socket.hh"
+#include "util.hh"
+
+#include <cstdlib>
+#include <iostream>
+
+using namespace std;
+
+//! webget, written as a coroutine: the owner thread only waits inside the AsyncEventLoop
+Task<> get_URL(AsyncEventLoop &loop, FullStackSocket &socket, const string host, const string path) {
+    AsyncTCPSocket<FullStackSocket> sock{loop, socket};
+    co_await sock.connect(Address(host, "http"));
+
+    co_await sock.write("GET " + path + " HTTP/1.1\r\n" + "Host: " + host + "\r\n" + "Connection: close\r\n\r\n");
+    sock.shutdown(SHUT_WR);
+
+    while (not sock.eof()) {
+        cout << co_await sock.read();
+    }
+}
+
+int main(int argc, char *argv[]) {
+    try {
+        if (argc <= 0) {
+            abort();  // For sticklers: don't try to access argv[0] if argc <= 0.
+        }
+
+        if (argc != 3) {
+            cerr << "Usage: " << argv[0] << " HOST PATH\n";
+            cerr << "\tExample: " << argv[0] << " stanford.edu /class/cs144\n";
+            return EXIT_FAILURE;
+        }
+
+        AsyncEventLoop loop;
+        FullStackSocket socket;
+        loop.spawn(get_URL(loop, socket, argv[1], argv[2]));
+        loop.run();
+        socket.wait_until_closed();
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,140 @@
+#include "tcp_connection.hh"
+#include "work_stealing_executor.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+//! Two TCPConnections joined back-to-back; one "round" pushes a chunk of data from x to y
+class FlowPair {
+    TCPConnection _x;
+    TCPConnection _y;
+    string _chunk;
+
+    static void move_segments(TCPConnection &from, TCPConnection &to) {
+        while (not from.segments_out().empty()) {
+            to.segment_received(from.segments_out().front());
+            from.segments_out().pop();
+        }
+    }
+
+  public:
+    FlowPair(const TCPConfig &config, const size_t chunk_size)
+        : _x(config), _y(config), _chunk(chunk_size, 'x') {
+        _x.connect();
+        move_segments(_x, _y);
+        move_segments(_y, _x);
+        move_segments(_x, _y);
+    }
+
+    //! One work item: write a chunk, deliver the data segments and the acks, read the data, let time pass
+    void round() {
+        _x.write(_chunk.substr(0, _x.remaining_outbound_capacity()));
+        move_segments(_x, _y);
+        _y.inbound_stream().pop_output(_y.inbound_stream().buffer_size());
+        move_segments(_y, _x);
+        _x.tick(1);
+        _y.tick(1);
+    }
+
+    //! Close both directions so the connections can be destroyed without a RST
+    void close() {
+        _x.end_input_stream();
+        _y.end_input_stream();
+        for (unsigned i = 0; i < 4; i++) {
+            move_segments(_x, _y);
+            move_segments(_y, _x);
+        }
+        _x.tick(10 * TCPConfig::TIMEOUT_DFLT);
+        _y.tick(10 * TCPConfig::TIMEOUT_DFLT);
+    }
+};
+
+static void run(const bool stealing,
+                const size_t n_workers,
+                const size_t n_flows,
+                const size_t n_rounds,
+                const double skew) {
+    TCPConfig config;
+    WorkStealingExecutor executor{n_workers, stealing};
+
+    vector<unique_ptr<FlowPair>> flows;
+    vector<shared_ptr<WorkStealingExecutor::Strand>> strands;
+    for (size_t i = 0; i < n_flows; i++) {
+        flows.push_back(make_unique<FlowPair>(config, 4096));
+        strands.push_back(executor.make_strand(i % n_workers));
+    }
+
+    // Zipf-distributed rounds: flow i gets a share proportional to 1 / (i + 1)^skew
+    vector<size_t> rounds(n_flows);
+    double total_weight = 0;
+    for (size_t i = 0; i < n_flows; i++) {
+        total_weight += 1.0 / pow(double(i + 1), skew);
+    }
+    for (size_t i = 0; i < n_flows; i++) {
+        rounds[i] = max(size_t(1), size_t(double(n_rounds) / pow(double(i + 1), skew) / total_weight));
+    }
+
+    const auto first_time = high_resolution_clock::now();
+    for (size_t posted = 0, max_rounds = rounds[0]; posted < max_rounds; posted++) {
+        for (size_t i = 0; i < n_flows; i++) {
+            if (posted < rounds[i]) {
+                FlowPair *flow = flows[i].get();
+                executor.post(strands[i], [flow] { flow->round(); });
+            }
+        }
+    }
+    executor.wait_idle();
+    const auto final_time = high_resolution_clock::now();
+
+    uint64_t max_tasks = 0, total_tasks = 0, steals = 0;
+    for (size_t i = 0; i < executor.worker_count(); i++) {
+        max_tasks = max(max_tasks, executor.stats(i).tasks_run.load());
+        total_tasks += executor.stats(i).tasks_run.load();
+        steals += executor.stats(i).steals.load();
+    }
+    const double imbalance = double(max_tasks) * double(n_workers) / double(total_tasks);
+
+    cout << fixed << setprecision(2);
+    cout << (stealing ? "work stealing:   " : "static sharding: ") << setw(8)
+         << duration_cast<microseconds>(final_time - first_time).count() / 1000.0 << " ms, "
+         << "busiest worker ran " << imbalance << "x its fair share, " << steals << " steals\n";
+
+    for (auto &flow : flows) {
+        flow->close();
+    }
+}
+
+int main(int argc, char *argv[]) {
+    try {
+        if (argc > 5 or (argc > 1 and string(argv[1]) == "-h")) {
+            cerr << "Usage: " << argv[0] << " [workers (#cores)] [flows (64)] [rounds (20000)] [zipf skew (1.2)]\n";
+            return EXIT_FAILURE;
+        }
+
+        const size_t n_workers = argc > 1 ? stoul(argv[1]) : max(2u, thread::hardware_concurrency());
+        const size_t n_flows = argc > 2 ? stoul(argv[2]) : 64;
+        const size_t n_rounds = argc > 3 ? stoul(argv[3]) : 20000;
+        const double skew = argc > 4 ? stod(argv[4]) : 1.2;
+
+        cout << n_rounds << " rounds over " << n_flows << " flows (zipf " << skew << ") on " << n_workers
+             << " workers:\n";
+        run(false, n_workers, n_flows, n_rounds, skew);
+        run(true, n_workers, n_flows, n_rounds, skew);
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -6,6 +6,7 @@ add_test(NAME t_wrapping_ints_cmp         COMMAND wrapping_integers_cmp)
 add_test(NAME t_wrapping_ints_unwrap      COMMAND wrapping_integers_unwrap)
 add_test(NAME t_wrapping_ints_wrap        COMMAND wrapping_integers_wrap)
 add_test(NAME t_wrapping_ints_roundtrip   COMMAND wrapping_integers_roundtrip)
+add_test(NAME t_wrapping_ints_boundaries  COMMAND wrapping_integers_boundaries)
 
 add_test(NAME t_recv_connect         COMMAND recv_connect)
 add_test(NAME t_recv_transmit        COMMAND recv_transmit)
@@ -43,6 +44,27 @@ add_test(NAME arp_network_interface    COMMAND net_interface)
 
 add_test(NAME router_test    COMMAND network_simulator)
 
+add_test(NAME t_sharded_engine       COMMAND sharded_engine)
+add_test(NAME t_work_stealing        COMMAND work_stealing_executor)
+add_test(NAME t_async_socket         COMMAND async_socket)
+add_test(NAME t_shm_stream           COMMAND shm_stream)
+add_test(NAME t_tcp_clock            COMMAND tcp_clock)
+add_test(NAME t_congestion_control   COMMAND congestion_control)
+add_test(NAME t_pacing               COMMAND pacing)
+add_test(NAME t_rtt_estimator        COMMAND rtt_estimator)
+add_test(NAME t_sack                 COMMAND sack)
+add_test(NAME t_tcp_options          COMMAND tcp_options)
+add_test(NAME t_plpmtud              COMMAND plpmtud)
+add_test(NAME t_byte_stream_buffers  COMMAND byte_stream_buffers)
+add_test(NAME t_tso                  COMMAND tso)
+add_test(NAME t_small_writes         COMMAND small_writes)
+add_test(NAME t_recv_autotune        COMMAND recv_autotune)
+add_test(NAME t_sws_avoidance        COMMAND sws_avoidance)
+add_test(NAME t_persist_timer        COMMAND persist_timer)
+add_test(NAME t_rack_tlp             COMMAND rack_tlp)
+add_test(NAME t_ecn                  COMMAND ecn)
+add_test(NAME t_header_prediction    COMMAND header_prediction)
+
 add_test(NAME t_tcp_parser           COMMAND tcp_parser "${PROJECT_SOURCE_DIR}/tests/ipv4_parser.data")
 add_test(NAME t_ipv4_parser          COMMAND ipv4_parser "${PROJECT_SOURCE_DIR}/tests/ipv4_parser.data")
 add_test(NAME t_active_close         COMMAND fsm_active_close)
@@ -56,6 +78,7 @@ add_test(NAME t_retx                 COMMAND fsm_retx_relaxed)
 add_test(NAME t_retx_win             COMMAND fsm_retx_win)
 add_test(NAME t_loopback             COMMAND fsm_loopback)
 add_test(NAME t_loopback_win         COMMAND fsm_loopback_win)
+add_test(NAME t_loopback_lossy       COMMAND fsm_loopback_lossy)
 add_test(NAME t_reorder              COMMAND fsm_reorder)
 
 add_test(NAME t_address_dt           COMMAND address_dt)
@@ -1,5 +1,8 @@
 #include "byte_stream.hh"
 
+#include <algorithm>
+#include <stdexcept>
+
 // Dummy implementation of a flow-controlled in-memory byte stream.
 
 // For Lab 0, please replace with a real implementation that passes the
@@ -12,38 +15,48 @@
 
 using namespace std;
 
-ByteStream::ByteStream(const size_t capacity)
-    : s(""), scapacity(capacity), bytesWritten(0), bytesRead(0), writeEnded{0} {}
+ByteStream::ByteStream(const size_t capacity) : scapacity(capacity), bytesWritten(0), bytesRead(0), writeEnded{0} {}
 
 size_t ByteStream::write(const string &data) {
-    size_t rc = remaining_capacity();
-    if (data.size() < rc) {
-        s = s + data;
-        bytesWritten += data.size();
-        return data.size();
-    } else {
-        s = s + data.substr(0, rc);
-        bytesWritten += rc;
-        return rc;
-    }
+    const size_t len = min(data.size(), remaining_capacity());
+    if (len > 0)
+        buffers.emplace_back(data.substr(0, len));
+    bytesWritten += len;
+    return len;
+}
+
+size_t ByteStream::write(const Buffer &data) {
+    const size_t len = min(data.size(), remaining_capacity());
+    if (len > 0)
+        buffers.push_back(data.substr(0, len));
+    bytesWritten += len;
+    return len;
 }
 
 //! \param[in] len bytes will be copied from the output side of the buffer
 string ByteStream::peek_output(const size_t len) const {
     string res;
-    if (len <= s.size())
-        res = s.substr(0, len);
-    else
-        res = s;
+    res.reserve(min(len, buffer_size()));
+    for (const Buffer &buf : buffers) {
+        if (res.size() == len)
+            break;
+        res.append(buf.str().substr(0, len - res.size()));
+    }
     return res;
 }
 
 //! \param[in] len bytes will be removed from the output side of the buffer
 void ByteStream::pop_output(const size_t len) {
-    if (len == s.size())
-        s.clear();
-    else
-        s = s.substr(len);
+    if (len > buffer_size())
+        throw out_of_range("ByteStream::pop_output");
+    for (size_t n = len; n > 0;) {
+        if (n < buffers.front().size()) {
+            buffers.front().remove_prefix(n);
+            break;
+        }
+        n -= buffers.front().size();
+        buffers.pop_front();
+    }
     bytesRead += len;
 }
 
@@ -56,21 +69,29 @@ std::string ByteStream::read(const size_t len) {
     return res;
 }
 
+//! \param[in] len bytes will be popped and returned
+Buffer ByteStream::read_buffer(const size_t len) {
+    const size_t n = min(len, buffer_size());
+    if (n == 0)
+        return {};
+    const Buffer &front = buffers.front();
+    Buffer res = n <= front.size() ? front.substr(0, n) : Buffer{peek_output(n)};
+    pop_output(n);
+    return res;
+}
+
 void ByteStream::end_input() { writeEnded = true; }
 
 bool ByteStream::input_ended() const { return writeEnded; }
 
-size_t ByteStream::buffer_size() const { return s.size(); }
+size_t ByteStream::buffer_size() const { return bytesWritten - bytesRead; }
 
-bool ByteStream::buffer_empty() const { return !s.size(); }
+bool ByteStream::buffer_empty() const { return buffer_size() == 0; }
 
-bool ByteStream::eof() const { return writeEnded && !s.size(); }
+bool ByteStream::eof() const { return writeEnded && buffer_empty(); }
 
 size_t ByteStream::bytes_written() const { return bytesWritten; }
 
 size_t ByteStream::bytes_read() const { return bytesRead; }
 
-size_t ByteStream::remaining_capacity() const {
-    size_t cs = s.size();
-    return scapacity - cs;
-}
+size_t ByteStream::remaining_capacity() const { return scapacity - buffer_size(); }
@@ -1,6 +1,10 @@
 #ifndef SPONGE_LIBSPONGE_BYTE_STREAM_HH
 #define SPONGE_LIBSPONGE_BYTE_STREAM_HH
 
+#include "buffer.hh"
+
+#include <algorithm>
+#include <deque>
 #include <string>
 using std::string;
 //! \brief An in-order byte stream.
@@ -16,7 +20,7 @@ class ByteStream {
     // all, but if any of your tests are taking longer than a second,
     // that's a sign that you probably want to keep exploring
     // different approaches.
-    string s;
+    std::deque<Buffer> buffers{};  //!< Unread bytes, in the Buffers they were written in
     size_t scapacity;
     size_t bytesWritten;
     size_t bytesRead;
@@ -35,9 +39,16 @@ class ByteStream {
     //! \returns the number of bytes accepted into the stream
     size_t write(const std::string &data);
 
+    //! Write the bytes of a Buffer (as many as will fit), sharing its storage instead of copying them
+    //! \returns the number of bytes accepted into the stream
+    size_t write(const Buffer &data);
+
     //! \returns the number of additional bytes that the stream has space for
     size_t remaining_capacity() const;
 
+    //! Let the stream hold up to `capacity` bytes (it never shrinks)
+    void grow_capacity(const size_t capacity) { scapacity = std::max(scapacity, capacity); }
+
     //! Signal that the byte stream has reached its ending
     void end_input();
 
@@ -59,6 +70,11 @@ class ByteStream {
     //! \returns a string
     std::string read(const size_t len);
 
+    //! \brief Read the next "len" bytes of the stream (or fewer, if the stream holds fewer)
+    //! \returns a view of the stream's storage if the bytes were written in one write(),
+    //! otherwise a copy
+    Buffer read_buffer(const size_t len);
+
     //! \returns `true` if the stream input has ended
     bool input_ended() const;
 
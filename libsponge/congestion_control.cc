@@ -0,0 +1,412 @@
+#include "congestion_control.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+
+//! \details In slow start, using half the window counts (the window doubles every round trip);
+//! otherwise the flight size must have been within one segment of the window.
+bool RenoCongestionControl::_cwnd_limited(const AckSample &ack) const {
+    const uint64_t flight_before_ack = ack.bytes_in_flight + ack.bytes_acked;
+    return _cwnd < _ssthresh ? 2 * flight_before_ack > _cwnd : flight_before_ack + _mss > _cwnd;
+}
+
+//! \details Below ssthresh the window grows by up to one MSS per ack (slow start); above it,
+//! by one MSS per window's worth of acknowledged bytes (congestion avoidance).
+void RenoCongestionControl::_grow(const AckSample &ack) {
+    if (not _cwnd_limited(ack)) {
+        return;
+    }
+    if (_cwnd < _ssthresh) {
+        _cwnd += min(ack.bytes_acked, _mss);
+        return;
+    }
+    _bytes_acked_in_ca += ack.bytes_acked;
+    if (_bytes_acked_in_ca >= _cwnd) {
+        _bytes_acked_in_ca -= _cwnd;
+        _cwnd += _mss;
+    }
+}
+
+void RenoCongestionControl::_reduce_ssthresh(const uint64_t bytes_in_flight) {
+    _ssthresh = max(bytes_in_flight / 2, 2 * _mss);
+    _bytes_acked_in_ca = 0;
+}
+
+uint64_t RenoCongestionControl::on_ack(const AckSample &ack) {
+    if (_in_recovery) {
+        _in_recovery = false;
+        _cwnd = _ssthresh;
+    } else {
+        _grow(ack);
+    }
+    return _cwnd;
+}
+
+//! \details The window is ssthresh plus the segments that the duplicate ACKs reported delivered.
+uint64_t RenoCongestionControl::on_loss(const uint64_t, const uint64_t bytes_in_flight, const uint64_t next_seqno) {
+    _reduce_ssthresh(bytes_in_flight);
+    _cwnd = _ssthresh + DUPACK_THRESHOLD * _mss;
+    _in_recovery = true;
+    _recovery_point = next_seqno;
+    return _cwnd;
+}
+
+//! \details The window collapses to one segment (the loss window), and slow start begins again.
+uint64_t RenoCongestionControl::on_timeout(const uint64_t, const uint64_t bytes_in_flight) {
+    _reduce_ssthresh(bytes_in_flight);
+    _cwnd = _mss;
+    _in_recovery = false;
+    return _cwnd;
+}
+
+//! \details The window drops to ssthresh, as at the end of fast recovery (RFC 3168 6.1.2).
+uint64_t RenoCongestionControl::on_ecn(const uint64_t, const uint64_t bytes_in_flight) {
+    _reduce_ssthresh(bytes_in_flight);
+    _cwnd = _ssthresh;
+    return _cwnd;
+}
+
+uint64_t RenoCongestionControl::on_dupack(const uint64_t) {
+    if (_in_recovery) {
+        _cwnd += _mss;
+    }
+    return _cwnd;
+}
+
+void RenoCongestionControl::set_mss(const uint64_t mss) {
+    _cwnd = max(_cwnd * mss / _mss, mss);
+    if (_ssthresh != numeric_limits<uint64_t>::max()) {
+        _ssthresh = max(_ssthresh * mss / _mss, 2 * mss);
+    }
+    _mss = mss;
+}
+
+//! \details A partial ack deflates the window by the data it acknowledges, then adds back one
+//! segment if that was at least a segment (the retransmission it triggers takes its place).
+uint64_t NewRenoCongestionControl::on_ack(const AckSample &ack) {
+    if (_in_recovery and ack.ackno < _recovery_point) {
+        _cwnd -= min(ack.bytes_acked, _cwnd - _mss);
+        if (ack.bytes_acked >= _mss) {
+            _cwnd += _mss;
+        }
+        return _cwnd;  // partial ack: stay in recovery
+    }
+    if (_in_recovery) {
+        _in_recovery = false;
+        _cwnd = min(_ssthresh, max(ack.bytes_in_flight, _mss) + _mss);
+        return _cwnd;
+    }
+    _grow(ack);
+    return _cwnd;
+}
+
+//! \details A round ends when the ack passes what was next_seqno at the start of the round.
+//! Slow start ends if, after enough samples, the round's minimum RTT exceeds the previous
+//! round's by more than eta = clamp(previous / 8, 4 ms, 16 ms).
+void CubicCongestionControl::_hystart(const AckSample &ack) {
+    if (ack.ackno >= _round_end) {
+        _last_round_min_rtt_us = _round_min_rtt_us;
+        _round_min_rtt_us = numeric_limits<uint64_t>::max();
+        _round_samples = 0;
+        _round_end = ack.next_seqno;
+    }
+    if (ack.rtt_us == 0) {
+        return;
+    }
+    _round_min_rtt_us = min(_round_min_rtt_us, ack.rtt_us);
+    _round_samples++;
+
+    if (_round_samples >= HYSTART_MIN_SAMPLES and _last_round_min_rtt_us != numeric_limits<uint64_t>::max()) {
+        const uint64_t eta = clamp(_last_round_min_rtt_us / 8, HYSTART_MIN_ETA_US, HYSTART_MAX_ETA_US);
+        if (_round_min_rtt_us >= _last_round_min_rtt_us + eta) {
+            _ssthresh = _cwnd;
+        }
+    }
+}
+
+//! \details In congestion avoidance, with t the time since the epoch began (plus one RTT, to
+//! aim at where the window should be when this ack's data is acked), the target is
+//! W_cubic(t) = C (t - K)^3 + W_max. The window moves towards it by (target - cwnd) / cwnd
+//! per segment acked, but never falls behind the Reno-friendly estimate W_est.
+void CubicCongestionControl::_grow(const AckSample &ack) {
+    if (ack.rtt_us > 0) {
+        _min_rtt_us = _min_rtt_us ? min(_min_rtt_us, ack.rtt_us) : ack.rtt_us;
+    }
+
+    if (not _cwnd_limited(ack)) {
+        return;
+    }
+
+    if (_cwnd < _ssthresh) {
+        _hystart(ack);
+        if (_cwnd < _ssthresh) {
+            _cwnd += min(ack.bytes_acked, _mss);
+            return;
+        }
+    }
+
+    const double mss = double(_mss);
+    const double cwnd = double(_cwnd) / mss;
+    if (not _epoch_start_us.has_value()) {
+        _epoch_start_us = ack.now_us;
+        if (cwnd < _w_max) {
+            _k = cbrt((_w_max - cwnd) / C);
+        } else {
+            _k = 0;
+            _w_max = cwnd;
+        }
+        _w_est = cwnd;
+    }
+
+    const double t = double(ack.now_us - _epoch_start_us.value() + _min_rtt_us) / 1e6;
+    const double w_cubic = C * pow(t - _k, 3) + _w_max;
+    const double acked = double(ack.bytes_acked) / mss;
+    _w_est += ALPHA * acked / cwnd;
+
+    double increase = 0;  // in bytes
+    if (w_cubic < _w_est) {
+        increase = (_w_est - cwnd) * mss;  // Reno-friendly region
+    } else {
+        const double target = clamp(w_cubic, cwnd, 1.5 * cwnd);
+        increase = (target - cwnd) / cwnd * acked * mss;
+    }
+    _carry += max(increase, 0.0);
+    const auto whole_bytes = uint64_t(_carry);
+    _cwnd += whole_bytes;
+    _carry -= double(whole_bytes);
+}
+
+//! \details The window that suffered the loss is the smaller of cwnd and the flight size (a
+//! flow limited by the receiver's window has a cwnd that was never tested). With fast
+//! convergence, a loss below the previous W_max releases some of that bandwidth.
+void CubicCongestionControl::_reduce_ssthresh(const uint64_t bytes_in_flight) {
+    const double window = double(min(_cwnd, max(bytes_in_flight, _mss))) / double(_mss);
+    _w_max = window < _w_max ? window * (1 + BETA) / 2 : window;
+    _ssthresh = max(uint64_t(window * BETA * double(_mss)), 2 * _mss);
+    _epoch_start_us.reset();
+    _carry = 0;
+    _bytes_acked_in_ca = 0;
+}
+
+void BbrCongestionControl::_update_round(const AckSample &ack) {
+    _round_start = ack.ackno >= _round_end;
+    if (_round_start) {
+        _round++;
+        _round_end = ack.next_seqno;
+    }
+}
+
+//! \details Samples shorter than RTprop are ignored (the acks were compressed), and so are
+//! app-limited samples that don't raise the estimate (they underestimate the path).
+void BbrCongestionControl::_update_bandwidth(const AckSample &ack) {
+    if (ack.interval_us == 0 or ack.interval_us < _min_rtt_us) {
+        return;
+    }
+    const uint64_t rate = ack.delivered * 1'000'000 / ack.interval_us;
+    if (ack.app_limited and rate < bandwidth()) {
+        return;
+    }
+    while (not _bw_samples.empty() and _bw_samples.front().round + BW_WINDOW_ROUNDS <= _round) {
+        _bw_samples.pop_front();
+    }
+    while (not _bw_samples.empty() and _bw_samples.back().bytes_per_second <= rate) {
+        _bw_samples.pop_back();
+    }
+    _bw_samples.push_back({_round, rate});
+}
+
+void BbrCongestionControl::_update_min_rtt(const AckSample &ack) {
+    _min_rtt_expired = _min_rtt_us != 0 and ack.now_us > _min_rtt_stamp_us + MIN_RTT_WINDOW_US;
+    if (ack.rtt_us != 0 and (_min_rtt_us == 0 or ack.rtt_us <= _min_rtt_us or _min_rtt_expired)) {
+        _min_rtt_us = ack.rtt_us;
+        _min_rtt_stamp_us = ack.now_us;
+    }
+}
+
+void BbrCongestionControl::_enter_probe_bw(const uint64_t now_us) {
+    _mode = Mode::ProbeBW;
+    _cycle_index = 2;
+    _cycle_stamp_us = now_us;
+}
+
+void BbrCongestionControl::_update_mode(const AckSample &ack) {
+    // the pipe is full once three rounds in a row fail to raise the bandwidth by a quarter
+    if (not _filled_pipe and _round_start and not ack.app_limited) {
+        if (double(bandwidth()) >= double(_full_bw) * FULL_BW_GROWTH) {
+            _full_bw = bandwidth();
+            _full_bw_count = 0;
+        } else if (++_full_bw_count >= FULL_BW_ROUNDS) {
+            _filled_pipe = true;
+        }
+    }
+    if (_mode == Mode::Startup and _filled_pipe) {
+        _mode = Mode::Drain;
+    }
+    if (_mode == Mode::Drain and ack.bytes_in_flight <= _bdp(1)) {
+        _enter_probe_bw(ack.now_us);
+    }
+
+    // each gain lasts one RTprop; the drain phase ends early once the queue is gone
+    if (_mode == Mode::ProbeBW) {
+        const bool elapsed = ack.now_us - _cycle_stamp_us > _min_rtt_us;
+        const double gain = PACING_GAINS.at(_cycle_index);
+        if (elapsed or (gain < 1 and ack.bytes_in_flight <= _bdp(1))) {
+            _cycle_index = (_cycle_index + 1) % PACING_GAINS.size();
+            _cycle_stamp_us = ack.now_us;
+        }
+    }
+
+    if (_mode != Mode::ProbeRTT and _min_rtt_expired) {
+        _mode = Mode::ProbeRTT;
+        _prior_cwnd = max(_prior_cwnd, _cwnd);
+        _probe_rtt_done_us.reset();
+    }
+    if (_mode == Mode::ProbeRTT) {
+        if (not _probe_rtt_done_us.has_value() and ack.bytes_in_flight <= MIN_CWND_SEGMENTS * _mss) {
+            _probe_rtt_done_us = ack.now_us + PROBE_RTT_DURATION_US;
+        } else if (_probe_rtt_done_us.has_value() and ack.now_us >= _probe_rtt_done_us.value()) {
+            _min_rtt_stamp_us = ack.now_us;
+            _cwnd = max(_cwnd, _prior_cwnd);
+            _prior_cwnd = 0;
+            if (_filled_pipe) {
+                _enter_probe_bw(ack.now_us);
+            } else {
+                _mode = Mode::Startup;
+            }
+        }
+    }
+}
+
+//! \details Once the pipe is full the window tracks its target (two BDPs); in Startup it only
+//! grows, by the bytes acked (doubling every round, like slow start).
+void BbrCongestionControl::_update_cwnd(const AckSample &ack) {
+    const uint64_t min_cwnd = MIN_CWND_SEGMENTS * _mss;
+    if (_mode == Mode::ProbeRTT) {
+        _cwnd = min(_cwnd, min_cwnd);
+        return;
+    }
+    if (_in_recovery) {
+        return;
+    }
+    const uint64_t target = _bdp(_filled_pipe ? CWND_GAIN : HIGH_GAIN);
+    if (_filled_pipe) {
+        _cwnd = min(_cwnd + ack.bytes_acked, target);
+    } else if (_cwnd < target or bandwidth() == 0) {
+        _cwnd += ack.bytes_acked;
+    }
+    _cwnd = max(_cwnd, min_cwnd);
+}
+
+double BbrCongestionControl::_pacing_gain() const {
+    switch (_mode) {
+        case Mode::Startup:
+            return HIGH_GAIN;
+        case Mode::Drain:
+            return 1 / HIGH_GAIN;
+        case Mode::ProbeBW:
+            return PACING_GAINS.at(_cycle_index);
+        case Mode::ProbeRTT:
+            break;
+    }
+    return 1;
+}
+
+uint64_t BbrCongestionControl::_bdp(const double gain) const {
+    if (bandwidth() == 0 or _min_rtt_us == 0) {
+        return _initial_cwnd;
+    }
+    const auto bdp = uint64_t(gain * double(bandwidth()) * double(_min_rtt_us) / 1e6);
+    return max(bdp, MIN_CWND_SEGMENTS * _mss);
+}
+
+uint64_t BbrCongestionControl::on_ack(const AckSample &ack) {
+    _update_round(ack);
+    _update_bandwidth(ack);
+    _update_min_rtt(ack);
+    _update_mode(ack);
+    if (_in_recovery and ack.ackno >= _recovery_point) {
+        _in_recovery = false;
+        _cwnd = max(_cwnd, _prior_cwnd);
+        _prior_cwnd = 0;
+    }
+    _update_cwnd(ack);
+    return _cwnd;
+}
+
+//! \details Packet conservation: until the loss is repaired, only one new segment goes out for
+//! each one that leaves the network. The model is untouched.
+uint64_t BbrCongestionControl::on_loss(const uint64_t, const uint64_t bytes_in_flight, const uint64_t next_seqno) {
+    if (not _in_recovery) {
+        _prior_cwnd = max(_prior_cwnd, _cwnd);
+        _in_recovery = true;
+        _recovery_point = next_seqno;
+        _cwnd = max(bytes_in_flight + _mss, MIN_CWND_SEGMENTS * _mss);
+    }
+    return _cwnd;
+}
+
+//! \details The window restarts from one segment and is rebuilt from the model as acks arrive.
+uint64_t BbrCongestionControl::on_timeout(const uint64_t, const uint64_t) {
+    _in_recovery = false;
+    _prior_cwnd = 0;
+    _cwnd = _mss;
+    return _cwnd;
+}
+
+void BbrCongestionControl::set_mss(const uint64_t mss) {
+    _initial_cwnd = _initial_cwnd * mss / _mss;
+    _cwnd = max(_cwnd * mss / _mss, MIN_CWND_SEGMENTS * mss);
+    _prior_cwnd = _prior_cwnd * mss / _mss;
+    _mss = mss;
+}
+
+//! \details Until the pipe is full, the rate never drops below the initial window paced over one
+//! RTprop at Startup's gain, so that the first (tiny, handshake-sized) samples don't stall Startup.
+//! Without an RTT sample there is no pacing.
+uint64_t BbrCongestionControl::pacing_rate() const {
+    const auto model_rate = uint64_t(_pacing_gain() * double(bandwidth()));
+    if (_filled_pipe or _min_rtt_us == 0) {
+        return model_rate;
+    }
+    return max(model_rate, uint64_t(HIGH_GAIN * double(_initial_cwnd) * 1e6 / double(_min_rtt_us)));
+}
+
+unique_ptr<CongestionControl> make_congestion_control(const TCPConfig &cfg) {
+    const uint64_t mss = cfg.mss.value_or(TCPConfig::MAX_PAYLOAD_SIZE);
+    const uint64_t initial_cwnd = cfg.initial_cwnd_segments * mss;
+    switch (cfg.congestion_control) {
+        case CongestionControlAlgorithm::None:
+            return nullptr;
+        case CongestionControlAlgorithm::Reno:
+            return make_unique<RenoCongestionControl>(mss, initial_cwnd);
+        case CongestionControlAlgorithm::NewReno:
+            return make_unique<NewRenoCongestionControl>(mss, initial_cwnd);
+        case CongestionControlAlgorithm::Cubic:
+            return make_unique<CubicCongestionControl>(mss, initial_cwnd);
+        case CongestionControlAlgorithm::Bbr:
+            return make_unique<BbrCongestionControl>(mss, initial_cwnd);
+    }
+    throw runtime_error("make_congestion_control: unknown algorithm");
+}
+
+CongestionControlAlgorithm congestion_control_algorithm(const string &name) {
+    if (name == "none") {
+        return CongestionControlAlgorithm::None;
+    }
+    if (name == "reno") {
+        return CongestionControlAlgorithm::Reno;
+    }
+    if (name == "newreno") {
+        return CongestionControlAlgorithm::NewReno;
+    }
+    if (name == "cubic") {
+        return CongestionControlAlgorithm::Cubic;
+    }
+    if (name == "bbr") {
+        return CongestionControlAlgorithm::Bbr;
+    }
+    throw invalid_argument("unknown congestion-control algorithm: " + name);
+}
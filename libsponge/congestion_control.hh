@@ -0,0 +1,312 @@
+#ifndef SPONGE_LIBSPONGE_CONGESTION_CONTROL_HH
+#define SPONGE_LIBSPONGE_CONGESTION_CONTROL_HH
+
+#include "tcp_config.hh"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+
+//! What the TCPSender tells its CongestionControl about an acknowledgment of new data
+struct AckSample {
+    uint64_t now_us = 0;           //!< Sender's time (sum of its ticks), in microseconds
+    uint64_t ackno = 0;            //!< Absolute ackno carried by the acknowledgment
+    uint64_t bytes_acked = 0;      //!< Sequence numbers newly acknowledged
+    uint64_t bytes_in_flight = 0;  //!< Sequence numbers still outstanding afterwards
+    uint64_t rtt_us = 0;           //!< RTT sample from a segment sent only once (0 if none, per Karn's algorithm)
+    uint64_t next_seqno = 0;       //!< Absolute seqno of the next new byte the sender will send
+
+    //! \name Delivery-rate sample (draft-cheng-iccrg-delivery-rate-estimation)
+    //! The rate is `delivered` / `interval_us`; `interval_us` is 0 when the ack gives no sample.
+    //!@{
+    uint64_t delivered = 0;    //!< Bytes delivered between the sending of the newest acked segment and this ack
+    uint64_t interval_us = 0;  //!< Over this interval (the longer of its send and ack phases)
+    bool app_limited = false;  //!< Was the sender short of data during the interval? (then the rate is a lower bound)
+    //!@}
+};
+
+//! \brief A congestion-control algorithm, as seen by the TCPSender
+//! \details The TCPSender calls one hook per congestion event, and each hook returns the
+//! new congestion window. The sender never has more than min(cwnd, receiver's window)
+//! sequence numbers outstanding. All quantities are in bytes (sequence numbers).
+class CongestionControl {
+  public:
+    //! Duplicate ACKs that signal a loss (and trigger a fast retransmit)
+    static constexpr unsigned DUPACK_THRESHOLD = 3;
+
+    //! Name of the algorithm, for logs and benchmarks
+    virtual const char *name() const = 0;
+
+    //! \brief New data was acknowledged
+    //! \returns the congestion window
+    virtual uint64_t on_ack(const AckSample &ack) = 0;
+
+    //! \brief A segment was inferred lost from duplicate ACKs (and has been fast-retransmitted)
+    //! \param[in] next_seqno is the absolute seqno of the next new byte; loss recovery ends once it is acked
+    //! \returns the congestion window
+    virtual uint64_t on_loss(const uint64_t now_us, const uint64_t bytes_in_flight, const uint64_t next_seqno) = 0;
+
+    //! \brief The retransmission timer expired
+    //! \returns the congestion window
+    virtual uint64_t on_timeout(const uint64_t now_us, const uint64_t bytes_in_flight) = 0;
+
+    //! \brief An ACK echoed a congestion mark ([ECN](\ref rfc::rfc3168) ECE), outside loss recovery
+    //! \details The sender calls this at most once per window of data; nothing needs retransmitting.
+    //! \returns the congestion window
+    virtual uint64_t on_ecn(const uint64_t, const uint64_t) { return cwnd(); }
+
+    //! \brief Another duplicate ACK arrived during loss recovery (a segment has left the network)
+    //! \returns the congestion window
+    virtual uint64_t on_dupack(const uint64_t) { return cwnd(); }
+
+    //! \brief The sender maximum segment size changed (e.g. to the smaller MSS the peer advertised)
+    //! \details The windows keep their size in segments.
+    virtual void set_mss(const uint64_t mss) = 0;
+
+    //! Current congestion window
+    virtual uint64_t cwnd() const = 0;
+
+    //! Current slow-start threshold
+    virtual uint64_t ssthresh() const = 0;
+
+    //! \brief Is the algorithm in loss recovery?
+    //! \details While this is true after on_ack(), the ack was a "partial" ack (it left the
+    //! recovery point outstanding), and the sender retransmits the next unacknowledged segment.
+    virtual bool in_recovery() const { return false; }
+
+    //! \brief Rate at which the sender should space out new segments, in bytes per second
+    //! \details 0 means no pacing: the sender sends as much of the window as it can at once.
+    virtual uint64_t pacing_rate() const { return 0; }
+
+    virtual ~CongestionControl() = default;
+};
+
+//! \brief Reno (RFC 5681): slow start, congestion avoidance, and a halving on every fast retransmit
+//! \details Fast recovery inflates the halved window by the three segments whose duplicate ACKs
+//! triggered the retransmission, and by one more for each further duplicate ACK, so that new
+//! segments keep the ACK clock going while the loss is repaired. Any acknowledgment of new data
+//! deflates the window back to ssthresh and ends loss recovery, so several losses in one window
+//! halve the window several times.
+class RenoCongestionControl : public CongestionControl {
+  protected:
+    uint64_t _mss;                                             //!< Sender maximum segment size
+    uint64_t _cwnd;                                            //!< Congestion window
+    uint64_t _ssthresh{std::numeric_limits<uint64_t>::max()};  //!< Slow-start threshold
+    uint64_t _bytes_acked_in_ca{0};                            //!< Bytes acked since cwnd grew (congestion avoidance)
+    bool _in_recovery{false};                                  //!< Between a fast retransmit and the end of recovery
+    uint64_t _recovery_point{0};                               //!< next_seqno when recovery began
+
+    //! \brief Was the sender using the window it had when `ack` arrived?
+    //! \details The window only grows when it is the limit (RFC 7661); a flow held back by the
+    //! receiver's window or by the application would otherwise build up an untested window.
+    bool _cwnd_limited(const AckSample &ack) const;
+
+    //! Grow the window for newly acknowledged bytes (appropriate byte counting, RFC 3465)
+    virtual void _grow(const AckSample &ack);
+
+    //! Set ssthresh after a congestion event: half the flight size, but at least two segments
+    virtual void _reduce_ssthresh(const uint64_t bytes_in_flight);
+
+  public:
+    //! \param[in] mss is the sender maximum segment size
+    //! \param[in] initial_cwnd is the initial window, in bytes
+    RenoCongestionControl(const uint64_t mss, const uint64_t initial_cwnd) : _mss(mss), _cwnd(initial_cwnd) {}
+
+    const char *name() const override { return "reno"; }
+    uint64_t on_ack(const AckSample &ack) override;
+    uint64_t on_loss(const uint64_t now_us, const uint64_t bytes_in_flight, const uint64_t next_seqno) override;
+    uint64_t on_timeout(const uint64_t now_us, const uint64_t bytes_in_flight) override;
+    uint64_t on_ecn(const uint64_t now_us, const uint64_t bytes_in_flight) override;
+    uint64_t on_dupack(const uint64_t now_us) override;
+    void set_mss(const uint64_t mss) override;
+    uint64_t cwnd() const override { return _cwnd; }
+    uint64_t ssthresh() const override { return _ssthresh; }
+    bool in_recovery() const override { return _in_recovery; }
+};
+
+//! \brief NewReno (RFC 6582): Reno, but loss recovery lasts until everything sent before the loss is acked
+//! \details A partial acknowledgment keeps the sender in recovery (it retransmits the next hole
+//! instead, and the inflated window shrinks by the data acked), so the window is halved at most
+//! once per window of data.
+class NewRenoCongestionControl : public RenoCongestionControl {
+  public:
+    using RenoCongestionControl::RenoCongestionControl;
+
+    const char *name() const override { return "newreno"; }
+    uint64_t on_ack(const AckSample &ack) override;
+};
+
+//! \brief CUBIC (RFC 9438): window growth as a cubic function of the time since the last congestion event
+//! \details After a reduction, the window climbs quickly back towards the size at which the loss
+//! happened (`W_max`), flattens out around it, and then probes beyond it ever faster. Growth
+//! depends on real time rather than on the number of round trips, so long-RTT flows recover as
+//! fast as short ones. CUBIC also
+//!
+//! - never grows slower than an estimate of what Reno would achieve (the "Reno-friendly region"),
+//! - lowers `W_max` further when losses come before the window regains its old maximum (fast
+//!   convergence), so that established flows make room for new ones, and
+//! - leaves slow start early when the RTT of a round rises clearly above the previous round's
+//!   (HyStart++, RFC 9406, without its conservative-slow-start phase).
+//!
+//! Loss recovery is NewReno's.
+class CubicCongestionControl : public NewRenoCongestionControl {
+  public:
+    static constexpr double C = 0.4;                              //!< Cubic scaling constant (segments/s^3)
+    static constexpr double BETA = 0.7;                           //!< Multiplicative decrease factor
+    static constexpr double ALPHA = 3 * (1 - BETA) / (1 + BETA);  //!< Reno-friendly additive increase
+    static constexpr unsigned HYSTART_MIN_SAMPLES = 8;            //!< RTT samples per round before HyStart acts
+    static constexpr uint64_t HYSTART_MIN_ETA_US = 4000;          //!< Smallest RTT increase that ends slow start
+    static constexpr uint64_t HYSTART_MAX_ETA_US = 16000;         //!< Largest RTT increase needed to end slow start
+
+  private:
+    double _w_max{0};                           //!< Window (in segments) before the last reduction
+    double _k{0};                               //!< Seconds the cubic function takes to climb back to _w_max
+    double _w_est{0};                           //!< Reno-friendly window estimate (segments)
+    double _carry{0};                           //!< Fractional bytes of window growth not yet applied
+    std::optional<uint64_t> _epoch_start_us{};  //!< Start of the current growth epoch
+    uint64_t _min_rtt_us{0};                    //!< Smallest RTT sample seen (0: none yet)
+
+    uint64_t _round_end{0};                                                 //!< HyStart: ackno that ends the round
+    uint64_t _last_round_min_rtt_us{std::numeric_limits<uint64_t>::max()};  //!< HyStart: previous round's min RTT
+    uint64_t _round_min_rtt_us{std::numeric_limits<uint64_t>::max()};       //!< HyStart: this round's min RTT
+    unsigned _round_samples{0};                                             //!< HyStart: RTT samples this round
+
+    //! HyStart++ delay-increase check; may end slow start by setting ssthresh to cwnd
+    void _hystart(const AckSample &ack);
+
+  protected:
+    void _grow(const AckSample &ack) override;
+    void _reduce_ssthresh(const uint64_t bytes_in_flight) override;
+
+  public:
+    using NewRenoCongestionControl::NewRenoCongestionControl;
+
+    const char *name() const override { return "cubic"; }
+
+    //! \name Instrumentation
+    //!@{
+    double w_max() const { return _w_max; }
+    double k() const { return _k; }
+    //!@}
+};
+
+//! \brief BBR (v1): a model of the path's bottleneck bandwidth and round-trip propagation time
+//! \details Instead of reacting to losses, BBR keeps a windowed maximum of the delivery rate
+//! (the bottleneck bandwidth, BtlBw) and a windowed minimum of the RTT (RTprop), and sends at
+//! about BtlBw with about one BDP (BtlBw x RTprop) in flight, which fills the pipe without
+//! building a queue. The sender paces new segments at pacing_rate(); the window (two BDPs) is
+//! only a safety cap. The phases are
+//!
+//! - Startup: double the sending rate every round trip until the bandwidth stops growing,
+//! - Drain: send below the estimate for a round to empty the queue Startup built,
+//! - ProbeBW: cycle the pacing gain (1.25, 0.75, then six rounds of 1) to probe for more
+//!   bandwidth and drain what the probe queued, and
+//! - ProbeRTT: if RTprop hasn't been refreshed for ten seconds, shrink the window to four
+//!   segments for 200 ms so the queue empties and a fresh minimum RTT can be seen.
+//!
+//! A loss only holds the window at the flight size until the lost data is repaired (loss
+//! recovery is NewReno's, so that partial acks retransmit the next hole). ECN marks are ignored.
+class BbrCongestionControl : public CongestionControl {
+  public:
+    //! Phases of the BBR state machine
+    enum class Mode { Startup, Drain, ProbeBW, ProbeRTT };
+
+    static constexpr double HIGH_GAIN = 2.885;                  //!< Startup gain, 2/ln(2)
+    static constexpr double CWND_GAIN = 2;                      //!< Window, in BDPs, outside Startup
+    static constexpr unsigned BW_WINDOW_ROUNDS = 10;            //!< Bandwidth filter length, in round trips
+    static constexpr uint64_t MIN_RTT_WINDOW_US = 10'000'000;   //!< RTprop filter length
+    static constexpr uint64_t PROBE_RTT_DURATION_US = 200'000;  //!< Time spent in ProbeRTT
+    static constexpr unsigned FULL_BW_ROUNDS = 3;               //!< Rounds without growth that end Startup
+    static constexpr double FULL_BW_GROWTH = 1.25;              //!< Growth that counts as "still growing"
+    static constexpr unsigned MIN_CWND_SEGMENTS = 4;            //!< Smallest window, in segments
+
+    //! ProbeBW pacing-gain cycle; each gain lasts one RTprop
+    static constexpr std::array<double, 8> PACING_GAINS{1.25, 0.75, 1, 1, 1, 1, 1, 1};
+
+  private:
+    //! A delivery rate and the round trip it was measured in
+    struct BandwidthSample {
+        uint64_t round;             //!< Round-trip count when the sample was taken
+        uint64_t bytes_per_second;  //!< The rate
+    };
+
+    uint64_t _mss;                                 //!< Sender maximum segment size
+    uint64_t _initial_cwnd;                        //!< Window until there is a BDP estimate
+    uint64_t _cwnd;                                //!< Congestion window
+    Mode _mode{Mode::Startup};                     //!< Current phase
+    std::deque<BandwidthSample> _bw_samples{};     //!< Max filter: decreasing rates, oldest first
+    uint64_t _min_rtt_us{0};                       //!< RTprop estimate (0: no sample yet)
+    uint64_t _min_rtt_stamp_us{0};                 //!< When _min_rtt_us was last set
+    bool _min_rtt_expired{false};                  //!< Had RTprop gone MIN_RTT_WINDOW_US without a refresh?
+    uint64_t _round{0};                            //!< Round trips so far
+    uint64_t _round_end{0};                        //!< ackno that ends the current round
+    bool _round_start{false};                      //!< Did the last ack start a new round?
+    uint64_t _full_bw{0};                          //!< Startup: best bandwidth so far
+    unsigned _full_bw_count{0};                    //!< Startup: rounds without enough growth
+    bool _filled_pipe{false};                      //!< Has Startup found the bottleneck's rate?
+    size_t _cycle_index{0};                        //!< ProbeBW: position in PACING_GAINS
+    uint64_t _cycle_stamp_us{0};                   //!< ProbeBW: when the current gain began
+    std::optional<uint64_t> _probe_rtt_done_us{};  //!< ProbeRTT: when it may end (once the flight is small)
+    uint64_t _prior_cwnd{0};                       //!< Window to restore after recovery or ProbeRTT
+    bool _in_recovery{false};                      //!< Between a fast retransmit and the end of recovery
+    uint64_t _recovery_point{0};                   //!< next_seqno when recovery began
+
+    //! Count round trips: a round ends when the data sent at its start is acked
+    void _update_round(const AckSample &ack);
+    //! Feed the delivery-rate sample to the BtlBw max filter
+    void _update_bandwidth(const AckSample &ack);
+    //! Feed the RTT sample to the RTprop min filter
+    void _update_min_rtt(const AckSample &ack);
+    //! Move between Startup, Drain, ProbeBW and ProbeRTT
+    void _update_mode(const AckSample &ack);
+    //! Move the window towards its target
+    void _update_cwnd(const AckSample &ack);
+    //! Start ProbeBW (with the cycle just past its probe and drain gains)
+    void _enter_probe_bw(const uint64_t now_us);
+
+    //! Pacing gain of the current phase
+    double _pacing_gain() const;
+
+    //! Bandwidth-delay product times `gain`, in bytes (at least MIN_CWND_SEGMENTS segments)
+    uint64_t _bdp(const double gain) const;
+
+  public:
+    //! \param[in] mss is the sender maximum segment size
+    //! \param[in] initial_cwnd is the initial window, in bytes
+    BbrCongestionControl(const uint64_t mss, const uint64_t initial_cwnd)
+        : _mss(mss), _initial_cwnd(initial_cwnd), _cwnd(initial_cwnd) {}
+
+    const char *name() const override { return "bbr"; }
+    uint64_t on_ack(const AckSample &ack) override;
+    uint64_t on_loss(const uint64_t now_us, const uint64_t bytes_in_flight, const uint64_t next_seqno) override;
+    uint64_t on_timeout(const uint64_t now_us, const uint64_t bytes_in_flight) override;
+    void set_mss(const uint64_t mss) override;
+    uint64_t cwnd() const override { return _cwnd; }
+    //! BBR has no slow-start threshold; Startup ends when the bandwidth estimate stops growing
+    uint64_t ssthresh() const override { return std::numeric_limits<uint64_t>::max(); }
+    bool in_recovery() const override { return _in_recovery; }
+    uint64_t pacing_rate() const override;
+
+    //! \name Instrumentation
+    //!@{
+    Mode mode() const { return _mode; }
+    //! Bottleneck bandwidth estimate, in bytes per second (0: no sample yet)
+    uint64_t bandwidth() const { return _bw_samples.empty() ? 0 : _bw_samples.front().bytes_per_second; }
+    //! Round-trip propagation time estimate, in microseconds (0: no sample yet)
+    uint64_t min_rtt_us() const { return _min_rtt_us; }
+    //!@}
+};
+
+//! The CongestionControl selected by `cfg.congestion_control` (nullptr for CongestionControlAlgorithm::None)
+std::unique_ptr<CongestionControl> make_congestion_control(const TCPConfig &cfg);
+
+//! \brief Look up an algorithm by name ("none", "reno", "newreno", "cubic" or "bbr")
+//! \note Throws std::invalid_argument for any other name
+CongestionControlAlgorithm congestion_control_algorithm(const std::string &name);
+
+#endif  // SPONGE_LIBSPONGE_CONGESTION_CONTROL_HH
@@ -144,11 +144,11 @@ optional<InternetDatagram> NetworkInterface::recv_frame(const EthernetFrame &fra
     return std::nullopt;
 }
 
-//! \param[in] ms_since_last_tick the number of milliseconds since the last call to this method
-void NetworkInterface::tick(const size_t ms_since_last_tick) {
+//! \param[in] us_since_last_tick the number of microseconds since the last call to this method
+void NetworkInterface::tick_us(const uint64_t us_since_last_tick) {
     std::map<uint32_t, std::pair<EthernetAddress, size_t>>::iterator iter_ip_mac_map = _ip_mac_map.begin();
     while (iter_ip_mac_map != _ip_mac_map.end()) {
-        iter_ip_mac_map->second.second += ms_since_last_tick;
+        iter_ip_mac_map->second.second += us_since_last_tick;
         if (iter_ip_mac_map->second.second >= ip_mac_map_maintain_time)
             iter_ip_mac_map = _ip_mac_map.erase(iter_ip_mac_map);
         else
@@ -156,7 +156,7 @@ void NetworkInterface::tick(const size_t ms_since_last_tick) {
     }
     std::map<uint32_t, size_t>::iterator iter_arp_time_map = _arp_time_map.begin();
     while (iter_arp_time_map != _arp_time_map.end()) {
-        iter_arp_time_map->second += ms_since_last_tick;
+        iter_arp_time_map->second += us_since_last_tick;
         iter_arp_time_map++;
     }
     return;
@@ -57,11 +57,11 @@ class NetworkInterface {
     // 能否发送目的 ip 地址为 next_hop_ip 的 ARP
     bool _arp_can_send(const uint32_t next_hop_ip);
 
-    // 常量，下一个相同 ARP 发送需要等待的时间，单位 ms
-    static constexpr size_t ARP_RETRANSMISSION_TIME = 5000;
+    // 常量，下一个相同 ARP 发送需要等待的时间，单位 us
+    static constexpr size_t ARP_RETRANSMISSION_TIME = 5000 * 1000;
 
-    // 常量，某一 ip mac 映射保留的时间，单位 ms
-    static constexpr size_t ip_mac_map_maintain_time = 30000;
+    // 常量，某一 ip mac 映射保留的时间，单位 us
+    static constexpr size_t ip_mac_map_maintain_time = 30000 * 1000;
 
   public:
     //! \brief Construct a network interface with given Ethernet (network-access-layer) and IP (internet-layer) addresses
@@ -84,7 +84,10 @@ class NetworkInterface {
     std::optional<InternetDatagram> recv_frame(const EthernetFrame &frame);
 
     //! \brief Called periodically when time elapses
-    void tick(const size_t ms_since_last_tick);
+    void tick(const size_t ms_since_last_tick) { tick_us(uint64_t(ms_since_last_tick) * 1000); }
+
+    //! \brief Called periodically when time elapses, with microsecond resolution
+    void tick_us(const uint64_t us_since_last_tick);
 };
 
 #endif  // SPONGE_LIBSPONGE_NETWORK_INTERFACE_HH
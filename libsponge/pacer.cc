@@ -0,0 +1,17 @@
+#include "pacer.hh"
+
+#include <algorithm>
+
+using namespace std;
+
+uint64_t Pacer::wait_us(const uint64_t now_us) const { return may_send(now_us) ? 0 : _next_send_us - now_us; }
+
+//! \details An idle sender's schedule is pulled forward to `now_us` minus the time the burst
+//! allowance (less this segment) takes at the rate, so that the first `burst` bytes go out at once.
+void Pacer::on_send(const uint64_t now_us, const size_t bytes, const uint64_t catch_up_us) {
+    if (_rate == 0) {
+        return;
+    }
+    const uint64_t credit_us = max(catch_up_us, (_burst > bytes ? _burst - bytes : 0) * 1'000'000 / _rate);
+    _next_send_us = max(_next_send_us, now_us - min(now_us, credit_us)) + bytes * 1'000'000 / _rate;
+}
@@ -0,0 +1,45 @@
+#ifndef SPONGE_LIBSPONGE_PACER_HH
+#define SPONGE_LIBSPONGE_PACER_HH
+
+#include <cstddef>
+#include <cstdint>
+
+//! \brief Release schedule that spaces segments out at a target rate
+//! \details The Pacer keeps the earliest time at which the next segment may leave. Each segment
+//! sent pushes that time back by its transmission time at the rate (an "earliest departure
+//! time" schedule, equivalent to a token bucket). A sender that was idle may send `burst` bytes
+//! back to back; after that, segments leave at the rate. A rate of 0 turns pacing off.
+class Pacer {
+  private:
+    uint64_t _rate;             //!< Bytes per second (0: no pacing)
+    size_t _burst;              //!< Bytes that may leave back to back after an idle period
+    uint64_t _next_send_us{0};  //!< Earliest time for the next segment
+
+  public:
+    //! \param[in] rate is the target rate, in bytes per second (0: no pacing)
+    //! \param[in] burst is the number of bytes that may be sent back to back after an idle period
+    explicit Pacer(const uint64_t rate = 0, const size_t burst = 0) : _rate(rate), _burst(burst) {}
+
+    //! Change the rate; the schedule of the segment already sent is kept
+    void set_rate(const uint64_t rate) { _rate = rate; }
+
+    //! \name Accessors
+    //!@{
+    uint64_t rate() const { return _rate; }
+    size_t burst() const { return _burst; }
+    bool enabled() const { return _rate != 0; }
+    //!@}
+
+    //! May a segment leave at `now_us`?
+    bool may_send(const uint64_t now_us) const { return _rate == 0 or now_us >= _next_send_us; }
+
+    //! Microseconds from `now_us` until a segment may leave (0 if one may leave now)
+    uint64_t wait_us(const uint64_t now_us) const;
+
+    //! \brief Account for a segment of `bytes` that left at `now_us`
+    //! \param[in] catch_up_us lets the schedule run this far behind the clock even beyond the
+    //! burst allowance (for a caller whose ticks are coarser than a segment's transmission time)
+    void on_send(const uint64_t now_us, const size_t bytes, const uint64_t catch_up_us = 0);
+};
+
+#endif  // SPONGE_LIBSPONGE_PACER_HH
@@ -0,0 +1,38 @@
+#include "pmtu_search.hh"
+
+#include <algorithm>
+
+using namespace std;
+
+PmtuSearch::PmtuSearch(const size_t base, const size_t max) : _low(min(base, max)), _high(max) {}
+
+optional<size_t> PmtuSearch::probe_size() const {
+    if (_high < _low + SEARCH_GRANULARITY) {
+        return {};
+    }
+    return _low + (_high - _low + 1) / 2;
+}
+
+//! \details A probe of a size that is no longer in the search range (an old one) is ignored.
+void PmtuSearch::on_probe_acked(const size_t size) {
+    if (size > _low and size <= _high) {
+        _low = size;
+        _failures = 0;
+    }
+}
+
+void PmtuSearch::on_probe_lost(const size_t size) {
+    if (size <= _low or size > _high) {
+        return;
+    }
+    if (++_failures >= MAX_PROBES) {
+        _high = size - 1;
+        _failures = 0;
+    }
+}
+
+void PmtuSearch::set_max(const size_t max) {
+    _low = min(_low, max);
+    _high = max;
+    _failures = 0;
+}
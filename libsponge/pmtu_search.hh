@@ -0,0 +1,48 @@
+#ifndef SPONGE_LIBSPONGE_PMTU_SEARCH_HH
+#define SPONGE_LIBSPONGE_PMTU_SEARCH_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+//! \brief Packetization-layer path MTU discovery (RFC 4821): a search for the largest segment the path carries
+//! \details Sizes are payload bytes. The search keeps the largest size known to get through (the
+//! segment size to use) and the largest that might. The sender tries the size half way between
+//! them with a single probe segment: an acked probe raises the first bound to its size,
+//! MAX_PROBES lost probes of one size lower the second bound below it. The search is over once
+//! the bounds are within SEARCH_GRANULARITY of each other.
+class PmtuSearch {
+  private:
+    size_t _low;            //!< Largest size known to get through
+    size_t _high;           //!< Largest size that might get through
+    unsigned _failures{0};  //!< Probes of the size probe_size() that were lost
+
+  public:
+    //! Lost probes of one size that show that the size doesn't get through
+    static constexpr unsigned MAX_PROBES = 3;
+
+    //! The search stops when the bounds are this close
+    static constexpr size_t SEARCH_GRANULARITY = 32;
+
+    //! \param[in] base is the size to start from (assumed to get through)
+    //! \param[in] max is the largest size to try (the MSS)
+    PmtuSearch(const size_t base, const size_t max);
+
+    //! The segment size to use: the largest known to get through
+    size_t mss() const { return _low; }
+
+    //! Size of the next probe (empty once the search is over)
+    std::optional<size_t> probe_size() const;
+
+    //! A probe of `size` bytes was acknowledged
+    void on_probe_acked(const size_t size);
+
+    //! A probe of `size` bytes was lost
+    void on_probe_lost(const size_t size);
+
+    //! \brief Change the largest size to try (e.g. to the MSS the peer advertised)
+    //! \details The search goes on between the current size (or `max`, if smaller) and `max`.
+    void set_max(const size_t max);
+};
+
+#endif  // SPONGE_LIBSPONGE_PMTU_SEARCH_HH
@@ -1,5 +1,7 @@
 #include "stream_reassembler.hh"
 
+#include <algorithm>
+
 // Dummy implementation of a stream reassembler.
 
 // For Lab 1, please replace with a real implementation that passes the
@@ -87,6 +89,11 @@ void StreamReassembler::push_to_aux(const string &data, const size_t index, cons
     }
 }
 
+void StreamReassembler::grow_capacity(const size_t capacity) {
+    _capacity = max(_capacity, capacity);
+    _output.grow_capacity(capacity);
+}
+
 //! \details This function accepts a substring (aka a segment) of bytes,
 //! possibly out-of-order, from the logical stream, and assembles any newly
 //! contiguous substrings and writes them into the output stream in order.
@@ -140,6 +147,16 @@ size_t StreamReassembler::unassembled_bytes() const {
     return total;
 }
 
+vector<pair<uint64_t, uint64_t>> StreamReassembler::unassembled_blocks() const {
+    vector<pair<uint64_t, uint64_t>> blocks;
+    for (const substr &item : _aux_vec) {
+        const uint64_t end = item.index_start + item.s.size();
+        if (end > _index)
+            blocks.emplace_back(max<uint64_t>(item.index_start, _index), end);
+    }
+    return blocks;
+}
+
 bool StreamReassembler::empty() const {
     if (_aux_vec.size() == 0)
         return true;
@@ -5,6 +5,7 @@
 
 #include <cstdint>
 #include <string>
+#include <utility>
 #include <vector>
 
 struct substr {
@@ -42,6 +43,13 @@ class StreamReassembler {
     //! \param eof the last byte of `data` will be the last byte in the entire stream
     void push_substring(const std::string &data, const uint64_t index, const bool eof);
 
+    //! \brief Write the next bytes of the stream, sharing `data`'s storage
+    //! \pre nothing is stored out of order (empty()), and the stream hasn't reached its end
+    void push_in_order(const Buffer &data) { _index += _output.write(data); }
+
+    //! \brief Raise the capacity to `capacity` bytes (it never shrinks)
+    void grow_capacity(const size_t capacity);
+
     //! \name Access the reassembled byte stream
     //!@{
     const ByteStream &stream_out() const { return _output; }  //两个 const 的含义分别是什么？
@@ -54,6 +62,10 @@ class StreamReassembler {
     //! should only be counted once for the purpose of this function.
     size_t unassembled_bytes() const;
 
+    //! \brief The contiguous runs of bytes stored but not yet reassembled, in stream order
+    //! \returns [index of the first byte, index just past the last byte) of each run
+    std::vector<std::pair<uint64_t, uint64_t>> unassembled_blocks() const;
+
     //! \brief Is the internal state empty (other than the output stream)?
     //! \returns `true` if no substrings are waiting to be assembled
     bool empty() const;
@@ -1,6 +1,10 @@
 #include "tcp_connection.hh"
 
+#include "ipv4_header.hh"
+
 #include <iostream>
+#include <limits>
+#include <utility>
 
 // Dummy implementation of a TCP connection
 
@@ -15,9 +19,167 @@ size_t TCPConnection::bytes_in_flight() const { return _sender.bytes_in_flight()
 
 size_t TCPConnection::unassembled_bytes() const { return _receiver.unassembled_bytes(); }
 
-size_t TCPConnection::time_since_last_segment_received() const { return _time - _segment_received_time; }
+uint64_t TCPConnection::time_since_last_segment_received_us() const { return _time - _segment_received_time; }
+
+uint8_t TCPConnection::_recv_window_scale() const {
+    return _cfg.window_scaling && _peer_window_scale ? _cfg.window_scale() : 0;
+}
+
+uint8_t TCPConnection::_send_window_scale() const {
+    return _cfg.window_scaling && _peer_window_scale ? *_peer_window_scale : 0;
+}
+
+//! \details Windows beyond what the field can express are advertised as 65535 (scaled) bytes.
+uint16_t TCPConnection::_advertised_window(const TCPSegment &seg) {
+    const size_t unscaled = _cfg.sws_avoidance ? _receiver.advertise_window(_sender.mss()) : _receiver.window_size();
+    const size_t window = unscaled >> (seg.header().syn ? 0 : _recv_window_scale());
+    return uint16_t(min<size_t>(window, numeric_limits<uint16_t>::max()));
+}
+
+void TCPConnection::_set_options(TCPSegment &seg) const {
+    TCPOptions &options = seg.header().options;
+    if (seg.header().syn) {
+        const bool answer = seg.header().ack;
+        options.mss = _cfg.mss;
+        if (_cfg.window_scaling && (!answer || _peer_window_scale))
+            options.window_scale = _cfg.window_scale();
+        options.sack_permitted = _cfg.sack && (!answer || _peer_sack);
+        if (_cfg.timestamps && (!answer || _peer_timestamps))
+            options.timestamps = TCPOptions::Timestamps{_ts_now(), answer ? _ts_recent : 0};
+        // RFC 3168 6.1.1: an ECN-setup SYN has ECE and CWR, an ECN-setup SYN/ACK only ECE
+        seg.header().ece = _cfg.ecn && (!answer || _peer_ecn);
+        seg.header().cwr = _cfg.ecn && !answer;
+        return;
+    }
+    if (_ecn_in_use() && seg.header().ack)
+        seg.header().ece = _receiver.ece();
+    if (_timestamps_in_use())
+        options.timestamps = TCPOptions::Timestamps{_ts_now(), _ts_recent};
+    if (_cfg.sack && _peer_sack && seg.header().ack)
+        options.sack = _receiver.sack_blocks();
+}
+
+//! \details The peer's SYN settles which options are in use and the MSS for our segments.
+void TCPConnection::_options_received(const TCPSegment &seg) {
+    const TCPOptions &options = seg.header().options;
+    if (seg.header().syn) {
+        _peer_sack = options.sack_permitted;
+        _peer_window_scale = options.window_scale;
+        _peer_timestamps = options.timestamps.has_value();
+        _peer_ecn = seg.header().ece && seg.header().cwr != seg.header().ack;
+        _sender.set_ecn(_ecn_in_use());
+        _sender.set_sack(_cfg.sack && _peer_sack);
+        const uint16_t max_payload = TCPConfig::MAX_PAYLOAD_SIZE;
+        _sender.set_mss(min(_cfg.mss.value_or(max_payload), options.mss.value_or(max_payload)));
+        if (_peer_timestamps)
+            _ts_recent = options.timestamps->value;
+        return;
+    }
+    if (!_timestamps_in_use() || !options.timestamps)
+        return;
+    const optional<WrappingInt32> ackno = _receiver.ackno();
+    // only a segment that doesn't start beyond our ackno updates the timestamp we echo, so that
+    // the echo of a repaired hole measures the retransmission, not the wait for it
+    if (ackno && seg.header().seqno - *ackno <= 0 && int32_t(options.timestamps->value - _ts_recent) >= 0)
+        _ts_recent = options.timestamps->value;
+    const uint64_t echo_rtt_us = uint64_t(_ts_now() - options.timestamps->echo_reply) * 1000;
+    if (seg.header().ack)
+        _sender.timestamp_echo_received(echo_rtt_us);
+    if (seg.payload().size() > 0 && options.timestamps->echo_reply != 0)
+        _receiver.rtt_sample(echo_rtt_us);
+}
+
+//! \details An ACK waits only for in-order data that fills no hole: the peer learns of losses,
+//! of its FIN, of our SYN and of congestion marks at once. Every second segment is acknowledged right
+//! away (RFC 1122 4.2.3.2).
+bool TCPConnection::_delay_ack(const TCPSegment &seg, const bool in_order) {
+    if (_cfg.quickack || !in_order || seg.header().syn || seg.header().fin || seg.ecn() == IPv4Header::ECN_CE)
+        return false;
+    if (++_segments_unacked >= 2)
+        return false;
+    if (!_ack_deadline_us)
+        _ack_deadline_us = _time + _cfg.delayed_ack_us;
+    return true;
+}
+
+void TCPConnection::_send(TCPSegment &seg) {
+    _set_options(seg);
+    if (seg.header().ack) {
+        _segments_unacked = 0;
+        _ack_deadline_us.reset();
+    }
+    _segments_out.push(move(seg));
+}
+
+void TCPConnection::_send_sender_segments() {
+    // 确保每次接收后 _sender 队列都清空
+    while (_sender.segments_out().size() != 0) {
+        TCPSegment seg_ = move(_sender.segments_out().front());
+        _sender.segments_out().pop();
+        if (seg_.header().fin) {
+            // 如果发送帧中包含 fin，则检视接收是否已经停止，如果确实如此，则完全结束 connection 不需要延时
+            if (_receiver.stream_out().input_ended())
+                _linger_after_streams_finish = false;
+            else
+                _linger_after_streams_finish = true;
+            _has_set_linger_eventually = true;
+        }
+        optional<WrappingInt32> ackno = _receiver.ackno();  // 自己需要的下一个字节的序号
+        seg_.header().ack = true;
+        seg_.header().ackno = *ackno;
+        seg_.header().win = _advertised_window(seg_);
+        _send(seg_);
+    }
+}
+
+//! \details The checks stand in for what the general path would find, so that skipping it changes
+//! nothing: the receiver would take in no data and no signal from a pure ACK (also after the peer's
+//! FIN), and the sender would find nothing new in the ack of an idle sender's peer.
+bool TCPConnection::_predicted(const TCPSegment &seg) const {
+    const TCPHeader &header = seg.header();
+    if (!_cfg.header_prediction || _listening || !header.ack || header.syn || header.fin || header.rst || header.ece ||
+        !header.options.sack.empty())
+        return false;
+    const optional<WrappingInt32> ackno = _receiver.ackno();
+    if (!ackno || header.seqno != *ackno || _receiver.unassembled_bytes() != 0)
+        return false;
+    // sequence numbers in flight that the ack leaves unacknowledged
+    const int32_t unacked = _sender.next_seqno() - header.ackno;
+    if (seg.payload().size() == 0)
+        return !header.cwr && seg.ecn() != IPv4Header::ECN_CE && unacked >= 0 &&
+               uint64_t(unacked) < _sender.bytes_in_flight();
+    const ByteStream &outbound = _sender.stream_in();
+    const bool fin_pending = outbound.eof() && _sender.next_seqno_absolute() < outbound.bytes_written() + 2;
+    return unacked == 0 && _sender.bytes_in_flight() == 0 && outbound.buffer_empty() && !fin_pending &&
+           (uint64_t(header.win) << _send_window_scale()) == _sender.window_size() && _receiver.in_order_data(seg);
+}
+
+//! \details The same steps as the general path, less those that would do nothing.
+void TCPConnection::_fast_path(const TCPSegment &seg) {
+    _options_received(seg);
+    _segment_received_time = _time;
+    if (seg.payload().size() == 0) {
+        _header_prediction.pure_acks++;
+        if (_receiver.stream_out().input_ended() && !_has_set_linger_eventually)
+            _linger_after_streams_finish = false;
+        _sender.ack_received(seg.header().ackno, uint64_t(seg.header().win) << _send_window_scale());
+        _sender.fill_window();
+    } else {
+        _header_prediction.pure_data++;
+        _receiver.in_order_data_received(seg);
+        _receiver.tune_window(_time);
+        if (!_delay_ack(seg, true))
+            _sender.send_empty_segment();
+    }
+    _send_sender_segments();
+}
 
 void TCPConnection::segment_received(const TCPSegment &seg) {
+    if (_predicted(seg)) {
+        _fast_path(seg);
+        return;
+    }
+    _header_prediction.misses++;
     if (seg.header().rst) {
         // sets both the inbound and outbound streams to the error state and kills the connection permanently
         _sender.stream_in().set_error();
@@ -28,44 +190,38 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
             // 如果在 _listening 状态下收到一个 syn，就跑出 _listening 状态
             _listening = false;
 
+        _options_received(seg);
+        const optional<WrappingInt32> ackno_before = _receiver.ackno();
+        const bool held_out_of_order = _receiver.unassembled_bytes() != 0;
         _receiver.segment_received(seg);
+        if (seg.payload().size() > 0)
+            _receiver.tune_window(_time);
+        const bool in_order = ackno_before && seg.header().seqno == *ackno_before && !held_out_of_order &&
+                              _receiver.unassembled_bytes() == 0;
         if (_receiver.stream_out().input_ended() && !_has_set_linger_eventually)
             _linger_after_streams_finish = false;
 
         _segment_received_time = _time;
 
-        if (seg.header().ack)
+        if (seg.header().ack) {
+            if (_cfg.sack && !seg.header().options.sack.empty())
+                _sender.sack_received(seg.header().options.sack);
             // 只有 ack 消息，携带 ackno 和 win （提出需求 -- 对方需要的下一个字节的序号和接收窗口大小）
-            _sender.ack_received(seg.header().ackno, seg.header().win);
+            const uint64_t window = uint64_t(seg.header().win) << (seg.header().syn ? 0 : _send_window_scale());
+            _sender.ack_received(seg.header().ackno, window, seg.length_in_sequence_space() == 0);
+            if (_ecn_in_use() && seg.header().ece && !seg.header().syn)
+                _sender.ecn_echo_received();
+        }
 
         if (!_listening)
             _sender.fill_window();
 
         // 这里要产生一个只是用于回应接收的空 seg
-        if (_sender.segments_out().size() == 0 && seg.length_in_sequence_space())
+        if (_sender.segments_out().size() == 0 && seg.length_in_sequence_space() && !_delay_ack(seg, in_order))
             // 没有需要发送的内容（没数据且没syn、fin），但对方的发送没有停止
             _sender.send_empty_segment();
 
-        // 确保每次接收后 _sender 队列都清空
-        while (_sender.segments_out().size() != 0) {
-            TCPSegment seg_ = _sender.segments_out().front();
-            _sender.segments_out().pop();
-            if (seg_.header().fin) {
-                // 如果发送帧中包含 fin，则检视接收是否已经停止，如果确实如此，则完全结束 connection 不需要延时
-                if (_receiver.stream_out().input_ended())
-                    _linger_after_streams_finish = false;
-                else
-                    _linger_after_streams_finish = true;
-                _has_set_linger_eventually = true;
-            }
-            optional<WrappingInt32> ackno = _receiver.ackno();  // 自己需要的下一个字节的序号
-            size_t win = _receiver.window_size();               // 自己接收窗口的大小
-            seg_.header().ack = true;
-            seg_.header().ackno = *ackno;
-            seg_.header().win = win;
-
-            _segments_out.push(seg_);
-        }
+        _send_sender_segments();
     }
 }
 
@@ -75,7 +231,7 @@ size_t TCPConnection::write(const string &data) {
     size_t bytes_written = _sender.stream_in().write(data);
     _sender.fill_window();
     while (_sender.segments_out().size() != 0) {  // 这里将所有 sender 中的 TCPSegment 同样地修改 header 是否合理？
-        TCPSegment seg_ = _sender.segments_out().front();
+        TCPSegment seg_ = move(_sender.segments_out().front());
         _sender.segments_out().pop();
         if (seg_.header().fin) {
             // 如果发送帧中包含 fin，则检视接收是否已经停止，如果确实如此，则完全结束 connection 不需要延时
@@ -87,35 +243,38 @@ size_t TCPConnection::write(const string &data) {
         }
         // 如果自己需要接收字节， 那么就要在即将发送的 TCPSegment 加上相应的 header 项
         optional<WrappingInt32> ackno = _receiver.ackno();  // 自己需要的下一个字节的序号
-        size_t win = _receiver.window_size();               // 自己接收窗口的大小
         if (ackno) {
             seg_.header().ack = true;
             seg_.header().ackno = *ackno;
-            seg_.header().win = win;
+            seg_.header().win = _advertised_window(seg_);
         }
-        _segments_out.push(seg_);
+        _send(seg_);
     }
     return bytes_written;
 }
 
-//! \param[in] ms_since_last_tick number of milliseconds since the last call to this method
-void TCPConnection::tick(const size_t ms_since_last_tick) {
-    _sender.tick(ms_since_last_tick);
+//! \param[in] us_since_last_tick number of microseconds since the last call to this method
+void TCPConnection::tick_us(const uint64_t us_since_last_tick) {
+    _time += us_since_last_tick;  // first, so that what the sender sends now is stamped with the new time
+    _sender.tick_us(us_since_last_tick);
+    // an ACK that is due: a delayed one, or a window update after the application's reads (with SWS avoidance)
+    const bool window_update = _cfg.sws_avoidance && _receiver.ackno() && !_receiver.stream_out().input_ended() &&
+                               _receiver.window_update_due(_sender.mss());
+    if (((_ack_deadline_us && _time >= *_ack_deadline_us) || window_update) && _sender.segments_out().empty())
+        _sender.send_empty_segment();
     // 确保超时重发后 _sender 队列都清空
     while (_sender.segments_out().size() != 0) {
-        TCPSegment seg_ = _sender.segments_out().front();
+        TCPSegment seg_ = move(_sender.segments_out().front());
         _sender.segments_out().pop();
         // 如果自己需要接收字节， 那么就要在即将发送的 TCPSegment 加上相应的 header 项
         optional<WrappingInt32> ackno = _receiver.ackno();  // 自己需要的下一个字节的序号
-        size_t win = _receiver.window_size();               // 自己接收窗口的大小
         if (ackno) {
             seg_.header().ack = true;
             seg_.header().ackno = *ackno;
-            seg_.header().win = win;
+            seg_.header().win = _advertised_window(seg_);
         }
-        _segments_out.push(seg_);
+        _send(seg_);
     }
-    _time += ms_since_last_tick;
     if (_sender.consecutive_retransmissions() > TCPConfig::MAX_RETX_ATTEMPTS) {
         // abort the connection
         while (!_segments_out.empty())
@@ -125,7 +284,7 @@ void TCPConnection::tick(const size_t ms_since_last_tick) {
         _active = false;
         // send a reset segment to the peer (an empty segment with the rst flag set)
         _sender.send_empty_segment();
-        TCPSegment seg_ = _sender.segments_out().front();
+        TCPSegment seg_ = move(_sender.segments_out().front());
         _sender.segments_out().pop();
         seg_.header().rst = true;
         _segments_out.push(seg_);
@@ -142,7 +301,7 @@ void TCPConnection::tick(const size_t ms_since_last_tick) {
         else {
             // linger: the connection is only done after enough time (10 * _cfg.rt timeout) has elapsed
             // since the last segment was received
-            if (time_since_last_segment_received() >= 10 * _cfg.rt_timeout)
+            if (time_since_last_segment_received_us() >= 10 * _cfg.initial_rto_us())
                 _active = false;
         }
     }
@@ -156,9 +315,9 @@ void TCPConnection::end_input_stream() {
 void TCPConnection::connect() {
     // sending a SYN segment
     _sender.fill_window();
-    TCPSegment seg_ = _sender.segments_out().front();
+    TCPSegment seg_ = move(_sender.segments_out().front());
     _sender.segments_out().pop();
-    _segments_out.push(seg_);
+    _send(seg_);
     _listening = false;
 }
 
@@ -167,7 +326,7 @@ TCPConnection::~TCPConnection() {
         if (active()) {
             cerr << "Warning: Unclean shutdown of TCPConnection\n";
             _sender.send_empty_segment();
-            TCPSegment seg_ = _sender.segments_out().front();
+            TCPSegment seg_ = move(_sender.segments_out().front());
             _sender.segments_out().pop();
             seg_.header().rst = true;
             _segments_out.push(seg_);
@@ -6,18 +6,27 @@
 #include "tcp_sender.hh"
 #include "tcp_state.hh"
 
+#include <cstdint>
+
+//! \brief Segments taken in by each path of TCPConnection::segment_received() (see TCPConfig::header_prediction)
+struct HeaderPredictionStats {
+    uint64_t pure_acks{0};  //!< fast path: pure ACKs for new data
+    uint64_t pure_data{0};  //!< fast path: in-order data segments for an idle sender
+    uint64_t misses{0};     //!< general path
+};
+
 //! \brief A complete endpoint of a TCP connection
 class TCPConnection {
   private:
     TCPConfig _cfg;
-    TCPReceiver _receiver{_cfg.recv_capacity};
-    TCPSender _sender{_cfg.send_capacity, _cfg.rt_timeout, _cfg.fixed_isn};
+    TCPReceiver _receiver{_cfg.recv_capacity, _cfg.max_recv_capacity()};
+    TCPSender _sender{_cfg};
 
     //! outbound queue of segments that the TCPConnection wants sent
     std::queue<TCPSegment> _segments_out{};
 
     //! Should the TCPConnection stay active (and keep ACKing)
-    //! for 10 * _cfg.rt_timeout milliseconds after both streams have ended,
+    //! for 10 times the initial retransmission timeout after both streams have ended,
     //! in case the remote TCPConnection doesn't know we've received its whole stream?
     bool _linger_after_streams_finish{true};
 
@@ -25,12 +34,84 @@ class TCPConnection {
 
     bool _active{true};
 
-    size_t _segment_received_time{0};
+    //! value of `_time` when the last segment arrived
+    uint64_t _segment_received_time{0};
 
-    size_t _time{0};
+    //! microseconds of ticks so far
+    uint64_t _time{0};
 
     bool _listening{true};
 
+    //! did the peer's SYN offer SACK? (we use it if TCPConfig::sack is set as well)
+    bool _peer_sack{false};
+
+    //! the window-scale shift the peer's SYN offered (we use scaling if TCPConfig::window_scaling is set as well)
+    std::optional<uint8_t> _peer_window_scale{};
+
+    //! did the peer's SYN offer timestamps? (we use them if TCPConfig::timestamps is set as well)
+    bool _peer_timestamps{false};
+
+    //! did the peer's SYN offer ECN, or its SYN/ACK accept our offer? (we use it if TCPConfig::ecn is set as well)
+    bool _peer_ecn{false};
+
+    //! the timestamp to echo: TSval of the latest segment that didn't start beyond our ackno (RFC 7323 TS.Recent)
+    uint32_t _ts_recent{0};
+
+    //! delayed ACK: segments received in order since we last sent an ACK
+    unsigned _segments_unacked{0};
+
+    //! delayed ACK: value of `_time` by which the pending ACK must go out (empty: none is pending)
+    std::optional<uint64_t> _ack_deadline_us{};
+
+    //! header prediction: segments taken in by each path
+    HeaderPredictionStats _header_prediction{};
+
+    //! shift applied to the windows we advertise (0 unless both ends use window scaling)
+    uint8_t _recv_window_scale() const;
+
+    //! shift applied to the windows the peer advertises (0 unless both ends use window scaling)
+    uint8_t _send_window_scale() const;
+
+    //! do both ends put timestamps on their segments?
+    bool _timestamps_in_use() const { return _cfg.timestamps && _peer_timestamps; }
+
+    //! do both ends use ECN?
+    bool _ecn_in_use() const { return _cfg.ecn && _peer_ecn; }
+
+    //! our timestamp clock: milliseconds of ticks so far
+    uint32_t _ts_now() const { return uint32_t(_time / 1000); }
+
+    //! the window field of an outbound segment: the receiver's window, scaled unless on a SYN
+    uint16_t _advertised_window(const TCPSegment &seg);
+
+    //! \brief fill in the options (and the ECN flags) of an outbound segment
+    //! \details A SYN offers what TCPConfig enables (a SYN/ACK only answers the peer's offers, except for
+    //! the MSS); later segments carry timestamps, SACK blocks and ECN echoes, if both ends use them.
+    void _set_options(TCPSegment &seg) const;
+
+    //! take in the options of an inbound segment (before the receiver and the sender see it)
+    void _options_received(const TCPSegment &seg);
+
+    //! \brief may the ACK for `seg` wait? (if so, the delayed-ACK timer is running)
+    //! \param[in] in_order did `seg` start at the ackno, with no out-of-order data held before or after it?
+    bool _delay_ack(const TCPSegment &seg, const bool in_order);
+
+    //! fill in the options of an outbound segment and queue it, moved from `seg` (an ACK it carries is no
+    //! longer pending)
+    void _send(TCPSegment &seg);
+
+    //! send what the sender has queued, each segment with our ackno and window
+    void _send_sender_segments();
+
+    //! \brief header prediction: may `seg` take the fast path?
+    //! \details If the connection is established and `seg` is either a pure ACK for new data, or
+    //! in-order data (see TCPReceiver::in_order_data()) that acknowledges nothing new and leaves the
+    //! window as it was while the sender has nothing in flight or to send.
+    bool _predicted(const TCPSegment &seg) const;
+
+    //! header prediction: take in a segment that _predicted() accepted
+    void _fast_path(const TCPSegment &seg);
+
   public:
     //! \name "Input" interface for the writer
     //!@{
@@ -64,7 +145,22 @@ class TCPConnection {
     //! \brief number of bytes not yet reassembled
     size_t unassembled_bytes() const;
     //! \brief Number of milliseconds since the last segment was received
-    size_t time_since_last_segment_received() const;
+    size_t time_since_last_segment_received() const { return time_since_last_segment_received_us() / 1000; }
+    //! \brief Number of microseconds since the last segment was received
+    uint64_t time_since_last_segment_received_us() const;
+    //! \brief the sender, for instrumentation (e.g. its congestion window)
+    const TCPSender &sender() const { return _sender; }
+    //! \brief the receiver, for instrumentation (e.g. its auto-tuned capacity)
+    const TCPReceiver &receiver() const { return _receiver; }
+    //! \brief Microseconds until a tick_us() would send a delayed ACK (empty if none is pending)
+    std::optional<uint64_t> time_until_ack_us() const {
+        return _ack_deadline_us ? std::optional<uint64_t>{*_ack_deadline_us - std::min(_time, *_ack_deadline_us)}
+                                : std::nullopt;
+    }
+    //! \brief Segments taken in by each path of segment_received() (all misses unless TCPConfig::header_prediction)
+    const HeaderPredictionStats &header_prediction() const { return _header_prediction; }
+    //! \brief Microseconds until a tick_us() would release paced segments (empty if none are held back)
+    std::optional<uint64_t> time_until_release_us() const { return _sender.time_until_release_us(); }
     //!< \brief summarize the state of the sender, receiver, and the connection
     TCPState state() const { return {_sender, _receiver, active(), _linger_after_streams_finish}; };
     //!@}
@@ -76,7 +172,10 @@ class TCPConnection {
     void segment_received(const TCPSegment &seg);
 
     //! Called periodically when time elapses
-    void tick(const size_t ms_since_last_tick);
+    void tick(const size_t ms_since_last_tick) { tick_us(uint64_t(ms_since_last_tick) * 1000); }
+
+    //! Called periodically when time elapses, with microsecond resolution
+    void tick_us(const uint64_t us_since_last_tick);
 
     //! \brief TCPSegments that the TCPConnection has enqueued for transmission.
     //! \note The owner or operating system will dequeue these and
@@ -84,6 +183,12 @@ class TCPConnection {
     //! but could also be user datagrams (UDP) or any other kind).
     std::queue<TCPSegment> &segments_out() { return _segments_out; }
 
+    //! \brief Send small segments at once, or coalesce them with Nagle's algorithm (like TCP_NODELAY)
+    void set_nodelay(const bool nodelay) { _sender.set_nodelay(nodelay); }
+
+    //! \brief Acknowledge every segment at once, or delay ACKs (like TCP_QUICKACK)
+    void set_quickack(const bool quickack) { _cfg.quickack = quickack; }
+
     //! \brief Is the connection still alive in any way?
     //! \returns `true` if either stream is still running or if the TCPConnection is lingering
     //! after both streams have finished (e.g. to ACK retransmissions from the peer)
@@ -0,0 +1,117 @@
+#ifndef SPONGE_LIBSPONGE_AQM_FD_ADAPTER_HH
+#define SPONGE_LIBSPONGE_AQM_FD_ADAPTER_HH
+
+#include "file_descriptor.hh"
+#include "ipv4_header.hh"
+#include "lossy_fd_adapter.hh"
+#include "tcp_config.hh"
+#include "tcp_segment.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+//! \brief An adapter class that adds active queue management ([ECN](\ref rfc::rfc3168) marking) to a
+//! LossyFdAdapter
+//! \details Each direction has a virtual queue: every datagram adds its size, and the queue drains at
+//! FdAdapterConfig::aqm_rate. A datagram that finds more than FdAdapterConfig::aqm_threshold bytes
+//! queued is marked CE if it is ECN-capable, and dropped otherwise (as a RED or CoDel router would),
+//! so that a connection using ECN learns of the congestion without losing a segment. Datagrams are
+//! not held back: the queue only models what a bottleneck of that rate would hold.
+//!
+//! Over an IPv4 adapter the mark travels in the datagram's header, so both directions matter; over
+//! UDP it doesn't, and only the marks on datagrams read reach a TCPConnection.
+template <typename AdapterT>
+class AqmFdAdapter {
+  private:
+    //! The underlying lossy FD adapter
+    LossyFdAdapter<AdapterT> _adapter;
+
+    double _queue_dn{0};       //!< Bytes in the virtual queue of datagrams read
+    double _queue_up{0};       //!< Bytes in the virtual queue of datagrams written
+    uint64_t _marked{0};       //!< Datagrams marked CE
+    uint64_t _aqm_dropped{0};  //!< Datagrams dropped because they weren't ECN-capable
+
+    //! \brief Put `seg` in `queue`, marking it if the queue is beyond the threshold
+    //! \returns `false` if the segment should be dropped instead
+    bool _enqueue(double &queue, TCPSegment &seg) {
+        const FdAdapterConfig &cfg = _adapter.config();
+        if (cfg.aqm_rate == 0) {
+            return true;
+        }
+        if (queue > double(cfg.aqm_threshold)) {
+            if (seg.ecn() == IPv4Header::ECN_NOT_ECT) {
+                _aqm_dropped++;
+                return false;
+            }
+            seg.set_ecn(IPv4Header::ECN_CE);
+            _marked++;
+        }
+        queue += double(IPv4Header::LENGTH + seg.header().length() + seg.payload().size());
+        return true;
+    }
+
+  public:
+    //! Conversion to a FileDescriptor by returning the underlying AdapterT
+    operator const FileDescriptor &() const { return _adapter; }
+
+    //! Construct from a LossyFdAdapter
+    explicit AqmFdAdapter(LossyFdAdapter<AdapterT> &&adapter) : _adapter(std::move(adapter)) {}
+
+    //! Construct from an AdapterT
+    explicit AqmFdAdapter(AdapterT &&adapter) : _adapter(std::move(adapter)) {}
+
+    //! \brief Read from the underlying adapter, potentially marking or dropping the read datagram
+    //! \returns std::optional<TCPSegment> that is empty if the segment was dropped or if
+    //!          the underlying adapter returned an empty value
+    std::optional<TCPSegment> read() {
+        auto ret = _adapter.read();
+        if (ret and not _enqueue(_queue_dn, *ret)) {
+            return {};
+        }
+        return ret;
+    }
+
+    //! \brief Write to the underlying adapter, potentially marking or dropping the datagram to be written
+    //! \details A TSO super-segment is split first (unless there is no AQM), so that each wire segment
+    //! is queued on its own.
+    void write(TCPSegment &seg) {
+        if (_adapter.config().aqm_rate == 0 or seg.tso_segment_size() == 0) {
+            if (_enqueue(_queue_up, seg)) {
+                _adapter.write(seg);
+            }
+            return;
+        }
+        for (TCPSegment &wire_seg : seg.wire_segments()) {
+            if (_enqueue(_queue_up, wire_seg)) {
+                _adapter.write(wire_seg);
+            }
+        }
+    }
+
+    //! Drain the virtual queues, and pass the time on to the underlying adapter
+    void tick_us(const uint64_t us_since_last_tick) {
+        const double drained = double(_adapter.config().aqm_rate) * double(us_since_last_tick) / 1e6;
+        _queue_dn = std::max(0.0, _queue_dn - drained);
+        _queue_up = std::max(0.0, _queue_up - drained);
+        _adapter.tick_us(us_since_last_tick);
+    }
+
+    //! \name Instrumentation
+    //!@{
+    uint64_t marked() const { return _marked; }            //!< Datagrams marked CE so far
+    uint64_t aqm_dropped() const { return _aqm_dropped; }  //!< Non-ECN datagrams dropped so far
+    //!@}
+
+    //! \name
+    //! Passthrough functions to the underlying LossyFdAdapter instance
+
+    //!@{
+    void set_listening(const bool l) { _adapter.set_listening(l); }      //!< FdAdapterBase::set_listening passthrough
+    const FdAdapterConfig &config() const { return _adapter.config(); }  //!< FdAdapterBase::config passthrough
+    FdAdapterConfig &config_mut() { return _adapter.config_mut(); }      //!< FdAdapterBase::config_mut passthrough
+    //!@}
+};
+
+#endif  // SPONGE_LIBSPONGE_AQM_FD_ADAPTER_HH
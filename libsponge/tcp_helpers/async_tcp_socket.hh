@@ -0,0 +1,78 @@
+#ifndef SPONGE_LIBSPONGE_ASYNC_TCP_SOCKET_HH
+#define SPONGE_LIBSPONGE_ASYNC_TCP_SOCKET_HH
+
+#include "async_eventloop.hh"
+#include "buffer.hh"
+#include "file_descriptor.hh"
+#include "shm_stream.hh"
+#include "task.hh"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+
+//! \brief Coroutine interface to the owner side of a stream socket (e.g. a TCPSpongeSocket)
+//! \details Every operation returns a Task to `co_await`; while an operation waits, the
+//! AsyncEventLoop runs other coroutines, so one owner thread can drive many connections.
+//! The wrapper does not own the socket, and puts it into non-blocking mode.
+//!
+//! ~~~{.cc}
+//! Task<> fetch(AsyncTCPSocket<FullStackSocket> sock, Address server) {
+//!     co_await sock.connect(server);
+//!     co_await sock.write("GET / HTTP/1.1\r\nHost: example.com\r\nConnection: close\r\n\r\n");
+//!     while (not sock.eof()) {
+//!         std::cout << co_await sock.read();
+//!     }
+//! }
+//! ~~~
+template <typename SocketT>
+class AsyncTCPSocket {
+    AsyncEventLoop &_loop;  //!< Loop that resumes the coroutines waiting on this socket
+    SocketT &_socket;       //!< The socket
+
+  public:
+    //! Wrap `socket`, which must outlive this object and every Task it returns
+    AsyncTCPSocket(AsyncEventLoop &loop, SocketT &socket) : _loop(loop), _socket(socket) {
+        _socket.set_blocking(false);
+    }
+
+    //! \brief Connect, suspending until the handshake has finished
+    //! \details The arguments are passed to `SocketT::start_connect` (for a TCPSpongeSocket, a
+    //! TCPConfig and an FdAdapterConfig; for a CS144TCPSocket or FullStackSocket, an Address).
+    template <typename... Args>
+    Task<> connect(Args... args) {
+        FileDescriptor notification = _socket.start_connect(args...);
+        do {
+            co_await _loop.readable(notification);
+        } while (not _socket.finish_connect(notification));
+    }
+
+    //! Read up to `limit` bytes, suspending until some are available; returns "" at EOF
+    Task<std::string> read(const size_t limit = 65536) {
+        co_await _loop.readable(_socket);
+        co_return _socket.read(limit);
+    }
+
+    //! Write all of `data`, suspending whenever the socket is full; returns the number of bytes written
+    Task<size_t> write(std::string data) {
+        size_t written = 0;
+        while (written < data.size()) {
+            const auto [fd, direction] = poll_for_write(_socket);
+            co_await _loop.ready(fd, direction);
+            written += _socket.write(BufferViewList(std::string_view(data).substr(written)), false);
+        }
+        co_return written;
+    }
+
+    //! Shut down the socket (e.g. `SHUT_WR` to end the outbound stream)
+    void shutdown(const int how) { _socket.shutdown(how); }
+
+    //! Has the inbound stream reached EOF?
+    bool eof() const { return _socket.eof(); }
+
+    //! The wrapped socket
+    SocketT &socket() { return _socket; }
+};
+
+#endif  // SPONGE_LIBSPONGE_ASYNC_TCP_SOCKET_HH
@@ -1,5 +1,9 @@
 #include "fd_adapter.hh"
 
+#include "util.hh"
+
+#include <algorithm>
+#include <cerrno>
 #include <iostream>
 #include <stdexcept>
 #include <utility>
@@ -50,7 +54,41 @@ optional<TCPSegment> TCPOverUDPSocketAdapter::read() {
 void TCPOverUDPSocketAdapter::write(TCPSegment &seg) {
     seg.header().sport = config().source.port();
     seg.header().dport = config().destination.port();
-    _sock.sendto(config().destination, seg.serialize(0));
+    if (seg.tso_segment_size() == 0 or seg.payload().size() <= seg.tso_segment_size()) {
+        _sock.sendto(config().destination, seg.serialize(0));
+        return;
+    }
+    const vector<TCPSegment> wire_segs = seg.wire_segments();
+    _write_segmented(wire_segs, wire_segs.front().header().length() + seg.tso_segment_size());
+}
+
+//! \details Runs of datagrams go out with UDP GSO, as many as the kernel takes per call. If the kernel
+//! (or the route's device) doesn't support it, the adapter falls back to one send per datagram.
+void TCPOverUDPSocketAdapter::_write_segmented(const vector<TCPSegment> &wire_segs, const size_t datagram_size) {
+    static constexpr size_t MAX_UDP_PAYLOAD = 65507;
+    const size_t per_send = min(GSO_MAX_SEGMENTS, MAX_UDP_PAYLOAD / datagram_size);
+    size_t sent = 0;
+    while (_gso and per_send > 1 and sent < wire_segs.size()) {
+        BufferList run;
+        const size_t end = min(sent + per_send, wire_segs.size());
+        for (size_t i = sent; i < end; i++) {
+            run.append(wire_segs[i].serialize(0));
+        }
+        try {
+            _sock.sendto_segmented(config().destination, run, uint16_t(datagram_size));
+        } catch (const unix_error &e) {
+            const int error = e.code().value();
+            if (error != EIO and error != EINVAL and error != ENOPROTOOPT and error != EOPNOTSUPP) {
+                throw;
+            }
+            _gso = false;
+            break;
+        }
+        sent = end;
+    }
+    for (; sent < wire_segs.size(); sent++) {
+        _sock.sendto(config().destination, wire_segs[sent].serialize(0));
+    }
 }
 
 //! Specialize LossyFdAdapter to TCPOverUDPSocketAdapter
@@ -10,6 +10,7 @@
 
 #include <optional>
 #include <utility>
+#include <vector>
 
 //! \brief Basic functionality for file descriptor adaptors
 //! \details See TCPOverUDPSocketAdapter and TCPOverIPv4OverTunFdAdapter for more information.
@@ -38,14 +39,18 @@ class FdAdapterBase {
     //! \returns a mutable reference
     FdAdapterConfig &config_mut() { return _cfg; }
 
-    //! Called periodically when time elapses
-    void tick(const size_t) {}
+    //! Called periodically when time elapses (in microseconds)
+    void tick_us(const uint64_t) {}
 };
 
 //! \brief A FD adaptor that reads and writes TCP segments in UDP payloads
 class TCPOverUDPSocketAdapter : public FdAdapterBase {
   private:
     UDPSocket _sock;
+    bool _gso{true};  //!< Does the kernel take a run of datagrams in one send (UDP GSO)?
+
+    //! Send `wire_segs`, all but the last of `datagram_size` bytes, with as few system calls as possible
+    void _write_segmented(const std::vector<TCPSegment> &wire_segs, const size_t datagram_size);
 
   public:
     //! Construct from a UDPSocket sliced into a FileDescriptor
@@ -54,9 +59,12 @@ class TCPOverUDPSocketAdapter : public FdAdapterBase {
     //! Attempts to read and return a TCP segment related to the current connection from a UDP payload
     std::optional<TCPSegment> read();
 
-    //! Writes a TCP segment into a UDP payload
+    //! Writes a TCP segment into a UDP payload (each wire segment of a TSO super-segment into its own)
     void write(TCPSegment &seg);
 
+    //! Most datagrams the kernel accepts in one UDP GSO send (UDP_MAX_SEGMENTS on older kernels)
+    static constexpr size_t GSO_MAX_SEGMENTS = 64;
+
     //! Access the underlying UDP socket
     operator UDPSocket &() { return _sock; }
 
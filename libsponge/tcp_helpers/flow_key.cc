@@ -0,0 +1,76 @@
+#include "flow_key.hh"
+
+#include "address.hh"
+
+#include <stdexcept>
+
+using namespace std;
+
+//! \param[in] ip_header is the header of an inbound IPv4 datagram
+//! \param[in] tcp_header is the header of the TCP segment it carries
+FlowKey FlowKey::inbound(const IPv4Header &ip_header, const TCPHeader &tcp_header) {
+    return {ip_header.dst, ip_header.src, tcp_header.dport, tcp_header.sport};
+}
+
+string FlowKey::to_string() const {
+    return Address::from_ipv4_numeric(local_address).ip() + ":" + std::to_string(local_port) + " <-> " +
+           Address::from_ipv4_numeric(remote_address).ip() + ":" + std::to_string(remote_port);
+}
+
+bool FlowKey::operator==(const FlowKey &other) const {
+    return local_address == other.local_address and remote_address == other.remote_address and
+           local_port == other.local_port and remote_port == other.remote_port;
+}
+
+size_t FlowKeyHash::operator()(const FlowKey &key) const {
+    const uint64_t addresses = (uint64_t(key.remote_address) << 32) | key.local_address;
+    const uint64_t ports = (uint64_t(key.remote_port) << 16) | key.local_port;
+    // 64-bit mix from splitmix64
+    uint64_t x = addresses ^ (ports * 0x9e3779b97f4a7c15ULL);
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+const array<uint8_t, RSSHash::KEY_LENGTH> RSSHash::DEFAULT_KEY = {
+    0x6d, 0x5a, 0x56, 0xda, 0x25, 0x5b, 0x0e, 0xc2, 0x41, 0x67, 0x25, 0x3d, 0x43, 0xa3,
+    0x8f, 0xb0, 0xd0, 0xca, 0x2b, 0xcb, 0xae, 0x7b, 0x30, 0xb4, 0x77, 0xcb, 0x2d, 0xa3,
+    0x80, 0x30, 0xf2, 0x0c, 0x6a, 0x42, 0xb7, 0x3b, 0xbe, 0xac, 0x01, 0xfa};
+
+//! \details For every set bit of the input (most significant bit first), the 32 bits of
+//! the key starting at that bit position are XORed into the result.
+uint32_t RSSHash::toeplitz(const uint8_t *data, const size_t len) const {
+    if (len + 4 > KEY_LENGTH) {
+        throw runtime_error("RSSHash: input too long for key");
+    }
+
+    uint32_t result = 0;
+    uint32_t window = (uint32_t(_key[0]) << 24) | (uint32_t(_key[1]) << 16) | (uint32_t(_key[2]) << 8) | _key[3];
+    for (size_t i = 0; i < len; i++) {
+        for (int bit = 7; bit >= 0; bit--) {
+            if (data[i] & (1 << bit)) {
+                result ^= window;
+            }
+            // slide the window one bit to the right along the key
+            window = (window << 1) | ((_key[i + 4] >> bit) & 1);
+        }
+    }
+    return result;
+}
+
+uint32_t RSSHash::operator()(const FlowKey &key) const {
+    // inbound datagram order: source address, destination address, source port, destination port
+    const array<uint8_t, 12> input = {uint8_t(key.remote_address >> 24),
+                                      uint8_t(key.remote_address >> 16),
+                                      uint8_t(key.remote_address >> 8),
+                                      uint8_t(key.remote_address),
+                                      uint8_t(key.local_address >> 24),
+                                      uint8_t(key.local_address >> 16),
+                                      uint8_t(key.local_address >> 8),
+                                      uint8_t(key.local_address),
+                                      uint8_t(key.remote_port >> 8),
+                                      uint8_t(key.remote_port),
+                                      uint8_t(key.local_port >> 8),
+                                      uint8_t(key.local_port)};
+    return toeplitz(input.data(), input.size());
+}
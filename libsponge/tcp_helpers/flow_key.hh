@@ -0,0 +1,64 @@
+#ifndef SPONGE_LIBSPONGE_FLOW_KEY_HH
+#define SPONGE_LIBSPONGE_FLOW_KEY_HH
+
+#include "ipv4_header.hh"
+#include "tcp_header.hh"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+//! \brief The 4-tuple that identifies a TCP connection, seen from the local endpoint
+struct FlowKey {
+    uint32_t local_address = 0;   //!< local IPv4 address (host byte order)
+    uint32_t remote_address = 0;  //!< remote IPv4 address (host byte order)
+    uint16_t local_port = 0;      //!< local TCP port
+    uint16_t remote_port = 0;     //!< remote TCP port
+
+    //! The key of the connection that an inbound datagram with these headers belongs to
+    static FlowKey inbound(const IPv4Header &ip_header, const TCPHeader &tcp_header);
+
+    //! The same 4-tuple as seen from the remote endpoint
+    FlowKey reversed() const { return {remote_address, local_address, remote_port, local_port}; }
+
+    //! Return a string containing the 4-tuple in human-readable format
+    std::string to_string() const;
+
+    bool operator==(const FlowKey &other) const;
+    bool operator!=(const FlowKey &other) const { return not operator==(other); }
+};
+
+//! \brief Cheap (non-cryptographic) hash for keying FlowKey in unordered containers
+struct FlowKeyHash {
+    size_t operator()(const FlowKey &key) const;
+};
+
+//! \brief Receive-side-scaling hash of a flow, computed the way a NIC would
+//! \details This is the Toeplitz hash from Microsoft's RSS specification, applied to the
+//! inbound 4-tuple (source address, destination address, source port, destination port)
+//! with the specification's default 40-byte secret key. Packets of one connection always
+//! hash to the same value, so a shard selected from this hash owns the connection for its
+//! entire lifetime.
+class RSSHash {
+  public:
+    static constexpr size_t KEY_LENGTH = 40;  //!< length of the Toeplitz secret key, in bytes
+
+    //! The default key from the RSS specification
+    static const std::array<uint8_t, KEY_LENGTH> DEFAULT_KEY;
+
+  private:
+    std::array<uint8_t, KEY_LENGTH> _key;
+
+  public:
+    //! Construct with a particular secret key
+    explicit RSSHash(const std::array<uint8_t, KEY_LENGTH> &key = DEFAULT_KEY) : _key(key) {}
+
+    //! Toeplitz hash of an arbitrary byte string (at most KEY_LENGTH - 4 bytes long)
+    uint32_t toeplitz(const uint8_t *data, const size_t len) const;
+
+    //! Hash of the flow, as computed over the headers of an inbound datagram
+    uint32_t operator()(const FlowKey &key) const;
+};
+
+#endif  // SPONGE_LIBSPONGE_FLOW_KEY_HH
@@ -10,6 +10,15 @@ struct IPv4Header {
     static constexpr uint8_t DEFAULT_TTL = 128;  //!< A reasonable default TTL value
     static constexpr uint8_t PROTO_TCP = 6;      //!< Protocol number for [tcp](\ref rfc::rfc793)
 
+    //! \name [ECN](\ref rfc::rfc3168) codepoints: the two low-order bits of the type of service
+    //!@{
+    static constexpr uint8_t ECN_MASK = 0b11;  //!< The ECN field within `tos`
+    static constexpr uint8_t ECN_NOT_ECT = 0;  //!< Not ECN-capable transport
+    static constexpr uint8_t ECN_ECT1 = 0b01;  //!< ECN-capable transport, ECT(1)
+    static constexpr uint8_t ECN_ECT0 = 0b10;  //!< ECN-capable transport, ECT(0)
+    static constexpr uint8_t ECN_CE = 0b11;    //!< Congestion experienced (set by a router instead of dropping)
+    //!@}
+
     //! \struct IPv4Header
     //! ~~~{.txt}
     //!   0                   1                   2                   3
@@ -46,6 +55,12 @@ struct IPv4Header {
     uint32_t dst = 0;           //!< dst address
     //!@}
 
+    //! The ECN codepoint (one of the `ECN_` constants)
+    uint8_t ecn() const { return tos & ECN_MASK; }
+
+    //! Set the ECN codepoint, keeping the DSCP bits of `tos`
+    void set_ecn(const uint8_t codepoint) { tos = uint8_t((tos & ~ECN_MASK) | (codepoint & ECN_MASK)); }
+
     //! Parse the IP fields from the provided NetParser
     ParseResult parse(NetParser &p);
 
@@ -49,11 +49,20 @@ class LossyFdAdapter {
 
     //! \brief Write to the underlying AdapterT instance, potentially dropping the datagram to be written
     //! \param[in] seg is the packet to either write or drop
+    //! \details A TSO super-segment is split first (unless nothing is dropped), so that each wire
+    //! segment is dropped on its own.
     void write(TCPSegment &seg) {
-        if (_should_drop(true)) {
+        if (_adapter.config().loss_rate_up == 0 or seg.tso_segment_size() == 0) {
+            if (not _should_drop(true)) {
+                _adapter.write(seg);
+            }
             return;
         }
-        return _adapter.write(seg);
+        for (TCPSegment &wire_seg : seg.wire_segments()) {
+            if (not _should_drop(true)) {
+                _adapter.write(wire_seg);
+            }
+        }
     }
 
     //! \name
@@ -63,9 +72,9 @@ class LossyFdAdapter {
     void set_listening(const bool l) { _adapter.set_listening(l); }      //!< FdAdapterBase::set_listening passthrough
     const FdAdapterConfig &config() const { return _adapter.config(); }  //!< FdAdapterBase::config passthrough
     FdAdapterConfig &config_mut() { return _adapter.config_mut(); }      //!< FdAdapterBase::config_mut passthrough
-    void tick(const size_t ms_since_last_tick) {
-        _adapter.tick(ms_since_last_tick);
-    }  //!< FdAdapterBase::tick passthrough
+    void tick_us(const uint64_t us_since_last_tick) {
+        _adapter.tick_us(us_since_last_tick);
+    }  //!< FdAdapterBase::tick_us passthrough
     //!@}
 };
 
@@ -0,0 +1,111 @@
+#include "path_simulator.hh"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+using namespace std;
+
+double PathStats::mean_queue_delay_us() const {
+    const uint64_t queued = segments_sent - segments_too_big - segments_lost - segments_dropped;
+    return queued ? double(queue_delay_sum_us) / double(queued) : 0;
+}
+
+//! Attach the simulator's clock to a connection's configuration
+static TCPConfig with_clock(TCPConfig cfg, const shared_ptr<VirtualClock> &clock) {
+    cfg.clock = clock;
+    return cfg;
+}
+
+PathSimulator::PathSimulator(const TCPConfig &sender_cfg, const TCPConfig &receiver_cfg, const PathConfig &path)
+    : _path(path)
+    , _clock(make_shared<VirtualClock>())
+    , _sender(with_clock(sender_cfg, _clock))
+    , _receiver(with_clock(receiver_cfg, _clock))
+    , _rng(path.seed)
+    , _loss(path.loss_rate) {
+    _sender.connect();
+}
+
+PathSimulator::~PathSimulator() {
+    TCPSegment rst;
+    rst.header().rst = true;
+    _sender.segment_received(rst);
+    _receiver.segment_received(rst);
+}
+
+size_t PathSimulator::queued_bytes() const {
+    const uint64_t now = now_us();
+    return _link_free_us > now ? (_link_free_us - now) * _path.rate_bps / 8'000'000 : 0;
+}
+
+void PathSimulator::_send_data(TCPSegment &&segment) {
+    const uint64_t now = now_us();
+    const size_t size = segment.payload().size() + PathConfig::HEADER_BYTES + segment.header().options.length();
+    _stats.segments_sent++;
+    if (_path.mtu != 0 and size > _path.mtu) {
+        _stats.segments_too_big++;
+        return;
+    }
+    if (_loss(_rng)) {
+        _stats.segments_lost++;
+        return;
+    }
+    if (queued_bytes() + size > _path.queue_bytes) {
+        _stats.segments_dropped++;
+        return;
+    }
+
+    const uint64_t start = max(now, _link_free_us);
+    _link_free_us = start + size * 8'000'000 / _path.rate_bps;
+    _stats.queue_delay_sum_us += start - now;
+    _stats.queue_delay_max_us = max(_stats.queue_delay_max_us, start - now);
+    _data_path.push_back({_link_free_us + _path.rtt_us / 2, move(segment)});
+}
+
+void PathSimulator::_deliver(deque<InTransit> &path, TCPConnection &conn, const uint64_t now_us) {
+    while (not path.empty() and path.front().arrival_us <= now_us) {
+        if (conn.active()) {
+            conn.segment_received(path.front().segment);
+        }
+        path.pop_front();
+    }
+}
+
+//! \param[in] duration_us is rounded up to a whole number of steps
+//! \param[in] observer is called after every step
+void PathSimulator::run_for(const uint64_t duration_us, const ObserverT &observer) {
+    static const string filler(65536, 'x');
+    const uint64_t end = now_us() + duration_us;
+    while (now_us() < end) {
+        _clock->advance_us(_path.step_us);
+        const uint64_t now = now_us();
+
+        _deliver(_data_path, _receiver, now);
+        _deliver(_ack_path, _sender, now);
+
+        // the applications: an infinite source and an infinitely fast sink
+        while (_sender.active() and _sender.remaining_outbound_capacity() > 0) {
+            _sender.write(filler.substr(0, min(filler.size(), _sender.remaining_outbound_capacity())));
+        }
+        ByteStream &inbound = _receiver.inbound_stream();
+        _stats.bytes_delivered += inbound.buffer_size();
+        inbound.pop_output(inbound.buffer_size());
+
+        _sender.tick_us(_path.step_us);
+        _receiver.tick_us(_path.step_us);
+
+        for (; not _sender.segments_out().empty(); _sender.segments_out().pop()) {
+            for (TCPSegment &wire_seg : _sender.segments_out().front().wire_segments()) {
+                _send_data(move(wire_seg));
+            }
+        }
+        for (; not _receiver.segments_out().empty(); _receiver.segments_out().pop()) {
+            _ack_path.push_back({now + _path.rtt_us / 2, move(_receiver.segments_out().front())});
+        }
+
+        if (observer) {
+            observer(*this);
+        }
+    }
+}
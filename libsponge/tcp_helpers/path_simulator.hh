@@ -0,0 +1,103 @@
+#ifndef SPONGE_LIBSPONGE_PATH_SIMULATOR_HH
+#define SPONGE_LIBSPONGE_PATH_SIMULATOR_HH
+
+#include "clock.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_segment.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <random>
+
+//! Properties of the simulated path between a bulk sender and its receiver
+struct PathConfig {
+    static constexpr size_t HEADER_BYTES = 40;  //!< IPv4 + TCP header bytes charged per segment (plus options)
+
+    uint64_t rate_bps = 10'000'000;  //!< Bottleneck rate of the data direction, in bits per second
+    uint64_t rtt_us = 40'000;        //!< Round-trip propagation delay
+    size_t queue_bytes = 50'000;     //!< Drop-tail buffer in front of the bottleneck
+    double loss_rate = 0;            //!< Probability that a data-direction segment is lost at random
+    size_t mtu = 0;                  //!< Largest datagram (headers included) the data direction carries (0: any)
+    uint64_t step_us = 500;          //!< Simulation time step (how often the connections are ticked)
+    uint32_t seed = 1;               //!< Seed for the random losses
+};
+
+//! Counters kept by a PathSimulator
+struct PathStats {
+    uint64_t bytes_delivered = 0;     //!< Payload bytes read by the receiving application
+    uint64_t segments_sent = 0;       //!< Segments the sender put on the path
+    uint64_t segments_lost = 0;       //!< Segments dropped at random (PathConfig::loss_rate)
+    uint64_t segments_dropped = 0;    //!< Segments dropped because the bottleneck buffer was full
+    uint64_t segments_too_big = 0;    //!< Segments dropped because they exceeded PathConfig::mtu
+    uint64_t queue_delay_sum_us = 0;  //!< Sum of the queueing delays of the segments that entered the buffer
+    uint64_t queue_delay_max_us = 0;  //!< Largest queueing delay
+
+    //! Mean queueing delay of the segments that entered the buffer, in microseconds
+    double mean_queue_delay_us() const;
+};
+
+//! \brief Deterministic, single-threaded simulation of one bulk TCP transfer over a bottleneck link
+//! \details Two TCPConnection objects exchange TCPSegment objects directly (no serialization).
+//! The data direction has a rate limit, a drop-tail buffer, random loss and half the RTT of
+//! propagation delay; the ACK direction only has the delay. Time is a VirtualClock that moves in
+//! fixed steps: each step delivers the segments that have arrived, lets the sending application
+//! fill the outbound stream and the receiving application drain the inbound one, ticks both
+//! connections, and puts whatever they sent on the path.
+class PathSimulator {
+  public:
+    //! Called once per step, after the connections have been ticked
+    using ObserverT = std::function<void(const PathSimulator &)>;
+
+  private:
+    //! A segment on its way to the other end
+    struct InTransit {
+        uint64_t arrival_us;  //!< When it reaches the other end
+        TCPSegment segment;   //!< The segment
+    };
+
+    PathConfig _path;
+    std::shared_ptr<VirtualClock> _clock;
+    TCPConnection _sender;
+    TCPConnection _receiver;
+    std::deque<InTransit> _data_path{};  //!< sender -> receiver, in arrival order
+    std::deque<InTransit> _ack_path{};   //!< receiver -> sender, in arrival order
+    uint64_t _link_free_us{0};           //!< When the bottleneck finishes sending what is queued
+    std::mt19937 _rng;
+    std::bernoulli_distribution _loss;
+    PathStats _stats{};
+
+    //! Queue a data-direction segment at the bottleneck (or drop it)
+    void _send_data(TCPSegment &&segment);
+
+    //! Give every segment that has arrived by now to `conn`
+    static void _deliver(std::deque<InTransit> &path, TCPConnection &conn, const uint64_t now_us);
+
+  public:
+    //! \param[in] sender_cfg configures the connection that sends the bulk data
+    //! \param[in] receiver_cfg configures the connection that receives it
+    //! \param[in] path describes the path between them
+    PathSimulator(const TCPConfig &sender_cfg, const TCPConfig &receiver_cfg, const PathConfig &path);
+
+    //! Resets both connections (quietly)
+    ~PathSimulator();
+
+    //! Advance the simulation by `duration_us`, calling `observer` (if set) after every step
+    void run_for(const uint64_t duration_us, const ObserverT &observer = {});
+
+    //! \name Accessors
+    //!@{
+    uint64_t now_us() const { return _clock->now_us(); }
+    const PathStats &stats() const { return _stats; }
+    const PathConfig &path() const { return _path; }
+    const TCPConnection &sender() const { return _sender; }
+    const TCPConnection &receiver() const { return _receiver; }
+    //! Bytes waiting in the bottleneck buffer
+    size_t queued_bytes() const;
+    //!@}
+};
+
+#endif  // SPONGE_LIBSPONGE_PATH_SIMULATOR_HH
@@ -2,12 +2,25 @@
 #define SPONGE_LIBSPONGE_TCP_CONFIG_HH
 
 #include "address.hh"
+#include "clock.hh"
 #include "wrapping_integers.hh"
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <limits>
+#include <memory>
 #include <optional>
 
+//! Congestion-control algorithms the TCPSender can run (see congestion_control.hh)
+enum class CongestionControlAlgorithm {
+    None,     //!< No congestion window: send whatever the receiver's window allows
+    Reno,     //!< RFC 5681
+    NewReno,  //!< RFC 6582
+    Cubic,    //!< RFC 9438
+    Bbr       //!< BBR v1 (draft-cardwell-iccrg-bbr-congestion-control-00), with pacing
+};
+
 //! Config for TCP sender and receiver
 class TCPConfig {
   public:
@@ -20,6 +33,143 @@ class TCPConfig {
     size_t recv_capacity = DEFAULT_CAPACITY;  //!< Receive capacity, in bytes
     size_t send_capacity = DEFAULT_CAPACITY;  //!< Sender capacity, in bytes
     std::optional<WrappingInt32> fixed_isn{};
+
+    //! Initial retransmission timeout in microseconds; if set, overrides `rt_timeout`
+    std::optional<uint64_t> rt_timeout_us{};
+
+    //! \brief Adapt the retransmission timeout to measured round-trip times (RFC 6298)
+    //! \details Otherwise the RTO is the initial value after every new ack, doubled on each timeout.
+    bool adaptive_rto = false;
+
+    //! Lower bound on the adaptive RTO (RFC 6298 recommends 1 s; Linux uses 200 ms)
+    uint64_t rto_min_us = 200'000;
+
+    //! Upper bound on the adaptive RTO, including backoff (RFC 6298: at least 60 s)
+    uint64_t rto_max_us = 60'000'000;
+
+    //! Congestion control for the sender (default: none, i.e. bounded by the receiver's window only)
+    CongestionControlAlgorithm congestion_control = CongestionControlAlgorithm::None;
+
+    //! Initial congestion window, in segments of MAX_PAYLOAD_SIZE (RFC 6928)
+    uint64_t initial_cwnd_segments = 10;
+
+    //! \brief Rate at which the sender releases new segments, in bytes per second (0: no pacing)
+    //! \details If the congestion control paces as well (BBR), the lower of the two rates applies.
+    uint64_t pacing_rate = 0;
+
+    //! Bytes the sender may release back to back after an idle period when it is pacing
+    size_t pacing_burst = 2 * MAX_PAYLOAD_SIZE;
+
+    //! \brief Offer selective acknowledgments (RFC 2018) on the SYN
+    //! \details If the peer offers them too, the receiver reports the blocks it holds beyond the
+    //! ackno, and the sender (with congestion control) retransmits only the holes between them.
+    bool sack = false;
+
+    //! \brief Maximum segment size to advertise on the SYN (empty: no MSS option)
+    //! \details Payloads are at most the smaller of this and the peer's MSS, taking
+    //! MAX_PAYLOAD_SIZE for either one that is absent.
+    std::optional<uint16_t> mss{};
+
+    //! \brief Offer window scaling (RFC 7323) on the SYN
+    //! \details If the peer offers it too, windows beyond 65535 bytes can be advertised: ours are
+    //! shifted by window_scale(), the peer's by the shift it offered.
+    bool window_scaling = false;
+
+    //! \brief Offer timestamps (RFC 7323) on the SYN
+    //! \details If the peer offers them too, every segment carries them, and every ack of new data
+    //! gives the adaptive RTO a sample, even one for retransmitted data.
+    bool timestamps = false;
+
+    //! \brief Search for the largest segment the path carries (RFC 4821 packetization-layer PMTU discovery)
+    //! \details Segments start at MAX_PAYLOAD_SIZE bytes (or the MSS, if smaller); the sender then
+    //! probes larger sizes, up to the MSS, one segment at a time. A lost probe is resent in
+    //! pieces of the current size and is not taken as a sign of congestion.
+    bool plpmtud = false;
+
+    //! \brief Emit bursts as TSO super-segments of up to this many payload bytes (0: one segment per MSS)
+    //! \details The sender and the connection handle a burst once; the adapter that writes it splits
+    //! it into segments of the MSS (see TCPSegment::wire_segments()).
+    size_t tso_max_size = 0;
+
+    //! \brief Send small segments at once (like TCP_NODELAY)
+    //! \details If false, Nagle's algorithm (RFC 896) holds back a segment smaller than the MSS while
+    //! data is unacknowledged, so that small writes coalesce.
+    bool nodelay = true;
+
+    //! \brief Acknowledge every segment at once (like TCP_QUICKACK)
+    //! \details If false, the ACK for in-order data is delayed (RFC 5681 4.2) until a second segment
+    //! arrives, a segment of ours carries it, or `delayed_ack_us` has passed.
+    bool quickack = true;
+
+    //! Longest an ACK may be delayed, in microseconds (without quickack)
+    uint64_t delayed_ack_us = 40'000;
+
+    //! \brief Grow the receive capacity to match how fast the application reads (dynamic right-sizing)
+    //! \details `recv_capacity` is then only the initial capacity: once per round trip, the receiver
+    //! may grow its buffers, and so the window it advertises, up to `recv_capacity_max`.
+    bool recv_autotune = false;
+
+    //! Most the receive capacity may grow to with recv_autotune, in bytes
+    size_t recv_capacity_max = 6 * 1024 * 1024;
+
+    //! \brief Avoid silly-window syndrome on both ends (RFC 1122 4.2.3.3 and 4.2.3.4)
+    //! \details The receiver moves the right edge of its window only by at least min(MSS, half its
+    //! capacity), and says so when the application's reads open it that far. The sender holds back a
+    //! segment smaller than the MSS unless it carries all queued data or fills half the largest
+    //! window offered, for TCPSender::SWS_OVERRIDE_US at most; a zero window is probed only then.
+    bool sws_avoidance = false;
+
+    //! \brief Probe a zero window from a persist timer with exponential backoff (RFC 9293 3.8.6.1)
+    //! \details Otherwise a zero window is probed with one byte at once, and then on every RTO
+    //! without backoff. The persist timer starts at the RTO, doubles after every probe up to
+    //! `rto_max_us`, and stands in for the retransmission timer while the window is zero; its probes
+    //! never count as retransmissions, so a receiver may keep its window closed indefinitely.
+    bool persist_timer = false;
+
+    //! \brief Detect losses by time (RACK) and probe for tail losses (TLP), as in RFC 8985
+    //! \details A segment is taken as lost once a segment sent after it has been delivered and a
+    //! reordering window has passed, instead of after three duplicate ACKs; and when the ACKs stop,
+    //! a probe after two RTTs shows the losses at the tail of a flight without waiting for the RTO.
+    //! Needs `sack` on both ends (and congestion control, to enter recovery); where the peer doesn't
+    //! agree to SACK, losses are detected by duplicate ACKs as without it.
+    bool rack_tlp = false;
+
+    //! \brief Negotiate Explicit Congestion Notification (RFC 3168) on the SYN
+    //! \details If the peer agrees, data segments go out ECN-capable, so that a congested queue can
+    //! mark them CE instead of dropping them. The receiver echoes a mark with ECE until the sender
+    //! answers with CWR; the sender reduces its congestion window as for a loss (at most once per
+    //! window of data), but retransmits nothing.
+    bool ecn = false;
+
+    //! \brief Take common segments on a fast path (Van Jacobson's header prediction, as in BSD)
+    //! \details On an established connection, a pure ACK for new data skips the receiver, and an
+    //! in-order data segment for a sender with nothing to send or acknowledge skips the sender; its
+    //! payload goes into the inbound stream without a copy. Either way the result is the same as on the
+    //! general path. TCPConnection::header_prediction() counts the segments that took each path.
+    bool header_prediction = false;
+
+    //! Time source for whatever drives the connection's tick_us() (empty: MonotonicClock::instance())
+    std::shared_ptr<const Clock> clock{};
+
+    //! Initial value of the retransmission timeout, in microseconds
+    uint64_t initial_rto_us() const { return rt_timeout_us.value_or(uint64_t(rt_timeout) * 1000); }
+
+    //! The most the receive capacity may become (`recv_capacity`, or more with recv_autotune)
+    size_t max_recv_capacity() const {
+        return recv_autotune ? std::max(recv_capacity, recv_capacity_max) : recv_capacity;
+    }
+
+    //! The smallest window-scale shift (at most 14) that lets the whole max_recv_capacity() be advertised
+    uint8_t window_scale() const {
+        uint8_t shift = 0;
+        while (shift < 14 and (max_recv_capacity() >> shift) > std::numeric_limits<uint16_t>::max()) {
+            shift++;
+        }
+        return shift;
+    }
+
+    //! The configured Clock
+    const Clock &time_source() const { return clock ? *clock : MonotonicClock::instance(); }
 };
 
 //! Config for classes derived from FdAdapter
@@ -30,6 +180,9 @@ class FdAdapterConfig {
 
     uint16_t loss_rate_dn = 0;  //!< Downlink loss rate (for LossyFdAdapter)
     uint16_t loss_rate_up = 0;  //!< Uplink loss rate (for LossyFdAdapter)
+
+    uint64_t aqm_rate = 0;          //!< Drain rate of AqmFdAdapter's queues, in bytes per second (0: no AQM)
+    size_t aqm_threshold = 30'000;  //!< Queue size beyond which AqmFdAdapter marks (or drops) datagrams
 };
 
 #endif  // SPONGE_LIBSPONGE_TCP_CONFIG_HH
@@ -1,9 +1,124 @@
 #include "tcp_header.hh"
 
+#include <algorithm>
 #include <sstream>
 
 using namespace std;
 
+//! Bytes of option space in a TCP header
+static constexpr size_t OPTION_SPACE = 40;
+
+//! Option bytes without the SACK blocks
+static size_t length_without_sack(const TCPOptions &options) {
+    return (options.mss ? 4 : 0)               // kind, length, MSS
+           + (options.window_scale ? 4 : 0)    // NOP, kind, length, shift
+           + (options.sack_permitted ? 4 : 0)  // NOP, NOP, kind, length
+           + (options.timestamps ? 12 : 0);    // NOP, NOP, kind, length, TSval, TSecr
+}
+
+//! SACK blocks that fit in the option space next to the other options
+static size_t sack_blocks_that_fit(const TCPOptions &options) {
+    const size_t room = OPTION_SPACE - length_without_sack(options);
+    return room < 4 ? 0 : min({options.sack.size(), TCPOptions::MAX_SACK_BLOCKS, (room - 4) / 8});
+}
+
+size_t TCPOptions::length() const {
+    const size_t blocks = sack_blocks_that_fit(*this);
+    return length_without_sack(*this) + (blocks ? 4 + 8 * blocks : 0);  // NOP, NOP, kind, length, blocks
+}
+
+//! \param[in,out] p is a NetParser positioned at the first option
+//! \param[in] length is the number of option bytes in the header (`doff` words minus the fixed header)
+//! \details An option whose length runs past the end of the header makes the header invalid.
+ParseResult TCPOptions::parse(NetParser &p, size_t length) {
+    while (length > 0 and not p.error()) {
+        const uint8_t kind = p.u8();
+        length--;
+        if (kind == END) {
+            break;
+        }
+        if (kind == NOP) {
+            continue;
+        }
+        if (length == 0) {
+            return ParseResult::HeaderTooShort;
+        }
+        const uint8_t option_length = p.u8();
+        length--;
+        if (option_length < 2 or option_length - 2u > length) {
+            return ParseResult::HeaderTooShort;
+        }
+        const size_t body = option_length - 2u;
+        length -= body;
+        if (kind == MSS and body == 2) {
+            mss = p.u16();
+        } else if (kind == WINDOW_SCALE and body == 1) {
+            window_scale = min(p.u8(), MAX_WINDOW_SCALE);  // RFC 7323: larger shifts are treated as 14
+        } else if (kind == SACK_PERMITTED and body == 0) {
+            sack_permitted = true;
+        } else if (kind == SACK and body % 8 == 0) {
+            for (size_t i = 0; i < body / 8; i++) {
+                SackBlock block;
+                block.left = WrappingInt32{p.u32()};
+                block.right = WrappingInt32{p.u32()};
+                sack.push_back(block);
+            }
+        } else if (kind == TIMESTAMPS and body == 8) {
+            Timestamps ts;
+            ts.value = p.u32();
+            ts.echo_reply = p.u32();
+            timestamps = ts;
+        } else {
+            p.remove_prefix(body);  // an option we don't use
+        }
+    }
+    p.remove_prefix(length);  // whatever follows an END option
+    return p.get_error();
+}
+
+//! \details Each option is padded to four bytes on its own. SACK blocks that don't fit in the
+//! option space next to the others (at most three with timestamps) are left out.
+void TCPOptions::serialize(string &out) const {
+    if (mss) {
+        NetUnparser::u8(out, MSS);
+        NetUnparser::u8(out, 4);
+        NetUnparser::u16(out, *mss);
+    }
+    if (window_scale) {
+        NetUnparser::u8(out, NOP);
+        NetUnparser::u8(out, WINDOW_SCALE);
+        NetUnparser::u8(out, 3);
+        NetUnparser::u8(out, *window_scale);
+    }
+    if (sack_permitted) {
+        NetUnparser::u8(out, NOP);
+        NetUnparser::u8(out, NOP);
+        NetUnparser::u8(out, SACK_PERMITTED);
+        NetUnparser::u8(out, 2);
+    }
+    if (timestamps) {
+        NetUnparser::u8(out, NOP);
+        NetUnparser::u8(out, NOP);
+        NetUnparser::u8(out, TIMESTAMPS);
+        NetUnparser::u8(out, 10);
+        NetUnparser::u32(out, timestamps->value);
+        NetUnparser::u32(out, timestamps->echo_reply);
+    }
+    const size_t blocks = sack_blocks_that_fit(*this);
+    if (blocks > 0) {
+        NetUnparser::u8(out, NOP);
+        NetUnparser::u8(out, NOP);
+        NetUnparser::u8(out, SACK);
+        NetUnparser::u8(out, 2 + 8 * blocks);
+        for (size_t i = 0; i < blocks; i++) {
+            NetUnparser::u32(out, sack[i].left.raw_value());
+            NetUnparser::u32(out, sack[i].right.raw_value());
+        }
+    }
+}
+
+size_t TCPHeader::length() const { return max(size_t{4} * doff, LENGTH + options.length()); }
+
 //! \param[in,out] p is a NetParser from which the TCP fields will be extracted
 //! \returns a ParseResult indicating success or the reason for failure
 //! \details It is important to check for (at least) the following potential errors
@@ -22,6 +137,8 @@ ParseResult TCPHeader::parse(NetParser &p) {
     doff = p.u8() >> 4;              // data offset
 
     const uint8_t fl_b = p.u8();                  // byte including flags
+    cwr = static_cast<bool>(fl_b & 0b1000'0000);
+    ece = static_cast<bool>(fl_b & 0b0100'0000);
     urg = static_cast<bool>(fl_b & 0b0010'0000);  // binary literals and ' digit separator since C++14!!!
     ack = static_cast<bool>(fl_b & 0b0001'0000);
     psh = static_cast<bool>(fl_b & 0b0000'1000);
@@ -37,8 +154,11 @@ ParseResult TCPHeader::parse(NetParser &p) {
         return ParseResult::HeaderTooShort;
     }
 
-    // skip any options or anything extra in the header
-    p.remove_prefix(doff * 4 - TCPHeader::LENGTH);
+    options = {};
+    const ParseResult options_result = options.parse(p, doff * 4 - TCPHeader::LENGTH);
+    if (options_result != ParseResult::NoError) {
+        return options_result;
+    }
 
     if (p.error()) {
         return p.get_error();
@@ -54,17 +174,19 @@ string TCPHeader::serialize() const {
         throw runtime_error("TCP header too short");
     }
 
+    const size_t header_length = length();
     string ret;
-    ret.reserve(4 * doff);
+    ret.reserve(header_length);
 
     NetUnparser::u16(ret, sport);              // source port
     NetUnparser::u16(ret, dport);              // destination port
     NetUnparser::u32(ret, seqno.raw_value());  // sequence number
     NetUnparser::u32(ret, ackno.raw_value());  // ack number
-    NetUnparser::u8(ret, doff << 4);           // data offset
+    NetUnparser::u8(ret, header_length / 4 << 4);  // data offset
 
-    const uint8_t fl_b = (urg ? 0b0010'0000 : 0) | (ack ? 0b0001'0000 : 0) | (psh ? 0b0000'1000 : 0) |
-                         (rst ? 0b0000'0100 : 0) | (syn ? 0b0000'0010 : 0) | (fin ? 0b0000'0001 : 0);
+    const uint8_t fl_b = (cwr ? 0b1000'0000 : 0) | (ece ? 0b0100'0000 : 0) | (urg ? 0b0010'0000 : 0) |
+                         (ack ? 0b0001'0000 : 0) | (psh ? 0b0000'1000 : 0) | (rst ? 0b0000'0100 : 0) |
+                         (syn ? 0b0000'0010 : 0) | (fin ? 0b0000'0001 : 0);
     NetUnparser::u8(ret, fl_b);  // flags
     NetUnparser::u16(ret, win);  // window size
 
@@ -72,7 +194,8 @@ string TCPHeader::serialize() const {
 
     NetUnparser::u16(ret, uptr);  // urgent pointer
 
-    ret.resize(4 * doff);  // expand header to advertised size
+    options.serialize(ret);
+    ret.resize(header_length);  // expand header to advertised size
 
     return ret;
 }
@@ -86,23 +209,49 @@ string TCPHeader::to_string() const {
        << "TCP ackno: " << ackno << '\n'
        << "TCP doff: " << +doff << '\n'
        << "Flags: urg: " << urg << " ack: " << ack << " psh: " << psh << " rst: " << rst << " syn: " << syn
-       << " fin: " << fin << '\n'
+       << " fin: " << fin << " ece: " << ece << " cwr: " << cwr << '\n'
        << "TCP winsize: " << +win << '\n'
        << "TCP cksum: " << +cksum << '\n'
        << "TCP uptr: " << +uptr << '\n';
+    if (options.mss) {
+        ss << "TCP option: MSS " << dec << *options.mss << hex << '\n';
+    }
+    if (options.window_scale) {
+        ss << "TCP option: window scale " << dec << +*options.window_scale << hex << '\n';
+    }
+    if (options.sack_permitted) {
+        ss << "TCP option: SACK permitted\n";
+    }
+    if (options.timestamps) {
+        ss << "TCP option: timestamps " << dec << options.timestamps->value << ' ' << options.timestamps->echo_reply
+           << hex << '\n';
+    }
+    for (const auto &block : options.sack) {
+        ss << "TCP option: SACK " << block.left << '-' << block.right << '\n';
+    }
     return ss.str();
 }
 
 string TCPHeader::summary() const {
     stringstream ss{};
     ss << "Header(flags=" << (syn ? "S" : "") << (ack ? "A" : "") << (rst ? "R" : "") << (fin ? "F" : "")
-       << ",seqno=" << seqno << ",ack=" << ackno << ",win=" << win << ")";
+       << (ece ? "E" : "") << (cwr ? "C" : "") << ",seqno=" << seqno << ",ack=" << ackno << ",win=" << win;
+    if (options.mss) {
+        ss << ",mss=" << *options.mss;
+    }
+    if (options.window_scale) {
+        ss << ",wscale=" << +*options.window_scale;
+    }
+    for (const auto &block : options.sack) {
+        ss << ",sack=" << block.left << '-' << block.right;
+    }
+    ss << ")";
     return ss.str();
 }
 
 bool TCPHeader::operator==(const TCPHeader &other) const {
     // TODO(aozdemir) more complete check (right now we omit cksum, src, dst
-    return seqno == other.seqno && ackno == other.ackno && doff == other.doff && urg == other.urg && ack == other.ack &&
-           psh == other.psh && rst == other.rst && syn == other.syn && fin == other.fin && win == other.win &&
-           uptr == other.uptr;
+    return seqno == other.seqno && ackno == other.ackno && length() == other.length() && urg == other.urg &&
+           ack == other.ack && psh == other.psh && rst == other.rst && syn == other.syn && fin == other.fin &&
+           cwr == other.cwr && ece == other.ece && win == other.win && uptr == other.uptr && options == other.options;
 }
@@ -4,8 +4,70 @@
 #include "parser.hh"
 #include "wrapping_integers.hh"
 
+#include <optional>
+#include <string>
+#include <vector>
+
+//! \brief The TCP options this implementation understands
+//! \details Options of other kinds are skipped when parsing and never serialized.
+struct TCPOptions {
+    //! \name Option kinds
+    //!@{
+    static constexpr uint8_t END = 0;             //!< End of option list
+    static constexpr uint8_t NOP = 1;             //!< No-operation (padding)
+    static constexpr uint8_t MSS = 2;             //!< Maximum segment size (SYN only)
+    static constexpr uint8_t WINDOW_SCALE = 3;    //!< [Window scale](\ref rfc::rfc7323) (SYN only)
+    static constexpr uint8_t SACK_PERMITTED = 4;  //!< [SACK](\ref rfc::rfc2018) permitted (SYN only)
+    static constexpr uint8_t SACK = 5;            //!< [SACK](\ref rfc::rfc2018) blocks
+    static constexpr uint8_t TIMESTAMPS = 8;      //!< [Timestamps](\ref rfc::rfc7323)
+    //!@}
+
+    //! At most this many SACK blocks fit in the 40 bytes of option space (three next to timestamps)
+    static constexpr size_t MAX_SACK_BLOCKS = 4;
+
+    //! Largest window-scale shift (RFC 7323: windows of up to 2^30 bytes)
+    static constexpr uint8_t MAX_WINDOW_SCALE = 14;
+
+    //! A contiguous block of sequence space the receiver holds beyond the ackno: [left, right)
+    struct SackBlock {
+        WrappingInt32 left{0};   //!< first sequence number of the block
+        WrappingInt32 right{0};  //!< sequence number just past the block
+
+        bool operator==(const SackBlock &other) const { return left == other.left && right == other.right; }
+    };
+
+    //! The sender's clock when it sent the segment, and the most recent value it received
+    struct Timestamps {
+        uint32_t value = 0;       //!< TSval
+        uint32_t echo_reply = 0;  //!< TSecr (0 on a SYN)
+
+        bool operator==(const Timestamps &other) const {
+            return value == other.value && echo_reply == other.echo_reply;
+        }
+    };
+
+    std::optional<uint16_t> mss{};           //!< the largest payload the sender of a SYN can receive
+    std::optional<uint8_t> window_scale{};   //!< the sender of a SYN shifts its advertised windows by this much
+    bool sack_permitted = false;             //!< the sender of a SYN can make use of SACK blocks
+    std::vector<SackBlock> sack{};           //!< blocks received out of order (most recently changed first)
+    std::optional<Timestamps> timestamps{};  //!< timestamps (on every segment, once both SYNs carried them)
+
+    //! Number of bytes the options take in the header, padded to a multiple of four
+    size_t length() const;
+
+    //! Parse `length` bytes of options from the provided NetParser
+    ParseResult parse(NetParser &p, size_t length);
+
+    //! Append the serialized options (padded with NOPs to a multiple of four bytes) to `out`
+    void serialize(std::string &out) const;
+
+    bool operator==(const TCPOptions &other) const {
+        return mss == other.mss && window_scale == other.window_scale && sack_permitted == other.sack_permitted &&
+               sack == other.sack && timestamps == other.timestamps;
+    }
+};
+
 //! \brief [TCP](\ref rfc::rfc793) segment header
-//! \note TCP options are not supported
 struct TCPHeader {
     static constexpr size_t LENGTH = 20;  //!< [TCP](\ref rfc::rfc793) header length, not including options
 
@@ -20,9 +82,9 @@ struct TCPHeader {
     //!  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
     //!  |                    Acknowledgment Number                      |
     //!  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-    //!  |  Data |           |U|A|P|R|S|F|                               |
-    //!  | Offset| Reserved  |R|C|S|S|Y|I|            Window             |
-    //!  |       |           |G|K|H|T|N|N|                               |
+    //!  |  Data |       |C|E|U|A|P|R|S|F|                               |
+    //!  | Offset| Rsrvd |W|C|R|C|S|S|Y|I|            Window             |
+    //!  |       |       |R|E|G|K|H|T|N|N|                               |
     //!  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
     //!  |           Checksum            |         Urgent Pointer        |
     //!  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
@@ -39,6 +101,8 @@ struct TCPHeader {
     WrappingInt32 seqno{0};     //!< sequence number
     WrappingInt32 ackno{0};     //!< ack number
     uint8_t doff = LENGTH / 4;  //!< data offset
+    bool cwr = false;           //!< congestion window reduced flag ([ECN](\ref rfc::rfc3168))
+    bool ece = false;           //!< ECN-echo flag ([ECN](\ref rfc::rfc3168))
     bool urg = false;           //!< urgent flag
     bool ack = false;           //!< ack flag
     bool psh = false;           //!< push flag
@@ -48,8 +112,13 @@ struct TCPHeader {
     uint16_t win = 0;           //!< window size
     uint16_t cksum = 0;         //!< checksum
     uint16_t uptr = 0;          //!< urgent pointer
+    TCPOptions options{};       //!< options
     //!@}
 
+    //! \brief Length of the serialized header, in bytes
+    //! \details `doff` words, or more if the options need more room
+    size_t length() const;
+
     //! Parse the TCP fields from the provided NetParser
     ParseResult parse(NetParser &p);
 
@@ -45,6 +45,7 @@ optional<TCPSegment> TCPOverIPv4Adapter::unwrap_tcp_in_ip(const InternetDatagram
     if (ParseResult::NoError != tcp_seg.parse(ip_dgram.payload(), ip_dgram.header().pseudo_cksum())) {
         return {};
     }
+    tcp_seg.set_ecn(ip_dgram.header().ecn());
 
     // is the TCP segment for us?
     if (tcp_seg.header().dport != config().source.port()) {
@@ -81,7 +82,8 @@ InternetDatagram TCPOverIPv4Adapter::wrap_tcp_in_ip(TCPSegment &seg) {
     InternetDatagram ip_dgram;
     ip_dgram.header().src = config().source.ipv4_numeric();
     ip_dgram.header().dst = config().destination.ipv4_numeric();
-    ip_dgram.header().len = ip_dgram.header().hlen * 4 + seg.header().doff * 4 + seg.payload().size();
+    ip_dgram.header().len = ip_dgram.header().hlen * 4 + seg.header().length() + seg.payload().size();
+    ip_dgram.header().set_ecn(seg.ecn());
 
     // set payload, calculating TCP checksum using information from IP header
     ip_dgram.payload() = seg.serialize(ip_dgram.header().pseudo_cksum());
@@ -43,3 +43,26 @@ BufferList TCPSegment::serialize(const uint32_t datagram_layer_checksum) const {
 
     return ret;
 }
+
+vector<TCPSegment> TCPSegment::wire_segments() const {
+    if (_tso_segment_size == 0 or _payload.size() <= _tso_segment_size) {
+        vector<TCPSegment> ret{*this};
+        ret.back()._tso_segment_size = 0;
+        return ret;
+    }
+
+    vector<TCPSegment> ret;
+    ret.reserve((_payload.size() + _tso_segment_size - 1) / _tso_segment_size);
+    for (size_t offset = 0; offset < _payload.size(); offset += _tso_segment_size) {
+        TCPSegment piece;
+        piece._header = _header;
+        piece._header.seqno = _header.seqno + uint32_t(offset == 0 ? 0 : _header.syn + offset);
+        piece._header.syn = _header.syn and offset == 0;
+        piece._header.fin = _header.fin and offset + _tso_segment_size >= _payload.size();
+        piece._header.cwr = _header.cwr and offset == 0;
+        piece._ecn = _ecn;
+        piece._payload = _payload.substr(offset, _tso_segment_size);
+        ret.push_back(move(piece));
+    }
+    return ret;
+}
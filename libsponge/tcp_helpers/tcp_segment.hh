@@ -5,12 +5,15 @@
 #include "tcp_header.hh"
 
 #include <cstdint>
+#include <vector>
 
 //! \brief [TCP](\ref rfc::rfc793) segment
 class TCPSegment {
   private:
     TCPHeader _header{};
     Buffer _payload{};
+    size_t _tso_segment_size{0};  //!< TSO: payload size of the wire segments this one stands for
+    uint8_t _ecn{0};              //!< ECN codepoint of the datagram that carries it (IPv4Header::ECN_NOT_ECT etc.)
 
   public:
     //! \brief Parse the segment from a string
@@ -28,6 +31,29 @@ class TCPSegment {
     Buffer &payload() { return _payload; }
     //!@}
 
+    //! \name TSO: late segmentation
+    //! A sender using TSO emits a super-segment: one header for a burst of payload that goes on the wire
+    //! as several segments of at most tso_segment_size() bytes each. The adapter that writes it splits it.
+    //!@{
+
+    //! Payload size of the wire segments this segment stands for (0: it goes on the wire as it is)
+    size_t tso_segment_size() const { return _tso_segment_size; }
+    void set_tso_segment_size(const size_t size) { _tso_segment_size = size; }  //!< Make it a super-segment
+
+    //! \brief The segments that go on the wire for this one
+    //! \details Each has a copy of the header, with the seqno advanced; SYN and CWR stay on the first
+    //! and FIN moves to the last. The payloads are slices of this segment's, not copies.
+    std::vector<TCPSegment> wire_segments() const;
+    //!@}
+
+    //! \name ECN: the codepoint of the IP datagram that carries this segment
+    //! The sender marks ECN-capable segments, a congested queue may change the mark to CE, and the
+    //! adapter copies it to and from the IP header.
+    //!@{
+    uint8_t ecn() const { return _ecn; }                         //!< The ECN codepoint
+    void set_ecn(const uint8_t codepoint) { _ecn = codepoint; }  //!< Set the ECN codepoint
+    //!@}
+
     //! \brief Segment's length in sequence space
     //! \note Equal to payload length plus one byte if SYN is set, plus one byte if FIN is set
     size_t length_in_sequence_space() const;
@@ -0,0 +1,183 @@
+#include "tcp_sharded_engine.hh"
+
+#include "util.hh"
+
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+
+using namespace std;
+
+TCPShardedEngine::TCPShardedEngine(const size_t n_shards,
+                                   const TCPConfig &config,
+                                   const AppCallbackT &app,
+                                   const size_t queue_depth)
+    : _config(config), _app(app) {
+    if (n_shards == 0 or n_shards > INDIRECTION_TABLE_SIZE) {
+        throw runtime_error("TCPShardedEngine: invalid number of shards");
+    }
+
+    for (size_t i = 0; i < n_shards; i++) {
+        _shards.push_back(make_unique<Shard>(queue_depth));
+    }
+
+    // spread the hash buckets round-robin over the shards, as a NIC driver does by default
+    for (size_t i = 0; i < INDIRECTION_TABLE_SIZE; i++) {
+        _indirection[i] = i % n_shards;
+    }
+}
+
+TCPShardedEngine::~TCPShardedEngine() {
+    try {
+        stop();
+    } catch (const exception &e) {
+        cerr << "Exception destructing TCPShardedEngine: " << e.what() << endl;
+    }
+}
+
+void TCPShardedEngine::start() {
+    if (_running.exchange(true)) {
+        throw runtime_error("TCPShardedEngine: already started");
+    }
+    for (auto &shard : _shards) {
+        shard->thread = thread(&TCPShardedEngine::_shard_main, this, ref(*shard));
+    }
+}
+
+void TCPShardedEngine::stop() {
+    _running.store(false);
+    for (auto &shard : _shards) {
+        if (shard->thread.joinable()) {
+            shard->thread.join();
+        }
+    }
+}
+
+//! \param[in] key identifies the connection, from the local endpoint's point of view
+//! \param[in] segment is the inbound segment
+bool TCPShardedEngine::dispatch(const FlowKey &key, TCPSegment &&segment) {
+    Shard &shard = *_shards[shard_of(key)];
+    Ingress item;
+    item.flow.key = key;
+    item.flow.segment = move(segment);
+    if (not shard.ingress.push(move(item))) {
+        shard.stats.ingress_drops++;
+        return false;
+    }
+    return true;
+}
+
+//! \param[in] key identifies the new connection, from the local endpoint's point of view
+bool TCPShardedEngine::connect(const FlowKey &key) {
+    Ingress item;
+    item.connect = true;
+    item.flow.key = key;
+    return _shards[shard_of(key)]->ingress.push(move(item));
+}
+
+size_t TCPShardedEngine::poll_outbound(const function<void(FlowSegment &&)> &sink) {
+    size_t count = 0;
+    FlowSegment out;
+    for (auto &shard : _shards) {
+        while (shard->egress.pop(out)) {
+            sink(move(out));
+            count++;
+        }
+    }
+    return count;
+}
+
+size_t TCPShardedEngine::active_connections() const {
+    size_t total = 0;
+    for (const auto &shard : _shards) {
+        total += shard->stats.connections.load();
+    }
+    return total;
+}
+
+void TCPShardedEngine::_handle_ingress(Shard &shard, Ingress &&item) {
+    const FlowKey &key = item.flow.key;
+    auto conn = shard.connections.find(key);
+
+    if (item.connect) {
+        if (conn != shard.connections.end()) {
+            shard.stats.duplicate_connects++;
+            return;
+        }
+        conn = shard.connections.emplace(key, _config).first;
+        conn->second.connect();
+        return;
+    }
+
+    if (conn == shard.connections.end()) {
+        // only a SYN to a listening port may create a connection
+        const TCPHeader &header = item.flow.segment.header();
+        if (not header.syn or header.rst or header.ack or not _listening_ports.count(key.local_port)) {
+            return;
+        }
+        conn = shard.connections.emplace(key, _config).first;
+    }
+
+    shard.stats.segments_received++;
+    conn->second.segment_received(item.flow.segment);
+}
+
+void TCPShardedEngine::_collect_outbound(Shard &shard, const FlowKey &key, TCPConnection &conn) {
+    auto &segments = conn.segments_out();
+    while (not segments.empty()) {
+        FlowSegment out;
+        out.key = key;
+        out.segment = move(segments.front());
+        segments.pop();
+        shard.backlog.push_back(move(out));
+    }
+}
+
+void TCPShardedEngine::_shard_main(Shard &shard) {
+    try {
+        Stopwatch stopwatch{_config.time_source()};
+        Ingress item;
+        while (_running.load(memory_order_relaxed)) {
+            // 1) deliver inbound segments (and connect requests) to their connections
+            bool busy = false;
+            while (shard.ingress.pop(item)) {
+                _handle_ingress(shard, move(item));
+                busy = true;
+            }
+
+            // 2) let time pass, run the application, and gather what each connection wants to send
+            const uint64_t elapsed = stopwatch.lap_us();
+            for (auto it = shard.connections.begin(); it != shard.connections.end();) {
+                TCPConnection &conn = it->second;
+                if (elapsed > 0) {
+                    conn.tick_us(elapsed);
+                }
+                if (conn.active()) {
+                    _app(it->first, conn);
+                }
+                _collect_outbound(shard, it->first, conn);
+                if (not conn.active()) {
+                    it = shard.connections.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            shard.stats.connections.store(shard.connections.size());
+
+            // 3) hand outbound segments to the dispatcher
+            while (not shard.backlog.empty() and shard.egress.push(move(shard.backlog.front()))) {
+                shard.backlog.pop_front();
+                shard.stats.segments_sent++;
+                busy = true;
+            }
+
+            if (not busy) {
+                this_thread::yield();
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception in TCPShardedEngine worker thread: " << e.what() << "\n";
+        throw;
+    }
+}
@@ -0,0 +1,160 @@
+#ifndef SPONGE_LIBSPONGE_TCP_SHARDED_ENGINE_HH
+#define SPONGE_LIBSPONGE_TCP_SHARDED_ENGINE_HH
+
+#include "flow_key.hh"
+#include "spsc_queue.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_segment.hh"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <set>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+//! \brief Runs many TCPConnection objects on a fixed pool of worker threads ("shards")
+//! \details Every connection is owned by exactly one shard, chosen by the RSSHash of its
+//! 4-tuple through an RSS-style indirection table. The shard count and table are fixed at
+//! construction, so a connection is never migrated: all of its segments, ticks and
+//! application callbacks run on the same thread, and no TCPConnection is ever locked.
+//!
+//! A single "dispatcher" thread (the owner) feeds inbound segments to the engine with
+//! dispatch() and drains outbound segments with poll_outbound(); each shard talks to the
+//! dispatcher through a pair of lock-free SPSCQueue objects.
+class TCPShardedEngine {
+  public:
+    //! \brief Application hook, called on the owning shard's thread after the connection has made progress
+    //! \note The callback may write to, read from, or end the streams of the connection,
+    //! but must not block.
+    using AppCallbackT = std::function<void(const FlowKey &, TCPConnection &)>;
+
+    //! A segment, together with the connection it belongs to
+    struct FlowSegment {
+        FlowKey key{};         //!< Connection (from the local endpoint's point of view)
+        TCPSegment segment{};  //!< The segment itself
+    };
+
+    //! Per-shard counters, readable from any thread
+    struct ShardStats {
+        std::atomic<uint64_t> segments_received{0};   //!< Segments given to TCPConnection::segment_received
+        std::atomic<uint64_t> segments_sent{0};       //!< Segments handed back to the dispatcher
+        std::atomic<uint64_t> connections{0};         //!< Connections currently owned by the shard
+        std::atomic<uint64_t> ingress_drops{0};       //!< Segments dropped because the shard's queue was full
+        std::atomic<uint64_t> duplicate_connects{0};  //!< connect() calls ignored: the connection already existed
+    };
+
+    static constexpr size_t INDIRECTION_TABLE_SIZE = 128;  //!< Entries in the RSS indirection table
+    static constexpr size_t DEFAULT_QUEUE_DEPTH = 4096;    //!< Default capacity of each ingress/egress queue
+
+  private:
+    //! Work item handed from the dispatcher to a shard
+    struct Ingress {
+        bool connect{false};  //!< `true` to open a new connection to `flow.key`, `false` to deliver `flow.segment`
+        FlowSegment flow{};   //!< Connection and (unless `connect`) segment
+    };
+
+    //! State owned by one worker thread
+    struct Shard {
+        SPSCQueue<Ingress> ingress;     //!< dispatcher -> shard
+        SPSCQueue<FlowSegment> egress;  //!< shard -> dispatcher
+        std::unordered_map<FlowKey, TCPConnection, FlowKeyHash> connections{};  //!< Connections owned by this shard
+        std::deque<FlowSegment> backlog{};  //!< Outbound segments that did not fit into `egress`
+        ShardStats stats{};                 //!< Counters
+        std::thread thread{};               //!< The worker thread
+
+        explicit Shard(const size_t queue_depth) : ingress(queue_depth), egress(queue_depth) {}
+    };
+
+    TCPConfig _config;                                            //!< Configuration for every new connection
+    AppCallbackT _app;                                            //!< Application hook
+    RSSHash _hash{};                                              //!< Flow hash
+    std::set<uint16_t> _listening_ports{};                        //!< Local ports that accept incoming SYNs
+    std::array<uint16_t, INDIRECTION_TABLE_SIZE> _indirection{};  //!< hash bucket -> shard
+    std::vector<std::unique_ptr<Shard>> _shards{};                //!< The shards
+    std::atomic_bool _running{false};                             //!< Cleared to stop the workers
+
+    //! Main loop of a worker thread
+    void _shard_main(Shard &shard);
+
+    //! Deliver one work item to a connection on `shard`, creating the connection if appropriate
+    void _handle_ingress(Shard &shard, Ingress &&item);
+
+    //! Move a connection's outbound segments into the shard's egress queue (or backlog)
+    void _collect_outbound(Shard &shard, const FlowKey &key, TCPConnection &conn);
+
+  public:
+    //! \brief Construct an engine with `n_shards` worker threads
+    //! \param[in] n_shards is the number of worker threads (and connection tables)
+    //! \param[in] config is used for every connection the engine creates
+    //! \param[in] app is called on the owning shard whenever a connection has been serviced
+    //! \param[in] queue_depth is the capacity of each shard's ingress and egress queues
+    TCPShardedEngine(const size_t n_shards,
+                     const TCPConfig &config,
+                     const AppCallbackT &app,
+                     const size_t queue_depth = DEFAULT_QUEUE_DEPTH);
+
+    //! Stops the workers and destroys any connections they still own
+    ~TCPShardedEngine();
+
+    //! \name Configuration (call before start())
+    //!@{
+
+    //! Accept incoming connections (SYN segments) to local port `port`
+    void listen(const uint16_t port) { _listening_ports.insert(port); }
+    //!@}
+
+    //! \name Methods for the dispatcher thread
+    //!@{
+
+    //! Start the worker threads
+    void start();
+
+    //! Stop and join the worker threads
+    void stop();
+
+    //! Which shard owns the connection `key`? (A pure function of the 4-tuple.)
+    size_t shard_of(const FlowKey &key) const { return _indirection[_hash(key) % INDIRECTION_TABLE_SIZE]; }
+
+    //! \brief Steer an inbound segment to the shard that owns its connection
+    //! \returns `false` if the shard's queue was full and the segment was dropped
+    bool dispatch(const FlowKey &key, TCPSegment &&segment);
+
+    //! \brief Open a connection (send a SYN) on the shard that owns `key`
+    //! \returns `false` if the shard's queue was full
+    //! \note The shard checks for an existing connection to `key` later, on its own thread; if there
+    //! is one, the request is ignored and counted in ShardStats::duplicate_connects.
+    bool connect(const FlowKey &key);
+
+    //! \brief Hand every outbound segment that the shards have produced to `sink`
+    //! \returns the number of segments delivered
+    size_t poll_outbound(const std::function<void(FlowSegment &&)> &sink);
+    //!@}
+
+    //! \name Accessors
+    //!@{
+    size_t shard_count() const { return _shards.size(); }
+    const ShardStats &stats(const size_t shard) const { return _shards.at(shard)->stats; }
+
+    //! Number of connections (over all shards) that are still active
+    size_t active_connections() const;
+    //!@}
+
+    //! \name
+    //! The engine owns running threads, so it cannot be copied or moved
+
+    //!@{
+    TCPShardedEngine(const TCPShardedEngine &other) = delete;
+    TCPShardedEngine &operator=(const TCPShardedEngine &other) = delete;
+    TCPShardedEngine(TCPShardedEngine &&other) = delete;
+    TCPShardedEngine &operator=(TCPShardedEngine &&other) = delete;
+    //!@}
+};
+
+#endif  // SPONGE_LIBSPONGE_TCP_SHARDED_ENGINE_HH
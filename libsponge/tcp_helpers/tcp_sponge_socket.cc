@@ -5,11 +5,15 @@
 #include "tun.hh"
 #include "util.hh"
 
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
 #include <cstddef>
 #include <exception>
 #include <iostream>
 #include <stdexcept>
 #include <string>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
 #include <sys/syscall.h>
 #include <sys/types.h>
@@ -21,38 +25,44 @@ using namespace std;
 static constexpr size_t TCP_TICK_MS = 10;
 
 //! \param[in] condition is a function returning true if loop should continue
-template <typename AdaptT>
-void TCPSpongeSocket<AdaptT>::_tcp_loop(const function<bool()> &condition) {
-    auto base_time = timestamp_ms();
+template <typename AdaptT, typename StreamT>
+void TCPSpongeSocket<AdaptT, StreamT>::_tcp_loop(const function<bool()> &condition) {
+    Stopwatch stopwatch{_clock ? *_clock : MonotonicClock::instance()};
     while (condition()) {
-        auto ret = _eventloop.wait_next_event(TCP_TICK_MS);
+        // sleep until the next tick, or until pacing releases the next segment or a delayed ACK is due if sooner
+        uint64_t timeout_us = TCP_TICK_MS * 1000;
+        if (_tcp.has_value()) {
+            timeout_us = min(timeout_us, _tcp.value().time_until_release_us().value_or(timeout_us));
+            timeout_us = min(timeout_us, _tcp.value().time_until_ack_us().value_or(timeout_us));
+        }
+        auto ret = _eventloop.wait_next_event(chrono::microseconds{timeout_us});
         if (ret == EventLoop::Result::Exit or _abort) {
             break;
         }
 
         if (_tcp.value().active()) {
-            const auto next_time = timestamp_ms();
-            _tcp.value().tick(next_time - base_time);
-            _datagram_adapter.tick(next_time - base_time);
-            base_time = next_time;
+            const uint64_t elapsed = stopwatch.lap_us();
+            _tcp.value().tick_us(elapsed);
+            _datagram_adapter.tick_us(elapsed);
         }
     }
 }
 
 //! \param[in] data_socket_pair is a pair of connected AF_UNIX SOCK_STREAM sockets
 //! \param[in] datagram_interface is the interface for reading and writing datagrams
-template <typename AdaptT>
-TCPSpongeSocket<AdaptT>::TCPSpongeSocket(pair<FileDescriptor, FileDescriptor> data_socket_pair,
-                                         AdaptT &&datagram_interface)
-    : LocalStreamSocket(move(data_socket_pair.first))
+template <typename AdaptT, typename StreamT>
+TCPSpongeSocket<AdaptT, StreamT>::TCPSpongeSocket(pair<StreamT, StreamT> data_socket_pair,
+                                                  AdaptT &&datagram_interface)
+    : StreamT(move(data_socket_pair.first))
     , _thread_data(move(data_socket_pair.second))
     , _datagram_adapter(move(datagram_interface)) {
     _thread_data.set_blocking(false);
 }
 
-template <typename AdaptT>
-void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
+template <typename AdaptT, typename StreamT>
+void TCPSpongeSocket<AdaptT, StreamT>::_initialize_TCP(const TCPConfig &config) {
     _tcp.emplace(config);
+    _clock = config.clock;
 
     // Set up the event loop
 
@@ -120,9 +130,10 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
         });
 
     // rule 3: read from inbound buffer into pipe
+    const auto [writable_fd, writable_direction] = poll_for_write(_thread_data);
     _eventloop.add_rule(
-        _thread_data,
-        Direction::Out,
+        writable_fd,
+        writable_direction,
         [&] {
             ByteStream &inbound = _tcp->inbound_stream();
             // Write from the inbound_stream into
@@ -171,13 +182,28 @@ static inline pair<FileDescriptor, FileDescriptor> socket_pair_helper(const int
     return {FileDescriptor(fds[0]), FileDescriptor(fds[1])};
 }
 
+//! A connected pair of streams between the owner and the TCP thread
+template <typename StreamT>
+static pair<StreamT, StreamT> stream_pair_helper();
+
+template <>
+pair<LocalStreamSocket, LocalStreamSocket> stream_pair_helper() {
+    auto [a, b] = socket_pair_helper(SOCK_STREAM);
+    return {LocalStreamSocket(move(a)), LocalStreamSocket(move(b))};
+}
+
+template <>
+pair<ShmStream, ShmStream> stream_pair_helper() {
+    return ShmStream::connected_pair();
+}
+
 //! \param[in] datagram_interface is the underlying interface (e.g. to UDP, IP, or Ethernet)
-template <typename AdaptT>
-TCPSpongeSocket<AdaptT>::TCPSpongeSocket(AdaptT &&datagram_interface)
-    : TCPSpongeSocket(socket_pair_helper(SOCK_STREAM), move(datagram_interface)) {}
+template <typename AdaptT, typename StreamT>
+TCPSpongeSocket<AdaptT, StreamT>::TCPSpongeSocket(AdaptT &&datagram_interface)
+    : TCPSpongeSocket(stream_pair_helper<StreamT>(), move(datagram_interface)) {}
 
-template <typename AdaptT>
-TCPSpongeSocket<AdaptT>::~TCPSpongeSocket() {
+template <typename AdaptT, typename StreamT>
+TCPSpongeSocket<AdaptT, StreamT>::~TCPSpongeSocket() {
     try {
         if (_tcp_thread.joinable()) {
             cerr << "Warning: unclean shutdown of TCPSpongeSocket\n";
@@ -190,9 +216,9 @@ TCPSpongeSocket<AdaptT>::~TCPSpongeSocket() {
     }
 }
 
-template <typename AdaptT>
-void TCPSpongeSocket<AdaptT>::wait_until_closed() {
-    shutdown(SHUT_RDWR);
+template <typename AdaptT, typename StreamT>
+void TCPSpongeSocket<AdaptT, StreamT>::wait_until_closed() {
+    this->shutdown(SHUT_RDWR);
     if (_tcp_thread.joinable()) {
         cerr << "DEBUG: Waiting for clean shutdown... ";
         _tcp_thread.join();
@@ -202,8 +228,8 @@ void TCPSpongeSocket<AdaptT>::wait_until_closed() {
 
 //! \param[in] c_tcp is the TCPConfig for the TCPConnection
 //! \param[in] c_ad is the FdAdapterConfig for the FdAdapter
-template <typename AdaptT>
-void TCPSpongeSocket<AdaptT>::connect(const TCPConfig &c_tcp, const FdAdapterConfig &c_ad) {
+template <typename AdaptT, typename StreamT>
+void TCPSpongeSocket<AdaptT, StreamT>::_send_syn(const TCPConfig &c_tcp, const FdAdapterConfig &c_ad) {
     if (_tcp) {
         throw runtime_error("connect() with TCPConnection already initialized");
     }
@@ -221,6 +247,13 @@ void TCPSpongeSocket<AdaptT>::connect(const TCPConfig &c_tcp, const FdAdapterCon
         throw runtime_error("After TCPConnection::connect(), state was " + _tcp->state().name() + " but expected " +
                             expected_state.name());
     }
+}
+
+//! \param[in] c_tcp is the TCPConfig for the TCPConnection
+//! \param[in] c_ad is the FdAdapterConfig for the FdAdapter
+template <typename AdaptT, typename StreamT>
+void TCPSpongeSocket<AdaptT, StreamT>::connect(const TCPConfig &c_tcp, const FdAdapterConfig &c_ad) {
+    _send_syn(c_tcp, c_ad);
 
     _tcp_loop([&] { return _tcp->state() == TCPState::State::SYN_SENT; });
     cerr << "Successfully connected to " << c_ad.destination.to_string() << ".\n";
@@ -230,8 +263,53 @@ void TCPSpongeSocket<AdaptT>::connect(const TCPConfig &c_tcp, const FdAdapterCon
 
 //! \param[in] c_tcp is the TCPConfig for the TCPConnection
 //! \param[in] c_ad is the FdAdapterConfig for the FdAdapter
-template <typename AdaptT>
-void TCPSpongeSocket<AdaptT>::listen_and_accept(const TCPConfig &c_tcp, const FdAdapterConfig &c_ad) {
+//! \details The handshake runs on the TCPConnection thread, which then carries on as usual.
+//! When the handshake is over, the thread adds 1 (established) or 2 (failed, or an exception was
+//! thrown) to an [eventfd](\ref man2::eventfd), so the owner can wait for it in an event loop.
+template <typename AdaptT, typename StreamT>
+FileDescriptor TCPSpongeSocket<AdaptT, StreamT>::start_connect(const TCPConfig &c_tcp, const FdAdapterConfig &c_ad) {
+    _send_syn(c_tcp, c_ad);
+
+    FileDescriptor notification{SystemCall("eventfd", ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))};
+    FileDescriptor thread_end{SystemCall("dup", ::dup(notification.fd_num()))};
+    _tcp_thread = thread([this, fd = move(thread_end)] {
+        try {
+            _tcp_loop([&] { return _tcp->state() == TCPState::State::SYN_SENT; });
+            const bool established = _tcp->active() and _tcp->state() != TCPState::State::SYN_SENT;
+            SystemCall("eventfd_write", ::eventfd_write(fd.fd_num(), established ? 1 : 2));
+        } catch (const exception &e) {
+            // the owner learns of the failure from finish_connect()
+            cerr << "Exception in TCPConnection runner thread during handshake: " << e.what() << "\n";
+            ::eventfd_write(fd.fd_num(), 2);
+            return;
+        }
+        _tcp_main();
+    });
+
+    return notification;
+}
+
+//! \details The notification may not have arrived yet even if `notification` was reported
+//! readable (e.g. by a wakeup meant for something else); then nothing is consumed.
+template <typename AdaptT, typename StreamT>
+bool TCPSpongeSocket<AdaptT, StreamT>::finish_connect(FileDescriptor &notification) {
+    eventfd_t outcome = 0;
+    if (SystemCall("eventfd_read", ::eventfd_read(notification.fd_num(), &outcome), EAGAIN) < 0) {
+        return false;
+    }
+    notification.close();
+    if (outcome != 1) {
+        throw runtime_error("connect: connection to " + _datagram_adapter.config().destination.to_string() +
+                            " was not established");
+    }
+    cerr << "Successfully connected to " << _datagram_adapter.config().destination.to_string() << ".\n";
+    return true;
+}
+
+//! \param[in] c_tcp is the TCPConfig for the TCPConnection
+//! \param[in] c_ad is the FdAdapterConfig for the FdAdapter
+template <typename AdaptT, typename StreamT>
+void TCPSpongeSocket<AdaptT, StreamT>::listen_and_accept(const TCPConfig &c_tcp, const FdAdapterConfig &c_ad) {
     if (_tcp) {
         throw runtime_error("listen_and_accept() with TCPConnection already initialized");
     }
@@ -251,14 +329,14 @@ void TCPSpongeSocket<AdaptT>::listen_and_accept(const TCPConfig &c_tcp, const Fd
     _tcp_thread = thread(&TCPSpongeSocket::_tcp_main, this);
 }
 
-template <typename AdaptT>
-void TCPSpongeSocket<AdaptT>::_tcp_main() {
+template <typename AdaptT, typename StreamT>
+void TCPSpongeSocket<AdaptT, StreamT>::_tcp_main() {
     try {
         if (not _tcp.has_value()) {
             throw runtime_error("no TCP");
         }
         _tcp_loop([] { return true; });
-        shutdown(SHUT_RDWR);
+        this->shutdown(SHUT_RDWR);
         if (not _tcp.value().active()) {
             cerr << "DEBUG: TCP connection finished "
                  << (_tcp.value().state() == TCPState::State::RESET ? "uncleanly" : "cleanly.\n");
@@ -285,19 +363,41 @@ template class TCPSpongeSocket<LossyTCPOverUDPSocketAdapter>;
 //! Specialization of TCPSpongeSocket for LossyTCPOverIPv4OverTunFdAdapter
 template class TCPSpongeSocket<LossyTCPOverIPv4OverTunFdAdapter>;
 
+//! Specialization of TCPSpongeSocket for AqmTCPOverIPv4OverTunFdAdapter
+template class TCPSpongeSocket<AqmTCPOverIPv4OverTunFdAdapter>;
+
+//! Specialization of TCPSpongeSocket for TCPOverUDPSocketAdapter, with a shared-memory owner stream
+template class TCPSpongeSocket<TCPOverUDPSocketAdapter, ShmStream>;
+
+//! Specialization of TCPSpongeSocket for TCPOverIPv4OverTunFdAdapter, with a shared-memory owner stream
+template class TCPSpongeSocket<TCPOverIPv4OverTunFdAdapter, ShmStream>;
+
 CS144TCPSocket::CS144TCPSocket() : TCPOverIPv4SpongeSocket(TCPOverIPv4OverTunFdAdapter(TunFD("tun144"))) {}
 
-void CS144TCPSocket::connect(const Address &address) {
+//! Configurations used by the CS144TCPSocket and FullStackSocket helpers to reach `address`
+static pair<TCPConfig, FdAdapterConfig> helper_configs(const string &local_address, const Address &address) {
     TCPConfig tcp_config;
     tcp_config.rt_timeout = 100;
 
     FdAdapterConfig multiplexer_config;
-    multiplexer_config.source = {"169.254.144.9", to_string(uint16_t(random_device()()))};
+    multiplexer_config.source = {local_address, to_string(uint16_t(random_device()()))};
     multiplexer_config.destination = address;
 
+    return {tcp_config, multiplexer_config};
+}
+
+static const string LOCAL_TUN_IP_ADDRESS = "169.254.144.9";
+
+void CS144TCPSocket::connect(const Address &address) {
+    const auto [tcp_config, multiplexer_config] = helper_configs(LOCAL_TUN_IP_ADDRESS, address);
     TCPOverIPv4SpongeSocket::connect(tcp_config, multiplexer_config);
 }
 
+FileDescriptor CS144TCPSocket::start_connect(const Address &address) {
+    const auto [tcp_config, multiplexer_config] = helper_configs(LOCAL_TUN_IP_ADDRESS, address);
+    return TCPOverIPv4SpongeSocket::start_connect(tcp_config, multiplexer_config);
+}
+
 static const string LOCAL_TAP_IP_ADDRESS = "169.254.10.9";
 static const string LOCAL_TAP_NEXT_HOP_ADDRESS = "169.254.10.1";
 
@@ -319,12 +419,11 @@ FullStackSocket::FullStackSocket()
                                                                          Address(LOCAL_TAP_NEXT_HOP_ADDRESS, "0"))) {}
 
 void FullStackSocket::connect(const Address &address) {
-    TCPConfig tcp_config;
-    tcp_config.rt_timeout = 100;
-
-    FdAdapterConfig multiplexer_config;
-    multiplexer_config.source = {LOCAL_TAP_IP_ADDRESS, to_string(uint16_t(random_device()()))};
-    multiplexer_config.destination = address;
-
+    const auto [tcp_config, multiplexer_config] = helper_configs(LOCAL_TAP_IP_ADDRESS, address);
     TCPOverIPv4OverEthernetSpongeSocket::connect(tcp_config, multiplexer_config);
 }
+
+FileDescriptor FullStackSocket::start_connect(const Address &address) {
+    const auto [tcp_config, multiplexer_config] = helper_configs(LOCAL_TAP_IP_ADDRESS, address);
+    return TCPOverIPv4OverEthernetSpongeSocket::start_connect(tcp_config, multiplexer_config);
+}
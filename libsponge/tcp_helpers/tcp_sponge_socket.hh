@@ -2,26 +2,32 @@
 #define SPONGE_LIBSPONGE_TCP_SPONGE_SOCKET_HH
 
 #include "byte_stream.hh"
+#include "clock.hh"
 #include "eventloop.hh"
 #include "fd_adapter.hh"
 #include "file_descriptor.hh"
 #include "network_interface.hh"
+#include "shm_stream.hh"
 #include "tcp_config.hh"
 #include "tcp_connection.hh"
 #include "tuntap_adapter.hh"
 
 #include <atomic>
 #include <cstdint>
+#include <memory>
 #include <optional>
 #include <thread>
 #include <vector>
 
 //! Multithreaded wrapper around TCPConnection that approximates the Unix sockets API
-template <typename AdaptT>
-class TCPSpongeSocket : public LocalStreamSocket {
+//! \tparam AdaptT carries segments to and from the network
+//! \tparam StreamT carries the byte streams between the owner and the TCP thread: a LocalStreamSocket
+//! (a kernel socketpair), or a ShmStream (rings in shared memory)
+template <typename AdaptT, typename StreamT = LocalStreamSocket>
+class TCPSpongeSocket : public StreamT {
   private:
-    //! Stream socket for reads and writes between owner and TCP thread
-    LocalStreamSocket _thread_data;
+    //! Stream for reads and writes between owner and TCP thread
+    StreamT _thread_data;
 
   protected:
     //! Adapter to underlying datagram socket (e.g., UDP or IP)
@@ -34,6 +40,9 @@ class TCPSpongeSocket : public LocalStreamSocket {
     //! TCP state machine
     std::optional<TCPConnection> _tcp{};
 
+    //! Time source for the TCP thread (TCPConfig::clock; empty means the MonotonicClock)
+    std::shared_ptr<const Clock> _clock{};
+
     //! eventloop that handles all the events (new inbound datagram, new outbound bytes, new inbound bytes)
     EventLoop _eventloop{};
 
@@ -43,11 +52,14 @@ class TCPSpongeSocket : public LocalStreamSocket {
     //! Main loop of TCPConnection thread
     void _tcp_main();
 
+    //! Set up the TCPConnection and send the SYN (shared by connect() and start_connect())
+    void _send_syn(const TCPConfig &c_tcp, const FdAdapterConfig &c_ad);
+
     //! Handle to the TCPConnection thread; owner thread calls join() in the destructor
     std::thread _tcp_thread{};
 
-    //! Construct LocalStreamSocket fds from socket pair, initialize eventloop
-    TCPSpongeSocket(std::pair<FileDescriptor, FileDescriptor> data_socket_pair, AdaptT &&datagram_interface);
+    //! Construct from a connected pair of streams, initialize eventloop
+    TCPSpongeSocket(std::pair<StreamT, StreamT> data_socket_pair, AdaptT &&datagram_interface);
 
     std::atomic_bool _abort{false};  //!< Flag used by the owner to force the TCPConnection thread to shut down
 
@@ -69,6 +81,15 @@ class TCPSpongeSocket : public LocalStreamSocket {
     //! Connect using the specified configurations; blocks until connect succeeds or fails
     void connect(const TCPConfig &c_tcp, const FdAdapterConfig &c_ad);
 
+    //! \brief Start connecting using the specified configurations, without blocking
+    //! \returns a FileDescriptor that becomes readable when the handshake has finished;
+    //! pass it to finish_connect() to learn the outcome
+    FileDescriptor start_connect(const TCPConfig &c_tcp, const FdAdapterConfig &c_ad);
+
+    //! \brief Consume the notification from start_connect(); throws if the connection was not established
+    //! \returns false if the notification hasn't arrived yet (wait for `notification` to be readable again)
+    bool finish_connect(FileDescriptor &notification);
+
     //! Listen and accept using the specified configurations; blocks until accept succeeds or fails
     void listen_and_accept(const TCPConfig &c_tcp, const FdAdapterConfig &c_ad);
 
@@ -102,6 +123,10 @@ using TCPOverIPv4OverEthernetSpongeSocket = TCPSpongeSocket<TCPOverIPv4OverEther
 
 using LossyTCPOverUDPSpongeSocket = TCPSpongeSocket<LossyTCPOverUDPSocketAdapter>;
 using LossyTCPOverIPv4SpongeSocket = TCPSpongeSocket<LossyTCPOverIPv4OverTunFdAdapter>;
+using AqmTCPOverIPv4SpongeSocket = TCPSpongeSocket<AqmTCPOverIPv4OverTunFdAdapter>;
+
+using ShmTCPOverUDPSpongeSocket = TCPSpongeSocket<TCPOverUDPSocketAdapter, ShmStream>;
+using ShmTCPOverIPv4SpongeSocket = TCPSpongeSocket<TCPOverIPv4OverTunFdAdapter, ShmStream>;
 
 //! \class TCPSpongeSocket
 //! This class involves the simultaneous operation of two threads.
@@ -128,6 +153,7 @@ class CS144TCPSocket : public TCPOverIPv4SpongeSocket {
   public:
     CS144TCPSocket();
     void connect(const Address &address);
+    FileDescriptor start_connect(const Address &address);
 };
 
 //! Helper class that makes a TCPOverIPv4overEthernetSpongeSocket behave more like a (kernel) TCPSocket
@@ -138,6 +164,7 @@ class FullStackSocket : public TCPOverIPv4OverEthernetSpongeSocket {
     //! those IP datagrams in Ethernet frames sent to the Ethernet address of the next hop.
     FullStackSocket();
     void connect(const Address &address);
+    FileDescriptor start_connect(const Address &address);
 };
 
 #endif  // SPONGE_LIBSPONGE_TCP_SPONGE_SOCKET_HH
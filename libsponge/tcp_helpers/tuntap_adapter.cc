@@ -36,15 +36,17 @@ optional<TCPSegment> TCPOverIPv4OverEthernetAdapter::read() {
     return {};
 }
 
-//! \param[in] ms_since_last_tick the number of milliseconds since the last call to this method
-void TCPOverIPv4OverEthernetAdapter::tick(const size_t ms_since_last_tick) {
-    _interface.tick(ms_since_last_tick);
+//! \param[in] us_since_last_tick the number of microseconds since the last call to this method
+void TCPOverIPv4OverEthernetAdapter::tick_us(const uint64_t us_since_last_tick) {
+    _interface.tick_us(us_since_last_tick);
     send_pending();
 }
 
 //! \param[in] seg the TCPSegment to send
 void TCPOverIPv4OverEthernetAdapter::write(TCPSegment &seg) {
-    _interface.send_datagram(wrap_tcp_in_ip(seg), _next_hop);
+    for (TCPSegment &wire_seg : seg.wire_segments()) {
+        _interface.send_datagram(wrap_tcp_in_ip(wire_seg), _next_hop);
+    }
     send_pending();
 }
 
@@ -57,3 +59,6 @@ void TCPOverIPv4OverEthernetAdapter::send_pending() {
 
 //! Specialize LossyFdAdapter to TCPOverIPv4OverTunFdAdapter
 template class LossyFdAdapter<TCPOverIPv4OverTunFdAdapter>;
+
+//! Specialize AqmFdAdapter to TCPOverIPv4OverTunFdAdapter
+template class AqmFdAdapter<TCPOverIPv4OverTunFdAdapter>;
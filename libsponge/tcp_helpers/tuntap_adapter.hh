@@ -1,6 +1,7 @@
 #ifndef SPONGE_LIBSPONGE_TUNFD_ADAPTER_HH
 #define SPONGE_LIBSPONGE_TUNFD_ADAPTER_HH
 
+#include "aqm_fd_adapter.hh"
 #include "ethernet_header.hh"
 #include "network_interface.hh"
 #include "tun.hh"
@@ -27,8 +28,12 @@ class TCPOverIPv4OverTunFdAdapter : public TCPOverIPv4Adapter {
         return unwrap_tcp_in_ip(ip_dgram);
     }
 
-    //! Creates an IPv4 datagram from a TCP segment and writes it to the TUN device
-    void write(TCPSegment &seg) { _tun.write(wrap_tcp_in_ip(seg).serialize()); }
+    //! Creates an IPv4 datagram from each wire segment of a TCP segment and writes it to the TUN device
+    void write(TCPSegment &seg) {
+        for (TCPSegment &wire_seg : seg.wire_segments()) {
+            _tun.write(wrap_tcp_in_ip(wire_seg).serialize());
+        }
+    }
 
     //! Access the underlying TUN device
     operator TunFD &() { return _tun; }
@@ -40,6 +45,9 @@ class TCPOverIPv4OverTunFdAdapter : public TCPOverIPv4Adapter {
 //! Typedef for TCPOverIPv4OverTunFdAdapter
 using LossyTCPOverIPv4OverTunFdAdapter = LossyFdAdapter<TCPOverIPv4OverTunFdAdapter>;
 
+//! Typedef for TCPOverIPv4OverTunFdAdapter with ECN-marking AQM (and losses)
+using AqmTCPOverIPv4OverTunFdAdapter = AqmFdAdapter<TCPOverIPv4OverTunFdAdapter>;
+
 //! \brief A FD adapter for IPv4 datagrams read from and written to a TAP device
 class TCPOverIPv4OverEthernetAdapter : public TCPOverIPv4Adapter {
   private:
@@ -63,8 +71,8 @@ class TCPOverIPv4OverEthernetAdapter : public TCPOverIPv4Adapter {
     //! Sends a TCP segment (in an IPv4 datagram, in an Ethernet frame).
     void write(TCPSegment &seg);
 
-    //! Called periodically when time elapses
-    void tick(const size_t ms_since_last_tick);
+    //! Called periodically when time elapses (in microseconds)
+    void tick_us(const uint64_t us_since_last_tick);
 
     //! Access the underlying raw Ethernet connection
     operator TapFD &() { return _tap; }
@@ -1,5 +1,8 @@
 #include "tcp_receiver.hh"
 
+#include "ipv4_header.hh"
+
+#include <algorithm>
 #include <iostream>
 
 // Dummy implementation of a TCP receiver
@@ -22,10 +25,27 @@ void TCPReceiver::segment_received(const TCPSegment &seg) {
         else
             index = unwrap(seg.header().seqno, _isn, _reassembler.stream_out().bytes_written() + 1) - 1;
 
+        if (seg.payload().size() > 0)
+            _last_segment_index = index;
+        _rcv_mss = max(_rcv_mss, seg.payload().size());
+        _ece = (_ece && !seg.header().cwr) || seg.ecn() == IPv4Header::ECN_CE;
         _reassembler.push_substring(seg.payload().copy(), index, seg.header().fin);
     }
 }
 
+bool TCPReceiver::in_order_data(const TCPSegment &seg) const {
+    const TCPHeader &header = seg.header();
+    return _syn && !header.syn && !header.fin && !header.cwr && seg.ecn() != IPv4Header::ECN_CE &&
+           seg.payload().size() > 0 && seg.payload().size() <= window_size() && _reassembler.empty() &&
+           !stream_out().input_ended() && header.seqno == *ackno();
+}
+
+void TCPReceiver::in_order_data_received(const TCPSegment &seg) {
+    _last_segment_index = stream_out().bytes_written();
+    _rcv_mss = max(_rcv_mss, seg.payload().size());
+    _reassembler.push_in_order(seg.payload());
+}
+
 optional<WrappingInt32> TCPReceiver::ackno() const {
     if (!_syn)
         return std::nullopt;
@@ -36,3 +56,89 @@ optional<WrappingInt32> TCPReceiver::ackno() const {
 }
 
 size_t TCPReceiver::window_size() const { return _reassembler.stream_out().remaining_capacity(); }
+
+uint64_t TCPReceiver::_sws_window_edge(const size_t mss) const {
+    const uint64_t edge = stream_out().bytes_written() + window_size();
+    return edge >= _window_edge + min(mss, _capacity / 2) ? edge : _window_edge;
+}
+
+size_t TCPReceiver::advertise_window(const size_t mss) {
+    _window_edge = _sws_window_edge(mss);
+    const uint64_t written = stream_out().bytes_written();
+    return _window_edge > written ? _window_edge - written : 0;
+}
+
+bool TCPReceiver::window_update_due(const size_t mss) const {
+    const uint64_t written = stream_out().bytes_written();
+    const uint64_t edge = _sws_window_edge(mss);
+    const uint64_t advertised = _window_edge > written ? _window_edge - written : 0;
+    return edge != _window_edge && edge - written >= 2 * advertised;
+}
+
+//! \details The estimate leans towards the smallest samples, which include the least waiting.
+void TCPReceiver::rtt_sample(const uint64_t rtt_us) { _rtt_sample(rtt_us, false); }
+
+//! \param[in] upper_bound whether the sample may be any multiple of the round-trip time (then it
+//! can only lower the estimate)
+void TCPReceiver::_rtt_sample(const uint64_t rtt_us, const bool upper_bound) {
+    const uint64_t sample = max<uint64_t>(rtt_us, 1);
+    if (_rtt_us == 0 || sample < _rtt_us)
+        _rtt_us = sample;
+    else if (!upper_bound)
+        _rtt_us += (sample - _rtt_us) / 8;
+}
+
+//! \details Dynamic right-sizing, as in Linux (tcp_rcv_space_adjust()). The round-trip time is
+//! the time it takes the data at the right edge of an advertised window to arrive (at least one
+//! round trip; more if the sender doesn't fill the window). Once per round trip, if the application
+//! has read more than in any round trip before, the capacity becomes twice that (plus room for 16
+//! segments), or more while the rate grows, so that the window never keeps a sender in slow start
+//! from doubling.
+void TCPReceiver::tune_window(const uint64_t now_us) {
+    if (!_syn || _capacity >= _max_capacity)
+        return;
+    const ByteStream &stream = stream_out();
+    if (!_rtt_start_us) {
+        _rtt_start_us = now_us;
+        _rtt_edge = stream.bytes_written() + window_size();
+    } else if (stream.bytes_written() >= _rtt_edge) {
+        _rtt_sample(now_us - *_rtt_start_us, true);
+        _rtt_start_us.reset();
+    }
+
+    if (_rtt_us == 0 || now_us - _space_start_us < _rtt_us)
+        return;
+    const uint64_t copied = stream.bytes_read() - _space_start_read;
+    _space_start_us = now_us;
+    _space_start_read = stream.bytes_read();
+    if (copied <= _space)
+        return;
+    uint64_t target = 2 * copied + 16 * _rcv_mss;
+    if (_space != 0)
+        target += 2 * target * min(copied - _space, _space) / _space;
+    _space = copied;
+    _capacity = max<size_t>(_capacity, min<uint64_t>(target, _max_capacity));
+    _reassembler.grow_capacity(_capacity);
+}
+
+vector<TCPOptions::SackBlock> TCPReceiver::sack_blocks() const {
+    vector<TCPOptions::SackBlock> blocks;
+    if (!_syn)
+        return blocks;
+    const auto unassembled = _reassembler.unassembled_blocks();
+    // stream index i is sequence number i + 1 (the SYN comes first)
+    const auto to_sack = [&](const pair<uint64_t, uint64_t> &range) {
+        return TCPOptions::SackBlock{wrap(range.first + 1, _isn), wrap(range.second + 1, _isn)};
+    };
+    for (const auto &range : unassembled) {
+        if (range.first <= _last_segment_index && _last_segment_index < range.second)
+            blocks.push_back(to_sack(range));
+    }
+    for (const auto &range : unassembled) {
+        if (blocks.size() == TCPOptions::MAX_SACK_BLOCKS)
+            break;
+        if (!(range.first <= _last_segment_index && _last_segment_index < range.second))
+            blocks.push_back(to_sack(range));
+    }
+    return blocks;
+}
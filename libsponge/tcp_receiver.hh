@@ -7,6 +7,7 @@
 #include "wrapping_integers.hh"
 
 #include <optional>
+#include <vector>
 
 //! \brief The "receiver" part of a TCP implementation.
 
@@ -23,12 +24,48 @@ class TCPReceiver {
     WrappingInt32 _isn;
     bool _syn;
 
+    //! stream index of the last segment that carried data (the first SACK block is the one holding it)
+    uint64_t _last_segment_index{0};
+
+    //! \name Receive-buffer auto-tuning (see tune_window())
+    //!@{
+
+    size_t _max_capacity;  //!< the most `_capacity` may grow to (no tuning if it's the initial capacity)
+    size_t _rcv_mss{0};    //!< largest payload received, the peer's likely segment size
+
+    uint64_t _rtt_us{0};                      //!< the receiver's round-trip time estimate (0: none yet)
+    std::optional<uint64_t> _rtt_start_us{};  //!< when the current measurement started (empty: none running)
+    uint64_t _rtt_edge{0};                    //!< the measurement ends when data reaches this stream index
+
+    uint64_t _space_start_us{0};    //!< when the current count of bytes read started
+    uint64_t _space_start_read{0};  //!< bytes read by the application at that time
+    uint64_t _space{0};             //!< the most bytes the application has read in one round trip
+    //!@}
+
+    //! take in a round-trip time sample
+    void _rtt_sample(const uint64_t rtt_us, const bool upper_bound);
+
+    //! ECN: a segment arrived marked CE, and the sender hasn't answered with CWR since
+    bool _ece{false};
+
+    //! SWS avoidance: right edge of the window last advertised, as a stream index
+    uint64_t _window_edge{0};
+
+    //! SWS avoidance: the right edge of the window that may be advertised now
+    uint64_t _sws_window_edge(const size_t mss) const;
+
   public:
     //! \brief Construct a TCP receiver
     //!
     //! \param capacity the maximum number of bytes that the receiver will
     //!                 store in its buffers at any give time.
-    TCPReceiver(const size_t capacity) : _reassembler(capacity), _capacity(capacity), _isn(0), _syn(false) {}
+    TCPReceiver(const size_t capacity) : TCPReceiver(capacity, capacity) {}
+
+    //! \brief Construct a TCP receiver whose capacity tune_window() may grow
+    //! \param capacity the initial capacity
+    //! \param max_capacity the most the capacity may grow to
+    TCPReceiver(const size_t capacity, const size_t max_capacity)
+        : _reassembler(capacity), _capacity(capacity), _isn(0), _syn(false), _max_capacity(max_capacity) {}
 
     //! \name Accessors to provide feedback to the remote TCPSender
     //!@{
@@ -51,6 +88,25 @@ class TCPReceiver {
     //! accepted by the receiver) and (b) the sequence number of the
     //! beginning of the window (the ackno).
     size_t window_size() const;
+
+    //! \brief The [SACK](\ref rfc::rfc2018) blocks that should be sent to the peer
+    //! \details The blocks of data received beyond the ackno, at most TCPOptions::MAX_SACK_BLOCKS.
+    //! The block holding the most recently received segment comes first, then the others in order.
+    std::vector<TCPOptions::SackBlock> sack_blocks() const;
+
+    //! \brief The window to advertise, avoiding silly-window syndrome (RFC 1122 4.2.3.3)
+    //! \details The right edge of the window moves only by at least min(`mss`, half the capacity),
+    //! so a slow reader doesn't offer the sender one sliver of window after another. The edge
+    //! advertised is remembered.
+    size_t advertise_window(const size_t mss);
+
+    //! \brief Has the application read enough to justify a window update?
+    //! \details If advertise_window() would move the right edge and at least double the window.
+    bool window_update_due(const size_t mss) const;
+
+    //! \brief Should our ACKs carry ECE ([ECN](\ref rfc::rfc3168) echo)?
+    //! \details From a segment marked CE until one that carries CWR, so that a lost ACK doesn't lose the echo.
+    bool ece() const { return _ece; }
     //!@}
 
     //! \brief number of bytes stored but not yet reassembled
@@ -59,6 +115,33 @@ class TCPReceiver {
     //! \brief handle an inbound segment
     void segment_received(const TCPSegment &seg);
 
+    //! \name Header prediction (see TCPConfig::header_prediction)
+    //!@{
+
+    //! \brief Would `seg` only append its payload to the stream?
+    //! \details If it carries data that starts at the ackno and fits in the window, no SYN, FIN or
+    //! ECN signal, and nothing is held out of order.
+    bool in_order_data(const TCPSegment &seg) const;
+
+    //! \brief Take in a segment that in_order_data() accepted, as segment_received() would (but
+    //! without copying the payload)
+    void in_order_data_received(const TCPSegment &seg);
+    //!@}
+
+    //! \name Receive-buffer auto-tuning
+    //!@{
+
+    //! \brief The number of bytes the receiver may store now
+    size_t capacity() const { return _capacity; }
+
+    //! \brief Take in a round-trip time measured elsewhere (e.g. from a timestamp echo), in microseconds
+    void rtt_sample(const uint64_t rtt_us);
+
+    //! \brief Measure the round-trip time and how fast the application reads, and grow the capacity to match
+    //! \param[in] now_us the current time, in microseconds
+    void tune_window(const uint64_t now_us);
+    //!@}
+
     //! \name "Output" interface for the reader
     //!@{
     ByteStream &stream_out() { return _reassembler.stream_out(); }
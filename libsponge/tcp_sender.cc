@@ -1,7 +1,9 @@
 #include "tcp_sender.hh"
 
+#include "ipv4_header.hh"
 #include "tcp_config.hh"
 
+#include <algorithm>
 #include <iostream>
 #include <random>
 
@@ -17,23 +19,383 @@ using namespace std;
 //! \param[in] fixed_isn the Initial Sequence Number to use, if set (otherwise uses a random ISN)
 TCPSender::TCPSender(const size_t capacity, const uint16_t retx_timeout, const std::optional<WrappingInt32> fixed_isn)
     : _isn(fixed_isn.value_or(WrappingInt32{random_device()()}))
-    , _initial_retransmission_timeout{retx_timeout}
+    , _initial_retransmission_timeout{uint64_t(retx_timeout) * 1000}
     , _stream(capacity)
-    , _timer(retx_timeout) {}
+    , _timer(_initial_retransmission_timeout)
+    , _pacer(0, TCPConfig{}.pacing_burst)
+    , _mss(TCPConfig::MAX_PAYLOAD_SIZE) {}
+
+//! \param[in] cfg supplies the capacity, the initial retransmission timeout and the ISN
+TCPSender::TCPSender(const TCPConfig &cfg)
+    : _isn(cfg.fixed_isn.value_or(WrappingInt32{random_device()()}))
+    , _initial_retransmission_timeout{cfg.initial_rto_us()}
+    , _stream(cfg.send_capacity)
+    , _timer(_initial_retransmission_timeout)
+    , _rtt(cfg.adaptive_rto
+               ? make_optional<RttEstimator>(_initial_retransmission_timeout, cfg.rto_min_us, cfg.rto_max_us)
+               : nullopt)
+    , _cc(make_congestion_control(cfg))
+    , _pacer(0, cfg.pacing_burst)
+    , _configured_pacing_rate(cfg.pacing_rate)
+    , _mss(cfg.mss.value_or(TCPConfig::MAX_PAYLOAD_SIZE))
+    , _pmtu(cfg.plpmtud ? make_optional<PmtuSearch>(TCPConfig::MAX_PAYLOAD_SIZE, _mss) : nullopt)
+    , _tso_max_size(cfg.tso_max_size)
+    , _nagle(!cfg.nodelay)
+    , _sws_avoidance(cfg.sws_avoidance)
+    , _use_persist_timer(cfg.persist_timer)
+    , _max_persist_us(cfg.rto_max_us)
+    , _rack_tlp(cfg.rack_tlp)
+    , _sack(cfg.sack)
+    , _tlp_max_ack_delay_us(cfg.delayed_ack_us) {
+    if (_pmtu)
+        _use_mss(_pmtu->mss());
+}
+
+//! \details The first sample sets SRTT = R and RTTVAR = R/2; later ones move RTTVAR by 1/4 of the
+//! way towards |SRTT - R| and SRTT by 1/8 of the way towards R. RTO = SRTT + max(G, 4 RTTVAR),
+//! clamped to [min, max].
+void RttEstimator::sample(const uint64_t rtt_us) {
+    if (!_has_sample) {
+        _srtt_us = rtt_us;
+        _rttvar_us = rtt_us / 2;
+        _has_sample = true;
+    } else {
+        const uint64_t error = _srtt_us > rtt_us ? _srtt_us - rtt_us : rtt_us - _srtt_us;
+        _rttvar_us = (3 * _rttvar_us + error) / 4;
+        _srtt_us = (7 * _srtt_us + rtt_us) / 8;
+    }
+    _rto_us = clamp(_srtt_us + max(GRANULARITY_US, 4 * _rttvar_us), _min_rto_us, _max_rto_us);
+}
 
 uint64_t TCPSender::bytes_in_flight() const { return _out_seqnos; }
 
+//! \details The congestion window is used in whole segments, so that a window that grows by a
+//! few bytes at a time does not turn into a stream of tiny segments.
+uint64_t TCPSender::_send_window() const {
+    if (!_cc)
+        return _window_size;
+    const uint64_t cwnd = max(_cc->cwnd() / _mss * _mss, uint64_t{_mss});
+    return min(_window_size, cwnd);
+}
+
+void TCPSender::set_mss(const size_t mss) {
+    if (!_pmtu) {
+        _use_mss(mss);
+        return;
+    }
+    _pmtu->set_max(mss);
+    _use_mss(_pmtu->mss());
+}
+
+void TCPSender::_use_mss(const size_t mss) {
+    if (mss == _mss)
+        return;
+    _mss = mss;
+    if (_cc)
+        _cc->set_mss(mss);
+}
+
+//! \details One probe at a time, of new data only, and not during loss recovery. The stream must
+//! hold a probe's worth of data plus enough segments to follow it that their duplicate ACKs
+//! reveal its loss (rather than the retransmission timer). The window must be twice that large,
+//! so that draining the flight to make room for the probe still leaves the window in use, and
+//! a lost probe's recovery must be followed by a round without one, in which the window grows.
+size_t TCPSender::_probe_size() const {
+    if (!_pmtu || _probing || !_syn_sent || _ack_seqno < _next_probe_seqno || (_cc && _cc->in_recovery()))
+        return 0;
+    const optional<size_t> size = _pmtu->probe_size();
+    const size_t needed = size.value_or(0) + DUPACK_THRESHOLD * _mss;
+    if (!size || _stream.buffer_size() < needed || _send_window() < 2 * needed)
+        return 0;
+    return *size;
+}
+
+//! \details The pieces keep the entry's send time and delivery-rate state, and its SACK and
+//! retransmission marks: they stand for the same transmission.
+void TCPSender::_split(const size_t i, const size_t size) {
+    OutstandingSegment whole = move(_out_segs[i]);
+    _out_segs.erase(_out_segs.begin() + i);
+    whole.seg.set_tso_segment_size(size);
+    uint64_t seqno = whole.biggest_absolute_seqno + 1 - whole.seg.length_in_sequence_space();
+    vector<OutstandingSegment> pieces;
+    for (TCPSegment &wire_seg : whole.seg.wire_segments()) {
+        OutstandingSegment piece = whole;
+        piece.seg = move(wire_seg);
+        piece.probe = false;
+        seqno += piece.seg.length_in_sequence_space();
+        piece.biggest_absolute_seqno = seqno - 1;
+        pieces.push_back(move(piece));
+    }
+    _out_segs.insert(_out_segs.begin() + i, make_move_iterator(pieces.begin()), make_move_iterator(pieces.end()));
+}
+
+//! \details The pieces count as retransmissions that have repaired the loss, so they give no RTT
+//! sample and are not resent again until the next loss is detected.
+void TCPSender::_split_probe(const size_t i) {
+    const size_t pieces = (_out_segs[i].seg.payload().size() + _mss - 1) / _mss;
+    _pmtu->on_probe_lost(_out_segs[i].seg.payload().size());
+    _probing = false;
+    _next_probe_seqno = _next_seqno + _send_window();
+
+    _split(i, _mss);
+    for (size_t j = i; j < i + pieces; j++) {
+        _out_segs[j].xmit_us = _now_us;
+        _out_segs[j].retransmitted = true;
+        _out_segs[j].repaired = true;
+        _segments_out.push(_out_segs[j].seg);
+    }
+}
+
+//! \details Of a TSO super-segment, only the first wire segment is resent: the entry is split first.
+void TCPSender::_retransmit(const size_t i) {
+    if (_out_segs[i].probe) {
+        _split_probe(i);
+        return;
+    }
+    if (_out_segs[i].seg.tso_segment_size() != 0)
+        _split(i, _out_segs[i].seg.tso_segment_size());
+    _segments_out.push(_out_segs[i].seg);
+    _out_segs[i].xmit_us = _now_us;
+    _out_segs[i].retransmitted = true;
+    _out_segs[i].repaired = true;
+}
+
+void TCPSender::_retransmit_first() { _retransmit(0); }
+
+bool TCPSender::_retransmit_hole() {
+    for (size_t i = 0; i < _out_segs.size(); i++) {
+        OutstandingSegment &out = _out_segs[i];
+        if (out.sacked || out.repaired)
+            continue;
+        if (i != 0 && out.biggest_absolute_seqno >= _highest_sacked)
+            return false;  // nothing above says this one is lost
+        _retransmit(i);
+        return true;
+    }
+    return false;
+}
+
+bool TCPSender::_sack_loss() const {
+    return !_out_segs.empty() && !_out_segs[0].repaired &&
+           _sacked_bytes > (DUPACK_THRESHOLD - 1) * _mss;
+}
+
+//! \details A lost PLPMTUD probe is only resent (in pieces): it was too large, not a sign of congestion.
+void TCPSender::_fast_retransmit() {
+    for (OutstandingSegment &out : _out_segs)
+        out.repaired = false;
+    if (_out_segs[0].probe) {
+        _split_probe(0);
+        _dupacks = DUPACK_THRESHOLD;  // the duplicates still to come are for the probe, too
+        return;
+    }
+    _retransmit_hole();
+    _cc->on_loss(_now_us, _out_seqnos, _next_seqno);
+}
+
+//! \details Once the window is reduced, the echoes of marks on data sent before the reduction are
+//! ignored (RFC 3168 6.1.2); the next new data segment carries CWR, which stops the echoes.
+void TCPSender::ecn_echo_received() {
+    if (!_ecn || _ack_seqno <= _ecn_recover)
+        return;
+    _ecn_recover = _next_seqno;
+    _cwr_pending = true;
+    if (_cc && !_cc->in_recovery())
+        _cc->on_ecn(_now_us, _out_seqnos);
+}
+
+//! \details Blocks below the ackno (stale or duplicate) or beyond what was sent are ignored.
+void TCPSender::sack_received(const vector<TCPOptions::SackBlock> &blocks) {
+    for (const TCPOptions::SackBlock &block : blocks) {
+        const uint64_t left = unwrap(block.left, _isn, _next_seqno);
+        const uint64_t right = unwrap(block.right, _isn, _next_seqno);
+        if (right <= left || left <= _ack_seqno || right > _next_seqno)
+            continue;
+        _highest_sacked = max(_highest_sacked, right);
+        // TSO: a super-segment that the block covers in part is split, so that the covered part is marked
+        for (size_t i = 0; i < _out_segs.size(); i++) {
+            const OutstandingSegment &out = _out_segs[i];
+            const uint64_t end = out.biggest_absolute_seqno + 1, start = end - out.seg.length_in_sequence_space();
+            if (out.seg.tso_segment_size() != 0 && start < right && left < end && (start < left || right < end))
+                _split(i, out.seg.tso_segment_size());
+        }
+        for (OutstandingSegment &out : _out_segs) {
+            const uint64_t length = out.seg.length_in_sequence_space();
+            if (!out.sacked && left + length <= out.biggest_absolute_seqno + 1 && out.biggest_absolute_seqno < right) {
+                out.sacked = true;
+                _sacked_bytes += length;
+                if (_rack_in_use())
+                    _rack_delivered(out);
+            }
+        }
+    }
+}
+
+//! \details Either rate may be 0 (no pacing from that source).
+uint64_t TCPSender::_pacing_rate() const {
+    const uint64_t cc_rate = _cc ? _cc->pacing_rate() : 0;
+    if (cc_rate == 0 || _configured_pacing_rate == 0)
+        return max(cc_rate, _configured_pacing_rate);
+    return min(cc_rate, _configured_pacing_rate);
+}
+
+//! \details The interval is the RTO, doubled for every probe since the window closed, up to the
+//! RTO's upper bound.
+void TCPSender::_arm_persist() {
+    uint64_t interval = _timer.rto_us();
+    for (unsigned i = 0; i < _persist_backoff && interval < _max_persist_us; i++)
+        interval *= 2;
+    _persist_timer.rto() = min(interval, _max_persist_us);
+    _persist_timer.start();
+    _timer.close();
+}
+
+//! \details A retransmitted segment whose "RTT" is below the smallest one measured was most likely
+//! delivered by its original transmission, so it says nothing about when (RFC 8985 6.2).
+void TCPSender::_rack_delivered(const OutstandingSegment &out) {
+    const uint64_t rtt_us = _now_us - out.xmit_us;
+    if (out.retransmitted && rtt_us < _rack_min_rtt_us)
+        return;
+    if (!out.retransmitted) {
+        _rack_min_rtt_us = _rack_min_rtt_us ? min(_rack_min_rtt_us, rtt_us) : rtt_us;
+        _tlp_srtt_us = _tlp_srtt_us ? (7 * _tlp_srtt_us + rtt_us) / 8 : rtt_us;
+    }
+    const uint64_t end = out.biggest_absolute_seqno + 1;
+    if (!_rack_valid || out.xmit_us > _rack_xmit_us || (out.xmit_us == _rack_xmit_us && end > _rack_end_seq)) {
+        _rack_valid = true;
+        _rack_xmit_us = out.xmit_us;
+        _rack_end_seq = end;
+        _rack_rtt_us = rtt_us;
+    }
+}
+
+//! \details A segment is lost if one sent after it was delivered, and more than an RTT plus a
+//! reordering window (a quarter of the smallest RTT) has passed since it was sent (RFC 8985 6.2).
+//! Losses start a recovery episode as a fast retransmit would.
+void TCPSender::_rack_detect_loss() {
+    _rack_deadline_us.reset();
+    if (!_rack_valid)
+        return;
+    const uint64_t reo_wnd_us = _rack_min_rtt_us / 4;
+    bool lost = false;
+    for (size_t i = 0; i < _out_segs.size(); i++) {
+        const OutstandingSegment &out = _out_segs[i];
+        const bool sent_before = out.xmit_us < _rack_xmit_us ||
+                                 (out.xmit_us == _rack_xmit_us && out.biggest_absolute_seqno < _rack_end_seq);
+        if (out.sacked || !sent_before)
+            continue;
+        const uint64_t deadline_us = out.xmit_us + _rack_rtt_us + reo_wnd_us;
+        if (deadline_us > _now_us) {
+            _rack_deadline_us = max(_rack_deadline_us.value_or(0), deadline_us);
+            continue;
+        }
+        lost = lost || !out.probe;  // PLPMTUD: a lost probe was too large, which says nothing about congestion
+        _retransmit(i);
+    }
+    if (lost && _cc && !_cc->in_recovery())
+        _cc->on_loss(_now_us, _out_seqnos, _next_seqno);
+}
+
+//! \details The probe timeout is two smoothed RTTs, plus the peer's delayed-ACK allowance if only
+//! one segment is in flight, and no later than the RTO (RFC 8985 7.2). There is no probe during
+//! recovery, after one until new data is acked, or while the window is zero.
+void TCPSender::_arm_pto() {
+    _pto_deadline_us.reset();
+    if (!_rack_in_use() || _out_segs.empty() || _tlp_in_flight || _tlp_srtt_us == 0 || _persist_timer.is_started() ||
+        (_cc && _cc->in_recovery()))
+        return;
+    uint64_t pto_us = 2 * _tlp_srtt_us + (_out_segs.size() == 1 ? _tlp_max_ack_delay_us : 0);
+    if (_timer.is_started())
+        pto_us = min(pto_us, _timer.rto_us() - min(_timer.elapsed(), _timer.rto_us()));
+    _pto_deadline_us = _now_us + pto_us;
+}
+
+//! \details New data makes the most of the probe; without it, the last segment is sent again (of
+//! a TSO super-segment, the last wire segment). Either way, the ACK for the probe lets RACK see
+//! the losses before it. The retransmission timer restarts.
+void TCPSender::_send_tlp() {
+    _pto_deadline_us.reset();
+    if (_out_segs.empty())
+        return;
+    _tlp_in_flight = true;
+    const size_t queued = _segments_out.size();
+    if (!_stream.buffer_empty() && _send_window() > _next_seqno - _ack_seqno)
+        _send_segment();
+    if (_segments_out.size() == queued) {
+        if (_out_segs.back().seg.tso_segment_size() != 0)
+            _split(_out_segs.size() - 1, _out_segs.back().seg.tso_segment_size());
+        _retransmit(_out_segs.size() - 1);
+    }
+    _timer.start();
+}
+
+bool TCPSender::_hold_for_sws() {
+    if (!_sws_deadline_us)
+        _sws_deadline_us = _now_us + SWS_OVERRIDE_US;
+    return false;
+}
+
 void TCPSender::fill_window() {
+    _pacing_blocked = false;
+    while (_send_segment()) {
+    }
+}
+
+//! \details The payload is a view of the stream's storage (see ByteStream::read_buffer()), so a
+//! segment costs no copy of its data unless it spans two writes to the stream.
+bool TCPSender::_send_segment() {
     // Impossible ackno (beyond next seqno) is ignored
     if (_next_seqno < _ack_seqno && _syn_sent)
-        return;
-    uint16_t ws = _window_size;
+        return false;
+    uint64_t ws = _send_window();
     // 如果窗口不足以填入下一个要发送的字节，则什么都不做，除非需要接受的字节恰好就是下一个要发送的字节
-    if (_window_size <= (_next_seqno - _ack_seqno) && _syn_sent) {
-        if (_next_seqno == _ack_seqno)
-            ws = 1;
-        else
-            return;
+    if (ws <= (_next_seqno - _ack_seqno) && _syn_sent) {
+        if (_next_seqno != _ack_seqno)
+            return false;
+        // persist timer: a zero window is probed only when it expires
+        if (_use_persist_timer && !_window_probe) {
+            if (!_persist_timer.is_started() && (!_stream.buffer_empty() || (_stream.eof() && !_fin_sent)))
+                _arm_persist();
+            return false;
+        }
+        // SWS avoidance: a zero window is probed only once the override timeout has passed (or when
+        // the persist timer says so)
+        if (_sws_avoidance && !_sws_override && !_window_probe)
+            return _hold_for_sws();
+        ws = 1;
+    }
+    // pacing: wait for tick_us() to reach the next release time
+    _pacer.set_rate(_pacing_rate());
+    if (_syn_sent && !_pacer.may_send(_now_us)) {
+        _pacing_blocked = true;
+        return false;
+    }
+
+    // Nagle (RFC 896): while data is unacknowledged, less than a segment's worth waits for more
+    // data or for the acks (unless the stream has ended: then it goes out with the FIN)
+    if (_nagle && _syn_sent && _out_seqnos > 0 && _stream.buffer_size() < _mss && !_stream.input_ended())
+        return false;
+
+    // SWS avoidance (RFC 1122 4.2.3.4): a segment smaller than the MSS goes out only if it carries
+    // everything queued, or fills at least half the largest window the receiver has offered
+    if (_sws_avoidance && _syn_sent && !_sws_override && !_window_probe) {
+        const uint64_t usable = ws - (_next_seqno - _ack_seqno), queued = _stream.buffer_size();
+        if (queued > usable && usable < _mss && usable < _max_window / 2)
+            return _hold_for_sws();
+    }
+
+    // PLPMTUD: this segment may be a probe of a larger size; if the flight leaves too little room
+    // for it, new data waits until enough has been acked (otherwise a full window would never
+    // leave room for a probe)
+    const size_t probe_size = _probe_size();
+    if (probe_size && ws < _next_seqno - _ack_seqno + probe_size)
+        return false;
+    size_t max_payload = probe_size ? probe_size : _mss;
+    // TSO: otherwise, a burst of segments may go out as one super-segment (when pacing, no more than
+    // the pacer would release back to back)
+    if (!probe_size && _syn_sent && _tso_max_size > _mss) {
+        const size_t tso_size = _pacer.enabled() ? min(_tso_max_size, _pacer.burst()) : _tso_max_size;
+        max_payload = max(_mss, tso_size / _mss * _mss);
     }
 
     // 创建 TCPSegment
@@ -45,60 +407,151 @@ void TCPSender::fill_window() {
         _syn_sent = true;
     }
     // 装入 payload
-    string send_msg;
-    uint16_t payload_size = ws - (_next_seqno - _ack_seqno) - seg.header().syn;  // 确定发送内容的大小
-    if (payload_size < TCPConfig::MAX_PAYLOAD_SIZE)
-        send_msg = _stream.read(payload_size);
-    else
-        send_msg = _stream.read(TCPConfig::MAX_PAYLOAD_SIZE);
-    if (_stream.bytes_read() == _stream.bytes_written() && _stream.eof() && payload_size > send_msg.size() &&
+    uint64_t payload_size = ws - (_next_seqno - _ack_seqno) - seg.header().syn;  // 确定发送内容的大小
+    seg.payload() = _stream.read_buffer(min<uint64_t>(payload_size, max_payload));
+    if (!probe_size && seg.payload().size() > _mss)
+        seg.set_tso_segment_size(_mss);
+    if (_stream.bytes_read() == _stream.bytes_written() && _stream.eof() && payload_size > seg.payload().size() &&
         !_fin_sent) {
         seg.header().fin = true;
         _fin_sent = true;
     }
-    seg.payload() = Buffer(std::move(send_msg));  // 转换为右值引用，构造完之后 send_msg 就空了
 
     // 如果该 TCPSegment 序列长度不为零（没读到序列长度就可能为零），就发送这个 TCPSegment
     if (seg.length_in_sequence_space() > 0) {
-        _segments_out.push(seg);
+        // ECN: new data goes out ECN-capable, and the first after a reduction says so with CWR;
+        // the copy kept for retransmission has neither (RFC 3168 6.1.5: retransmissions aren't ECT)
+        if (_ecn && seg.payload().size() > 0) {
+            seg.set_ecn(IPv4Header::ECN_ECT0);
+            seg.header().cwr = _cwr_pending;
+            _cwr_pending = false;
+        }
+        _segments_out.push(seg);  // shares the payload Buffer with the copy kept in _out_segs
+        seg.set_ecn(IPv4Header::ECN_NOT_ECT);
+        seg.header().cwr = false;
+        _sws_deadline_us.reset();
         _next_seqno += seg.length_in_sequence_space();
 
         // 将 TCPSegment 放入 _out_segs 中
+        if (_out_segs.empty())
+            _first_sent_us = _delivered_us = _now_us;  // the flight starts from empty
         OutstandingSegment out_seg;
         out_seg.seg = seg;
         out_seg.biggest_absolute_seqno = _next_seqno - 1;
-        _out_segs.push_back(out_seg);
+        out_seg.sent_us = out_seg.xmit_us = _now_us;
+        out_seg.delivered = _delivered;
+        out_seg.delivered_us = _delivered_us;
+        out_seg.first_sent_us = _first_sent_us;
+        out_seg.app_limited = _app_limited_until != 0;
+        out_seg.probe = probe_size != 0 && seg.payload().size() == probe_size;
+        _probing = _probing || out_seg.probe;
+        _out_segs.push_back(move(out_seg));
+        // coarse ticks may leave the schedule one tick behind when tick_us() releases held-back segments
+        _pacer.on_send(_now_us, seg.length_in_sequence_space(), _pacing_release ? _last_tick_us : 0);
         _out_seqnos += seg.length_in_sequence_space();
-        // 如果没有正在计时，就开始计时
-        if (!_timer.is_started())
+        // 如果没有正在计时，就开始计时 (unless this is a probe of a zero window: the persist timer runs)
+        if (!_timer.is_started() && !_persist_timer.is_started())
             _timer.start();
+        _arm_pto();
     }
     // 如果窗口没有填满，就继续填
-    // 窗口是否有空的判断在 fill_window() 函数的最前面
+    // 窗口是否有空的判断在本函数的最前面
     if (!_fin_sent && _stream.bytes_read() < _stream.bytes_written())
-        fill_window();
+        return true;
+    if (_syn_sent && !_fin_sent && _out_seqnos < _send_window())
+        _app_limited_until = max<uint64_t>(_delivered + _out_seqnos, 1);  // out of data, not of window
+    return false;
 }
 
 //! \param ackno The remote receiver's ackno (acknowledgment number)
 //! \param window_size The remote receiver's advertised window size
-void TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_size) {
+//! \param pure_ack Whether the ack arrived on a segment that occupied no sequence space
+void TCPSender::ack_received(const WrappingInt32 ackno, const uint64_t window_size, const bool pure_ack) {
+    const uint64_t previous_ack_seqno = _ack_seqno;
+    const uint64_t previous_window_size = _window_size;
+    const optional<uint64_t> echo_rtt_us = _echo_rtt_us;
+    _echo_rtt_us.reset();
+    const uint64_t previous_out_seqnos = _out_seqnos;
     _ack_seqno = unwrap(ackno, _isn, _next_seqno);  // 下一个需要发送的字节序号
     _window_size = window_size;
+    _max_window = max(_max_window, window_size);
     // Impossible ackno (beyond next seqno) is ignored
     if (_next_seqno < _ack_seqno)
         return;
-    vector<OutstandingSegment>::iterator iter = _out_segs.begin();
+    // persist timer: the receiver is alive, whether or not its window has opened
+    if (_unanswered_probes) {
+        _unanswered_probes = 0;
+        _consecutive_retransmissions = 0;
+    }
+    uint64_t rtt_us = 0;
+    // delivery-rate sample, from the newest acked segment that was sent only once
+    bool rate_sample = false;
+    uint64_t prior_delivered = 0, prior_delivered_us = 0, send_elapsed_us = 0;
+    bool sample_app_limited = false;
+    optional<uint64_t> rto_sample_us{};
+    bool acked_retransmission = false, acked_original = false;
     size_t size_of_out_segs = _out_segs.size();
-    while (iter != _out_segs.end()) {
-        if (iter->biggest_absolute_seqno < _ack_seqno) {
-            _out_seqnos -= iter->seg.length_in_sequence_space();  // fly 序列数作出相应的调整
-            iter = _out_segs.erase(iter);  // 删除 _out_segs 中序列号小于 _next_seqno 的 TCPSegment
-        } else
-            iter++;
+    // _out_segs is in sequence order, so the acked segments are the ones at the front
+    while (!_out_segs.empty()) {
+        const OutstandingSegment &acked = _out_segs.front();
+        if (acked.biggest_absolute_seqno >= _ack_seqno) {
+            // TSO: a super-segment acked in part is split, and its acked wire segments popped
+            const uint64_t start = acked.biggest_absolute_seqno + 1 - acked.seg.length_in_sequence_space();
+            if (acked.seg.tso_segment_size() == 0 || start >= _ack_seqno)
+                break;
+            _split(0, acked.seg.tso_segment_size());
+            continue;
+        }
+        if (acked.retransmitted)
+            acked_retransmission = true;
+        else {
+            acked_original = true;
+            rtt_us = _now_us - acked.sent_us;
+            if (!rto_sample_us)
+                rto_sample_us = rtt_us;  // the RTO uses the oldest segment acked (the longest RTT)
+            rate_sample = true;
+            prior_delivered = acked.delivered;
+            prior_delivered_us = acked.delivered_us;
+            send_elapsed_us = acked.sent_us - acked.first_sent_us;
+            sample_app_limited = acked.app_limited;
+            _first_sent_us = acked.sent_us;
+        }
+        if (acked.sacked)
+            _sacked_bytes -= acked.seg.length_in_sequence_space();
+        else if (_rack_in_use())
+            _rack_delivered(acked);
+        if (acked.probe) {
+            // PLPMTUD: the probe got through, so segments of its size do
+            _pmtu->on_probe_acked(acked.seg.payload().size());
+            _probing = false;
+            _use_mss(_pmtu->mss());
+        }
+        _delivered += acked.seg.length_in_sequence_space();
+        _delivered_us = _now_us;
+        _out_seqnos -= acked.seg.length_in_sequence_space();  // fly 序列数作出相应的调整
+        _out_segs.pop_front();  // 删除 _out_segs 中序列号小于 _ack_seqno 的 TCPSegment
+    }
+    // Karn: an ack that covers retransmitted data gives no RTT sample (the segments after a repaired
+    // hole waited for the repair, so their "RTT" would include it)
+    if (acked_retransmission) {
+        rtt_us = 0;
+        rto_sample_us.reset();
     }
+    // a timestamp echo tells which transmission the ack answers, so it always gives the RTO a sample
+    if (echo_rtt_us)
+        rto_sample_us = *echo_rtt_us;
     // ack 恢复正常(_out_segs 中有 seg 被承认接收)，_timer 重开，_consecutive_retransmissions 归零
     if (size_of_out_segs > _out_segs.size()) {
-        _timer.rto() = _initial_retransmission_timeout;
+        if (!_rtt)
+            _timer.rto() = _initial_retransmission_timeout;
+        else {
+            if (rto_sample_us)
+                _rtt->sample(*rto_sample_us);
+            // Karn: an ack of retransmitted data alone keeps the backed-off RTO; once data that was
+            // sent only once is acked too, the path is delivering again and the estimate applies
+            if (rto_sample_us || acked_original)
+                _timer.rto() = _rtt->rto_us();
+        }
         if (_out_segs.size() != 0)
             _timer.restart();
         else
@@ -106,32 +559,136 @@ void TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_si
         _consecutive_retransmissions = 0;
     }
 
+    if (_app_limited_until != 0 && _delivered > _app_limited_until)
+        _app_limited_until = 0;
+
+    if (_cc) {
+        if (_out_seqnos < previous_out_seqnos) {
+            _dupacks = 0;
+            AckSample ack{_now_us, _ack_seqno, previous_out_seqnos - _out_seqnos, _out_seqnos, rtt_us, _next_seqno};
+            if (rate_sample) {
+                ack.delivered = _delivered - prior_delivered;
+                ack.interval_us = max(send_elapsed_us, _delivered_us - prior_delivered_us);
+                ack.app_limited = sample_app_limited;
+            }
+            _cc->on_ack(ack);
+            // (with RACK, lost segments are told by time instead, below)
+            if (!_rack_in_use() && _cc->in_recovery() && !_out_segs.empty())
+                _retransmit_hole();  // partial ack: the next hole is lost too
+            else if (!_rack_in_use() && !_cc->in_recovery() && _sack_loss())
+                _fast_retransmit();
+        } else if (pure_ack && _ack_seqno == previous_ack_seqno && window_size == previous_window_size &&
+                   !_out_segs.empty() && !_persist_timer.is_started()) {
+            // duplicate ACK: the third one (or enough SACKed data) triggers a fast retransmit; later
+            // ones each let one segment out, a hole if there is one and otherwise new data
+            if (_cc->in_recovery()) {
+                if (_rack_in_use() || !_retransmit_hole())
+                    _cc->on_dupack(_now_us);
+            } else if (!_rack_in_use() && (++_dupacks == DUPACK_THRESHOLD || _sack_loss()))
+                _fast_retransmit();
+        }
+    }
+
+    if (_rack_in_use()) {
+        if (_ack_seqno > previous_ack_seqno)
+            _tlp_in_flight = false;
+        _rack_detect_loss();
+        _arm_pto();
+    }
+
+    // persist timer: an open window ends the probing; while it is zero, the persist timer runs in
+    // place of the retransmission timer (segments in flight are then probes too)
+    if (_use_persist_timer && _window_size != 0) {
+        _persist_timer.close();
+        _persist_backoff = 0;
+        if (!_out_segs.empty() && !_timer.is_started())
+            _timer.start();
+    } else if (_use_persist_timer && !_out_segs.empty() && !_persist_timer.is_started()) {
+        _arm_persist();
+    }
+
     // fill_window();
 }
 
-//! \param[in] ms_since_last_tick the number of milliseconds since the last call to this method
-void TCPSender::tick(const size_t ms_since_last_tick) {
+//! \param[in] us_since_last_tick the number of microseconds since the last call to this method
+void TCPSender::tick_us(const uint64_t us_since_last_tick) {
+    _now_us += us_since_last_tick;
+    _last_tick_us = us_since_last_tick;
     // 如果 _timer 处于开启状态，则计时
     // std::cout << _timer.is_started() << std::endl;
     if (_timer.is_started()) {
-        _timer.increase(ms_since_last_tick);
-        // std::cout << _timer.ticks() << std::endl;
+        _timer.increase(us_since_last_tick);
+        // std::cout << _timer.elapsed() << std::endl;
         // std::cout << _timer.rto() << std::endl;
         if (_timer.is_expired()) {
-            _segments_out.push(_out_segs[0].seg);  // 将最早的 TCPSegment 进行重传
-            if (_window_size != 0 || _out_segs[0].seg.header().syn) {
+            for (OutstandingSegment &out : _out_segs)
+                out.repaired = false;  // a new loss: every hole needs repairing again
+            // PLPMTUD: a lost probe was too large, which says nothing about congestion
+            const bool probe = _out_segs[0].probe;
+            _retransmit_first();  // 将最早的 TCPSegment 进行重传
+            if (!probe && (_window_size != 0 || _out_segs[0].seg.header().syn)) {
                 // 如果收到过 ack，并且 _window_size=0，表明超时未收到 fly bytes ack 的原因可能是因为接收方数据
                 // 处理不过来，不是网络问题，这个时候没必要将 rto 翻倍
                 _consecutive_retransmissions++;
                 _timer.rto() += _timer.rto();
+                if (_rtt)
+                    _timer.rto() = min(_timer.rto(), _rtt->max_rto_us());
+                if (_cc) {
+                    _cc->on_timeout(_now_us, _out_seqnos);
+                    _dupacks = 0;
+                }
             }
             _timer.restart();
+            _pto_deadline_us.reset();
         }
     }
+    // RACK-TLP: a segment's reordering window has run out, or the probe timeout has expired
+    if (_rack_deadline_us && _now_us >= *_rack_deadline_us)
+        _rack_detect_loss();
+    if (_pto_deadline_us && _now_us >= *_pto_deadline_us)
+        _send_tlp();
+    // pacing: send what fill_window() held back, now that its time has come
+    if (_pacing_blocked && _pacer.may_send(_now_us)) {
+        _pacing_release = true;
+        fill_window();
+        _pacing_release = false;
+    }
+    // persist timer: probe the zero window, with one byte of new data or the oldest segment in flight
+    if (_persist_timer.is_started()) {
+        _persist_timer.increase(us_since_last_tick);
+        if (_persist_timer.is_expired()) {
+            _persist_backoff++;
+            // a probe that got no answer at all counts as a retransmission (a receiver that answers
+            // with a zero window may keep it closed for as long as it likes; a dead one may not)
+            if (_unanswered_probes++ > 0)
+                _consecutive_retransmissions++;
+            if (_out_segs.empty()) {
+                _window_probe = true;
+                fill_window();
+                _window_probe = false;
+            } else {
+                _retransmit_first();
+            }
+            _arm_persist();
+        }
+    }
+    // SWS avoidance: after the override timeout, what was held back goes out anyway
+    if (_sws_deadline_us && _now_us >= *_sws_deadline_us) {
+        _sws_deadline_us.reset();
+        _sws_override = true;
+        fill_window();
+        _sws_override = false;
+    }
 }
 
 unsigned int TCPSender::consecutive_retransmissions() const { return _consecutive_retransmissions; }
 
+optional<uint64_t> TCPSender::time_until_release_us() const {
+    if (!_pacing_blocked)
+        return {};
+    return _pacer.wait_us(_now_us);
+}
+
 void TCPSender::send_empty_segment() {
     // 创建 TCPSegment
     TCPSegment seg;
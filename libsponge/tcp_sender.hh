@@ -2,50 +2,116 @@
 #define SPONGE_LIBSPONGE_TCP_SENDER_HH
 
 #include "byte_stream.hh"
+#include "congestion_control.hh"
+#include "pacer.hh"
+#include "pmtu_search.hh"
 #include "tcp_config.hh"
 #include "tcp_segment.hh"
 #include "wrapping_integers.hh"
 
+#include <deque>
 #include <functional>
+#include <memory>
 #include <queue>
+#include <vector>
 
 class Timer {
   private:
-    unsigned int _rto;
-    size_t _ticks;
+    uint64_t _rto;      //!< Current retransmission timeout, in microseconds
+    uint64_t _elapsed;  //!< Microseconds since the timer was (re)started
     bool _start;
 
   public:
-    Timer(unsigned int _initial_retransmission_timeout)
-        : _rto(_initial_retransmission_timeout), _ticks(0), _start(false) {}
+    Timer(uint64_t initial_retransmission_timeout_us)
+        : _rto(initial_retransmission_timeout_us), _elapsed(0), _start(false) {}
 
-    void increase(const size_t ms_since_last_tick) { _ticks += ms_since_last_tick; }
+    void increase(const uint64_t us_since_last_tick) { _elapsed += us_since_last_tick; }
 
     void start() {
         _start = true;
-        _ticks = 0;
+        _elapsed = 0;
     }
 
     void close() {
         _start = false;
-        _ticks = 0;
+        _elapsed = 0;
     }
 
-    void restart() { _ticks = 0; }
+    void restart() { _elapsed = 0; }
 
-    bool is_started() { return _start; }
+    bool is_started() const { return _start; }
 
-    bool is_expired() { return _ticks >= _rto; }
+    bool is_expired() { return _elapsed >= _rto; }
 
-    unsigned int &rto() { return _rto; }
+    uint64_t &rto() { return _rto; }
 
-    unsigned int ticks() { return _ticks; }
+    uint64_t rto_us() const { return _rto; }
+
+    uint64_t elapsed() { return _elapsed; }
 };
 
+//! \brief Smoothed RTT and RTT variation, and the retransmission timeout they give (RFC 6298)
+class RttEstimator {
+  private:
+    uint64_t _srtt_us{0};     //!< Smoothed round-trip time
+    uint64_t _rttvar_us{0};   //!< Round-trip time variation
+    bool _has_sample{false};  //!< Has there been a measurement yet?
+    uint64_t _rto_us;         //!< Current retransmission timeout
+    uint64_t _min_rto_us;     //!< Lower clamp for the RTO
+    uint64_t _max_rto_us;     //!< Upper clamp for the RTO
+
+  public:
+    //! Clock granularity G in the RTO formula (our timers advance in ticks of about a millisecond)
+    static constexpr uint64_t GRANULARITY_US = 1000;
+
+    //! \param[in] initial_rto_us is the RTO before the first sample (RFC 6298 says 1 s)
+    //! \param[in] min_rto_us and max_rto_us clamp the computed RTO
+    RttEstimator(const uint64_t initial_rto_us, const uint64_t min_rto_us, const uint64_t max_rto_us)
+        : _rto_us(initial_rto_us), _min_rto_us(min_rto_us), _max_rto_us(max_rto_us) {}
+
+    //! Take a round-trip time measurement (from a segment that was not retransmitted)
+    void sample(const uint64_t rtt_us);
+
+    //! \name Accessors
+    //!@{
+    bool has_sample() const { return _has_sample; }
+    uint64_t srtt_us() const { return _srtt_us; }
+    uint64_t rttvar_us() const { return _rttvar_us; }
+    uint64_t rto_us() const { return _rto_us; }
+    uint64_t max_rto_us() const { return _max_rto_us; }
+    //!@}
+};
+
+//! \brief A segment that was sent and not yet acknowledged
+//! \details `seg` is a copy of the segment handed to segments_out(): its header is the sender's own
+//! (the connection fills in the ack fields on the copy it sends), but the payload Buffer is shared
+//! with it, not copied.
 struct OutstandingSegment {
     TCPSegment seg;
     uint64_t biggest_absolute_seqno;
-    OutstandingSegment() : seg(), biggest_absolute_seqno(0) {}
+    uint64_t sent_us;        //!< sender's time when the segment was first sent
+    uint64_t xmit_us;        //!< RACK: sender's time when the segment was last sent
+    bool retransmitted;      //!< has the segment been sent more than once? (then it gives no RTT sample)
+    uint64_t delivered;      //!< delivery-rate sampling: bytes delivered when the segment was sent
+    uint64_t delivered_us;   //!< delivery-rate sampling: time of the last delivery before it was sent
+    uint64_t first_sent_us;  //!< delivery-rate sampling: send time of the segment acked last before it was sent
+    bool app_limited;        //!< delivery-rate sampling: was the sender short of data when it was sent?
+    bool sacked;             //!< SACK: does the receiver hold the segment already?
+    bool repaired;           //!< retransmitted since the current loss was detected
+    bool probe;              //!< PLPMTUD: is the segment a probe of a larger size?
+    OutstandingSegment()
+        : seg()
+        , biggest_absolute_seqno(0)
+        , sent_us(0)
+        , xmit_us(0)
+        , retransmitted(false)
+        , delivered(0)
+        , delivered_us(0)
+        , first_sent_us(0)
+        , app_limited(false)
+        , sacked(false)
+        , repaired(false)
+        , probe(false) {}
 };
 
 //! \brief The "sender" part of a TCP implementation.
@@ -62,8 +128,8 @@ class TCPSender {
     //! outbound queue of segments that the TCPSender wants sent
     std::queue<TCPSegment> _segments_out{};
 
-    //! retransmission timer for the connection
-    unsigned int _initial_retransmission_timeout;
+    //! initial retransmission timeout, in microseconds
+    uint64_t _initial_retransmission_timeout;
 
     //! outgoing stream of bytes that have not yet been sent
     ByteStream _stream;
@@ -75,10 +141,10 @@ class TCPSender {
     uint64_t _ack_seqno{0};
 
     //! 可以发送的窗口大小（序列空间的序列数）
-    uint16_t _window_size{0};
+    uint64_t _window_size{0};
 
-    //! 已经发送但并未被承认接收的 segments
-    std::vector<OutstandingSegment> _out_segs{};
+    //! 已经发送但并未被承认接收的 segments, in sequence order (a cumulative ack pops from the front)
+    std::deque<OutstandingSegment> _out_segs{};
 
     //! 在 _out_segs 中的序列数
     uint64_t _out_seqnos{0};
@@ -95,12 +161,226 @@ class TCPSender {
     //! 是否发出过带有 fin 的 TCPSegment，发出过就不用再发了（顶多重传）
     bool _fin_sent{false};
 
+    //! RTT estimation for the RTO (empty: the RTO stays at its initial value, see TCPConfig::adaptive_rto)
+    std::optional<RttEstimator> _rtt{};
+
+    //! congestion control (nullptr: sending is bounded by the receiver's window only)
+    std::unique_ptr<CongestionControl> _cc{};
+
+    //! microseconds of ticks so far
+    uint64_t _now_us{0};
+
+    //! length of the last tick, in microseconds
+    uint64_t _last_tick_us{0};
+
+    //! duplicate ACKs received in a row
+    unsigned int _dupacks{0};
+
+    //! delivery-rate sampling: bytes acknowledged so far
+    uint64_t _delivered{0};
+
+    //! delivery-rate sampling: when _delivered last grew (or the flight last started from empty)
+    uint64_t _delivered_us{0};
+
+    //! delivery-rate sampling: send time of the most recently acked segment
+    uint64_t _first_sent_us{0};
+
+    //! delivery-rate sampling: samples stay app-limited until _delivered passes this (0: not app-limited)
+    uint64_t _app_limited_until{0};
+
+    //! pacing: release schedule for new segments
+    Pacer _pacer;
+
+    //! pacing: configured rate, in bytes per second (0: only the congestion control's, if any)
+    uint64_t _configured_pacing_rate{0};
+
+    //! pacing: did fill_window() stop early because of the pacing rate?
+    bool _pacing_blocked{false};
+
+    //! pacing: is tick_us() sending segments that fill_window() held back?
+    bool _pacing_release{false};
+
+    //! SACK: sequence numbers of outstanding segments that the receiver holds
+    uint64_t _sacked_bytes{0};
+
+    //! SACK: absolute seqno just past the highest block the receiver reported
+    uint64_t _highest_sacked{0};
+
+    //! largest payload of a segment
+    size_t _mss;
+
+    //! RTT measured from a timestamp echo, for the next ack_received() (see timestamp_echo_received())
+    std::optional<uint64_t> _echo_rtt_us{};
+
+    //! PLPMTUD: the search for the segment size (empty: segments are always _mss bytes)
+    std::optional<PmtuSearch> _pmtu{};
+
+    //! TSO: largest payload of a super-segment (0: no super-segments)
+    size_t _tso_max_size{0};
+
+    //! hold back small segments while data is unacknowledged (Nagle's algorithm)?
+    bool _nagle{false};
+
+    //! SWS avoidance: hold back segments that would fill only a sliver of the window?
+    bool _sws_avoidance{false};
+
+    //! SWS avoidance: the largest window the receiver has advertised
+    uint64_t _max_window{0};
+
+    //! SWS avoidance: when what is held back goes out anyway (empty: nothing is held back)
+    std::optional<uint64_t> _sws_deadline_us{};
+
+    //! SWS avoidance: the override timeout has passed, so send whatever the window allows
+    bool _sws_override{false};
+
+    //! probe a zero window from the persist timer (otherwise at once, and then on every RTO)?
+    bool _use_persist_timer{false};
+
+    //! persist timer: runs, instead of the retransmission timer, while the window is zero
+    Timer _persist_timer{0};
+
+    //! persist timer: probes sent since the window closed (each doubles the interval)
+    unsigned _persist_backoff{0};
+
+    //! persist timer: probes sent since the last ack of any kind
+    unsigned _unanswered_probes{0};
+
+    //! persist timer: upper bound on its interval
+    uint64_t _max_persist_us{0};
+
+    //! persist timer: fill_window() is sending a probe of the zero window
+    bool _window_probe{false};
+
+    //! detect losses by time (RACK) and probe for tail losses (TLP)?
+    bool _rack_tlp{false};
+
+    //! are SACK blocks coming (SACK negotiated)? RACK-TLP needs them; without them, three duplicate
+    //! ACKs still tell a loss
+    bool _sack{false};
+
+    //! RACK-TLP configured, and SACK in use
+    bool _rack_in_use() const { return _rack_tlp && _sack; }
+
+    //! RACK: has a segment been delivered yet?
+    bool _rack_valid{false};
+
+    //! RACK: last send time of the most recently sent segment among those delivered (RACK.xmit_ts)
+    uint64_t _rack_xmit_us{0};
+
+    //! RACK: the end of that segment, as an absolute seqno (RACK.end_seq)
+    uint64_t _rack_end_seq{0};
+
+    //! RACK: the round-trip time of that segment (RACK.rtt)
+    uint64_t _rack_rtt_us{0};
+
+    //! RACK: the smallest round-trip time measured (0: none yet)
+    uint64_t _rack_min_rtt_us{0};
+
+    //! RACK: when the reordering window of a segment still in question runs out (empty: none is)
+    std::optional<uint64_t> _rack_deadline_us{};
+
+    //! TLP: smoothed round-trip time (0: none yet)
+    uint64_t _tlp_srtt_us{0};
+
+    //! TLP: allowance for a delayed ACK when a single segment is in flight (RFC 8985 WCDelAckT; the
+    //! peer's delayed-ACK timeout is taken to be ours)
+    uint64_t _tlp_max_ack_delay_us{0};
+
+    //! TLP: when the probe timeout expires (empty: not armed)
+    std::optional<uint64_t> _pto_deadline_us{};
+
+    //! TLP: a probe is in flight (no other until new data is acked)
+    bool _tlp_in_flight{false};
+
+    //! ECN: are our data segments ECN-capable (both ends negotiated ECN)?
+    bool _ecn{false};
+
+    //! ECN: the next new data segment carries CWR (the window was reduced for an ECE)
+    bool _cwr_pending{false};
+
+    //! ECN: echoes are ignored until the ack passes this absolute seqno (next_seqno at the last reduction)
+    uint64_t _ecn_recover{0};
+
+    //! PLPMTUD: is a probe outstanding?
+    bool _probing{false};
+
+    //! PLPMTUD: after a lost probe, no new probe until this absolute seqno is acked
+    uint64_t _next_probe_seqno{0};
+
+    //! switch to segments of `mss` bytes (and tell the congestion control)
+    void _use_mss(const size_t mss);
+
+    //! PLPMTUD: the payload size of the next segment if it is to be a probe (0: it isn't)
+    size_t _probe_size() const;
+
+    //! \brief replace `_out_segs[i]` by entries for pieces of it, with payloads of at most `size` bytes
+    void _split(const size_t i, const size_t size);
+
+    //! PLPMTUD: the probe at `_out_segs[i]` was lost; resend its data in segments of the current size
+    void _split_probe(const size_t i);
+
+    //! retransmit `_out_segs[i]` (in pieces, if it is a probe)
+    void _retransmit(const size_t i);
+
+    //! number of sequence numbers the sender may have outstanding: min(cwnd, receiver's window)
+    uint64_t _send_window() const;
+
+    //! \brief send the next segment, if the window and the pacer allow one
+    //! \returns true if fill_window() should try another (a segment was sent and data remains)
+    bool _send_segment();
+
+    //! retransmit the oldest outstanding segment
+    void _retransmit_first();
+
+    //! \brief retransmit the oldest hole: a segment the receiver lacks that hasn't been repaired yet
+    //! \details The oldest outstanding segment is a hole once loss is detected; with SACK, so is any
+    //! segment below a SACKed block. \returns false if there is no hole left to repair
+    bool _retransmit_hole();
+
+    //! SACK: is the oldest segment lost? (more than DUPACK_THRESHOLD - 1 segments' worth of data above
+    //! it has been SACKed, RFC 6675)
+    bool _sack_loss() const;
+
+    //! enter loss recovery: retransmit the oldest segment and tell the congestion control
+    void _fast_retransmit();
+
+    //! the pacing rate in force: the lower of the configured rate and the congestion control's
+    uint64_t _pacing_rate() const;
+
+    //! SWS avoidance: hold back the next segment (until the override timeout, at the latest)
+    bool _hold_for_sws();
+
+    //! persist timer: (re)start it with the backed-off interval, and stop the retransmission timer
+    void _arm_persist();
+
+    //! RACK: take in the delivery (cumulative or selective) of `out`
+    void _rack_delivered(const OutstandingSegment &out);
+
+    //! RACK: retransmit the segments sent a reordering window before the most recently delivered one
+    //! (and set the RACK timer for those sent less long before)
+    void _rack_detect_loss();
+
+    //! TLP: arm the probe timeout, if a probe may be sent
+    void _arm_pto();
+
+    //! TLP: send a probe: a new segment if the window allows, the last one again otherwise
+    void _send_tlp();
+
   public:
+    //! Duplicate ACKs that trigger a fast retransmit (when congestion control is enabled)
+    static constexpr unsigned int DUPACK_THRESHOLD = CongestionControl::DUPACK_THRESHOLD;
+
+    //! SWS avoidance: longest a segment is held back (RFC 1122 4.2.3.4 suggests 0.1 to 1 second)
+    static constexpr uint64_t SWS_OVERRIDE_US = 200'000;
+
     //! Initialize a TCPSender
     TCPSender(const size_t capacity = TCPConfig::DEFAULT_CAPACITY,
               const uint16_t retx_timeout = TCPConfig::TIMEOUT_DFLT,
               const std::optional<WrappingInt32> fixed_isn = {});
 
+    //! Initialize a TCPSender from a configuration (with a microsecond-resolution timeout)
+    explicit TCPSender(const TCPConfig &cfg);
+
     //! \name "Input" interface for the writer
     //!@{
     ByteStream &stream_in() { return _stream; }
@@ -111,7 +391,44 @@ class TCPSender {
     //!@{
 
     //! \brief A new acknowledgment was received
-    void ack_received(const WrappingInt32 ackno, const uint16_t window_size);
+    //! \param[in] pure_ack is false if the segment carrying the ack occupied sequence space
+    //! (such a segment never counts as a duplicate ACK)
+    //! \param[in] window_size is in bytes (already scaled, if the connection uses window scaling)
+    void ack_received(const WrappingInt32 ackno, const uint64_t window_size, const bool pure_ack = true);
+
+    //! \brief [SACK](\ref rfc::rfc2018) blocks arrived (call before ack_received() for the same segment)
+    //! \details Outstanding segments inside a block are not retransmitted during loss recovery.
+    void sack_received(const std::vector<TCPOptions::SackBlock> &blocks);
+
+    //! \brief An RTT measured from the timestamp the peer echoed ([RFC 7323](\ref rfc::rfc7323)); call before
+    //! ack_received() for the same segment
+    //! \details If that ack acknowledges new data, the adaptive RTO takes this sample, even when the
+    //! data was retransmitted (the echo tells which transmission the ack answers).
+    void timestamp_echo_received(const uint64_t rtt_us) { _echo_rtt_us = rtt_us; }
+
+    //! \brief An ACK echoed a congestion mark ([ECN](\ref rfc::rfc3168) ECE); call after ack_received() for
+    //! the same segment
+    //! \details The congestion window is reduced at most once per window of data, and not during loss recovery.
+    void ecn_echo_received();
+
+    //! \brief Send new data segments ECN-capable (once both ends have negotiated ECN)
+    void set_ecn(const bool ecn) { _ecn = ecn; }
+
+    //! \brief Whether the peer agreed to send SACK blocks (otherwise, RACK-TLP is not used)
+    void set_sack(const bool sack) { _sack = sack; }
+
+    //! \brief Change the largest payload of the segments sent from now on (e.g. to the peer's MSS)
+    //! \details With PLPMTUD, this is the largest size the search tries.
+    void set_mss(const size_t mss);
+
+    //! \brief Is the persist timer running (the receiver's window is zero)?
+    bool persisting() const { return _persist_timer.is_started(); }
+
+    //! \brief Microseconds from the start of the running persist timer to the next probe
+    uint64_t persist_timeout_us() const { return _persist_timer.rto_us(); }
+
+    //! \brief Send small segments at once (true), or hold them back while data is unacknowledged (Nagle)
+    void set_nodelay(const bool nodelay) { _nagle = !nodelay; }
 
     //! \brief Generate an empty-payload segment (useful for creating empty ACK segments)
     void send_empty_segment();
@@ -120,7 +437,10 @@ class TCPSender {
     void fill_window();
 
     //! \brief Notifies the TCPSender of the passage of time
-    void tick(const size_t ms_since_last_tick);
+    void tick(const size_t ms_since_last_tick) { tick_us(uint64_t(ms_since_last_tick) * 1000); }
+
+    //! \brief Notifies the TCPSender of the passage of time, in microseconds
+    void tick_us(const uint64_t us_since_last_tick);
     //!@}
 
     //! \name Accessors
@@ -134,6 +454,28 @@ class TCPSender {
     //! \brief Number of consecutive retransmissions that have occurred in a row
     unsigned int consecutive_retransmissions() const;
 
+    //! \brief Microseconds until pacing lets held-back segments go (empty if nothing is held back)
+    //! \details Whatever drives tick_us() can sleep this long before the next release.
+    std::optional<uint64_t> time_until_release_us() const;
+
+    //! \brief The receiver's window as of the last ack, in bytes (already scaled)
+    uint64_t window_size() const { return _window_size; }
+
+    //! \brief The largest payload of a segment (other than a PLPMTUD probe)
+    size_t mss() const { return _mss; }
+
+    //! \brief The PLPMTUD search, or nullptr if the segment size is fixed
+    const PmtuSearch *pmtu_search() const { return _pmtu ? &_pmtu.value() : nullptr; }
+
+    //! \brief The current retransmission timeout, in microseconds (including any backoff)
+    uint64_t rto_us() const { return _timer.rto_us(); }
+
+    //! \brief The RTT estimator, or nullptr if the RTO is not adaptive
+    const RttEstimator *rtt_estimator() const { return _rtt ? &_rtt.value() : nullptr; }
+
+    //! \brief The congestion-control algorithm, or nullptr if there is none
+    const CongestionControl *congestion_control() const { return _cc.get(); }
+
     //! \brief TCPSegments that the TCPSender has enqueued for transmission.
     //! \note These must be dequeued and sent by the TCPConnection,
     //! which will need to fill in the fields that are set by the TCPReceiver
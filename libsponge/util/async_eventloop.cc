@@ -0,0 +1,87 @@
+#include "async_eventloop.hh"
+
+#include <poll.h>
+#include <stdexcept>
+
+using namespace std;
+
+bool AsyncEventLoop::FdAwaiter::await_ready() const {
+    if (_fd.closed() or (_direction == Direction::In and _fd.eof())) {
+        return true;
+    }
+    pollfd pfd{_fd.fd_num(), static_cast<short>(_direction), 0};
+    return ::poll(&pfd, 1, 0) > 0;
+}
+
+void AsyncEventLoop::_wait_for(const FileDescriptor &fd, const Direction direction, const coroutine_handle<> handle) {
+    const auto key = make_pair(fd.fd_num(), direction);
+    auto &waiter = _waiters[key];
+    // a waiter for a closed fd is stale: its number may now be `fd`'s, but its rule (which goes
+    // once the EventLoop notices the close) polls the closed fd, so `fd` needs a rule of its own
+    if (waiter and waiter->fd.closed()) {
+        waiter.reset();
+    }
+    if (waiter) {
+        if (waiter->handle) {
+            throw runtime_error("AsyncEventLoop: another coroutine is already waiting on this file descriptor");
+        }
+        waiter->handle = handle;
+        return;
+    }
+
+    waiter = make_shared<Waiter>(Waiter{fd.duplicate(), handle});
+
+    // the callback only queues the coroutine: resuming it here could add rules while
+    // EventLoop::wait_next_event is still iterating over them
+    auto wake = [this, w = waiter.get()] {
+        if (w->handle) {
+            _ready.push_back(exchange(w->handle, {}));
+        }
+    };
+    _eventloop.add_rule(
+        fd,
+        direction,
+        wake,
+        [w = waiter.get()] { return bool(w->handle); },
+        [this, key, wake, w = waiter] {
+            // EOF, hangup or close: let the waiter find out by trying its read or write
+            wake();
+            const auto it = _waiters.find(key);
+            if (it != _waiters.end() and it->second == w) {
+                _waiters.erase(it);
+            }
+        });
+}
+
+void AsyncEventLoop::spawn(Task<> &&task) {
+    _tasks.push_back(move(task));
+    _tasks.back().start();
+}
+
+void AsyncEventLoop::run() {
+    while (true) {
+        while (not _ready.empty()) {
+            const auto handle = _ready.front();
+            _ready.pop_front();
+            handle.resume();
+        }
+
+        for (auto it = _tasks.begin(); it != _tasks.end();) {
+            if (it->done()) {
+                Task<> finished = move(*it);
+                it = _tasks.erase(it);
+                finished.result();
+            } else {
+                ++it;
+            }
+        }
+
+        if (_tasks.empty()) {
+            return;
+        }
+
+        if (_eventloop.wait_next_event(-1) == EventLoop::Result::Exit and _ready.empty()) {
+            throw runtime_error("AsyncEventLoop: tasks remain, but none of them is waiting on a file descriptor");
+        }
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef SPONGE_LIBSPONGE_ASYNC_EVENTLOOP_HH
+#define SPONGE_LIBSPONGE_ASYNC_EVENTLOOP_HH
+
+#include "eventloop.hh"
+#include "file_descriptor.hh"
+#include "task.hh"
+
+#include <coroutine>
+#include <deque>
+#include <list>
+#include <map>
+#include <memory>
+#include <utility>
+
+//! \brief Runs coroutines (Task objects) on one thread, resuming them when the file descriptors they wait on are ready
+//! \details A coroutine suspends with `co_await loop.readable(fd)` or `co_await loop.writable(fd)`.
+//! The first time an fd is awaited in a given Direction, the AsyncEventLoop installs an EventLoop
+//! rule for it whose interest is "some coroutine is waiting" and whose callback queues that
+//! coroutine to be resumed. Coroutines are resumed by run(), between calls to
+//! EventLoop::wait_next_event, never from inside an EventLoop callback.
+//!
+//! At most one coroutine may wait on a given fd in a given Direction at a time (a reader and a
+//! writer may share an fd).
+class AsyncEventLoop {
+  public:
+    //! Awaiter returned by readable() and writable()
+    class FdAwaiter {
+        AsyncEventLoop &_loop;
+        const FileDescriptor &_fd;
+        const Direction _direction;
+
+      public:
+        FdAwaiter(AsyncEventLoop &loop, const FileDescriptor &fd, const Direction direction)
+            : _loop(loop), _fd(fd), _direction(direction) {}
+
+        //! Don't suspend if the fd is already ready (or at EOF, closed, or in error)
+        bool await_ready() const;
+
+        //! Wait for the fd in the AsyncEventLoop
+        void await_suspend(const std::coroutine_handle<> handle) { _loop._wait_for(_fd, _direction, handle); }
+
+        void await_resume() const noexcept {}
+    };
+
+  private:
+    //! The coroutine (if any) waiting on one fd in one Direction
+    struct Waiter {
+        FileDescriptor fd;  //!< The awaited fd (once it is closed, its number may belong to another)
+        std::coroutine_handle<> handle{};
+    };
+
+    EventLoop _eventloop{};                                                   //!< Polls the awaited fds
+    std::map<std::pair<int, Direction>, std::shared_ptr<Waiter>> _waiters{};  //!< Installed rules, by fd and Direction
+    std::deque<std::coroutine_handle<>> _ready{};                             //!< Coroutines to resume
+    std::list<Task<>> _tasks{};                                               //!< Spawned top-level Tasks
+
+    //! Suspend `handle` until `fd` is ready in `direction`
+    void _wait_for(const FileDescriptor &fd, const Direction direction, const std::coroutine_handle<> handle);
+
+  public:
+    //! `co_await loop.readable(fd)` suspends until `fd` can be read without blocking
+    FdAwaiter readable(const FileDescriptor &fd) { return {*this, fd, Direction::In}; }
+
+    //! `co_await loop.writable(fd)` suspends until `fd` can be written without blocking
+    FdAwaiter writable(const FileDescriptor &fd) { return {*this, fd, Direction::Out}; }
+
+    //! `co_await loop.ready(fd, direction)` suspends until `fd` is ready in `direction`
+    FdAwaiter ready(const FileDescriptor &fd, const Direction direction) { return {*this, fd, direction}; }
+
+    //! Start a top-level Task; it runs until its first suspension point before spawn() returns
+    void spawn(Task<> &&task);
+
+    //! \brief Run until every spawned Task has finished
+    //! \details Rethrows the first exception that escapes from a spawned Task. Throws
+    //! std::runtime_error if Tasks remain but none of them is waiting on anything.
+    void run();
+
+    //! Number of spawned Tasks that have not finished
+    size_t pending() const { return _tasks.size(); }
+};
+
+#endif  // SPONGE_LIBSPONGE_ASYNC_EVENTLOOP_HH
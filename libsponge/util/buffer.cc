@@ -7,11 +7,23 @@ void Buffer::remove_prefix(const size_t n) {
         throw out_of_range("Buffer::remove_prefix");
     }
     _starting_offset += n;
-    if (_storage and _starting_offset == _storage->size()) {
+    if (_storage and _starting_offset + _trailing_bytes == _storage->size()) {
         _storage.reset();
+        _starting_offset = _trailing_bytes = 0;
     }
 }
 
+Buffer Buffer::substr(const size_t pos, const size_t n) const {
+    const size_t length = str().size();
+    if (pos > length) {
+        throw out_of_range("Buffer::substr");
+    }
+    Buffer ret{*this};
+    ret._trailing_bytes += length - pos - std::min(n, length - pos);
+    ret.remove_prefix(pos);
+    return ret;
+}
+
 void BufferList::append(const BufferList &other) {
     for (const auto &buf : other._buffers) {
         _buffers.push_back(buf);
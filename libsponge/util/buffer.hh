@@ -15,6 +15,7 @@ class Buffer {
   private:
     std::shared_ptr<std::string> _storage{};
     size_t _starting_offset{};
+    size_t _trailing_bytes{};  //!< Bytes at the end of the storage that are not part of this Buffer
 
   public:
     Buffer() = default;
@@ -28,7 +29,7 @@ class Buffer {
         if (not _storage) {
             return {};
         }
-        return {_storage->data() + _starting_offset, _storage->size() - _starting_offset};
+        return {_storage->data() + _starting_offset, _storage->size() - _starting_offset - _trailing_bytes};
     }
 
     operator std::string_view() const { return str(); }
@@ -46,6 +47,9 @@ class Buffer {
     //! \brief Discard the first `n` bytes of the string (does not require a copy or move)
     //! \note Doesn't free any memory until the whole string has been discarded in all copies of the Buffer.
     void remove_prefix(const size_t n);
+
+    //! \brief A Buffer of (up to) `n` bytes starting at `pos`, sharing this one's storage (does not require a copy)
+    Buffer substr(const size_t pos, const size_t n) const;
 };
 
 //! \brief A reference-counted discontiguous string that can discard bytes from the front
@@ -0,0 +1,18 @@
+#include "clock.hh"
+
+#include "util.hh"
+
+#include <ctime>
+
+using namespace std;
+
+uint64_t MonotonicClock::now_us() const {
+    timespec ts{};
+    SystemCall("clock_gettime", ::clock_gettime(CLOCK_MONOTONIC, &ts));
+    return uint64_t(ts.tv_sec) * 1'000'000 + uint64_t(ts.tv_nsec) / 1000;
+}
+
+const MonotonicClock &MonotonicClock::instance() {
+    static const MonotonicClock clock;
+    return clock;
+}
@@ -0,0 +1,64 @@
+#ifndef SPONGE_LIBSPONGE_CLOCK_HH
+#define SPONGE_LIBSPONGE_CLOCK_HH
+
+#include <atomic>
+#include <cstdint>
+
+//! \brief A source of time, with microsecond resolution
+//! \details The TCP timers only ever see durations (through `tick_us()`); a Clock is what the
+//! code that drives them (TCPSpongeSocket, TCPShardedEngine, simulators) reads to compute those
+//! durations. Production code uses a MonotonicClock; tests and simulators use a VirtualClock,
+//! whose time only moves when they say so.
+class Clock {
+  public:
+    //! Current time, in microseconds since an arbitrary (but fixed) epoch
+    virtual uint64_t now_us() const = 0;
+
+    virtual ~Clock() = default;
+};
+
+//! A Clock backed by `CLOCK_MONOTONIC` (see [clock_gettime(2)](\ref man2::clock_gettime))
+class MonotonicClock : public Clock {
+  public:
+    uint64_t now_us() const override;
+
+    //! A shared instance, used whenever no other Clock was configured
+    static const MonotonicClock &instance();
+};
+
+//! A Clock that stands still until it is advanced (may be read from any thread)
+class VirtualClock : public Clock {
+    std::atomic<uint64_t> _now_us;  //!< Current time
+
+  public:
+    //! Start at `start_us`
+    explicit VirtualClock(const uint64_t start_us = 0) : _now_us(start_us) {}
+
+    uint64_t now_us() const override { return _now_us.load(std::memory_order_acquire); }
+
+    //! Let `us` microseconds pass
+    void advance_us(const uint64_t us) { _now_us.fetch_add(us, std::memory_order_acq_rel); }
+
+    //! Let `ms` milliseconds pass
+    void advance_ms(const uint64_t ms) { advance_us(ms * 1000); }
+};
+
+//! \brief Measures the time between successive calls to lap_us(), on some Clock
+//! \details This is the usual way to turn a Clock into the arguments of `tick_us()`.
+class Stopwatch {
+    const Clock &_clock;  //!< Time source
+    uint64_t _last_us;    //!< Time of construction, or of the last lap
+
+  public:
+    explicit Stopwatch(const Clock &clock) : _clock(clock), _last_us(clock.now_us()) {}
+
+    //! \returns the microseconds elapsed since the previous call (or since construction)
+    uint64_t lap_us() {
+        const uint64_t now = _clock.now_us();
+        const uint64_t elapsed = now - _last_us;
+        _last_us = now;
+        return elapsed;
+    }
+};
+
+#endif  // SPONGE_LIBSPONGE_CLOCK_HH
@@ -3,6 +3,7 @@
 #include "util.hh"
 
 #include <cerrno>
+#include <ctime>
 #include <stdexcept>
 #include <system_error>
 #include <utility>
@@ -59,6 +60,13 @@ void EventLoop::add_rule(const FileDescriptor &fd,
 //! will result in a busy loop (poll returns on a ready file descriptor; file descriptor is not read or
 //! written, so it is still ready; the next call to poll will immediately return).
 EventLoop::Result EventLoop::wait_next_event(const int timeout_ms) {
+    return wait_next_event(chrono::microseconds{timeout_ms < 0 ? -1 : int64_t(timeout_ms) * 1000});
+}
+
+//! \param[in] timeout is the longest time to wait (negative: no limit); it is passed to
+//!                    [ppoll(2)](\ref man2::poll), so timers finer than a millisecond work.
+//! \returns Eventloop::Result indicating success, timeout, or no more Rule objects to poll.
+EventLoop::Result EventLoop::wait_next_event(const chrono::microseconds timeout) {
     vector<pollfd> pollfds{};
     pollfds.reserve(_rules.size());
     bool something_to_poll = false;
@@ -95,7 +103,11 @@ EventLoop::Result EventLoop::wait_next_event(const int timeout_ms) {
 
     // call poll -- wait until one of the fds satisfies one of the rules (writeable/readable)
     try {
-        if (0 == SystemCall("poll", ::poll(pollfds.data(), pollfds.size(), timeout_ms))) {
+        timespec limit{};
+        limit.tv_sec = timeout.count() / 1'000'000;
+        limit.tv_nsec = (timeout.count() % 1'000'000) * 1000;
+        if (0 == SystemCall("ppoll",
+                            ::ppoll(pollfds.data(), pollfds.size(), timeout.count() < 0 ? nullptr : &limit, nullptr))) {
             return Result::Timeout;
         }
     } catch (unix_error const &e) {
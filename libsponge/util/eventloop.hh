@@ -3,6 +3,7 @@
 
 #include "file_descriptor.hh"
 
+#include <chrono>
 #include <cstdlib>
 #include <functional>
 #include <list>
@@ -55,6 +56,9 @@ class EventLoop {
 
     //! Calls [poll(2)](\ref man2::poll) and then executes callback for each ready fd.
     Result wait_next_event(const int timeout_ms);
+
+    //! Same, with a microsecond-resolution timeout (e.g. for a pacing timer)
+    Result wait_next_event(const std::chrono::microseconds timeout);
 };
 
 using Direction = EventLoop::Direction;
@@ -47,6 +47,7 @@ class FileDescriptor {
   protected:
     void register_read() { ++_internal_fd->_read_count; }    //!< increment read count
     void register_write() { ++_internal_fd->_write_count; }  //!< increment write count
+    void register_eof() { _internal_fd->_eof = true; }        //!< set the EOF flag
 
   public:
     //! Construct from a file descriptor number returned by the kernel
@@ -0,0 +1,258 @@
+#include "shm_stream.hh"
+
+#include "util.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace std;
+
+static constexpr size_t CACHE_LINE = 64;  //!< Assumed size of a cache line, in bytes
+
+struct ShmRing::Header {
+    alignas(CACHE_LINE) atomic<uint64_t> head{0};           //!< Bytes popped so far (written by the reader)
+    alignas(CACHE_LINE) atomic<uint64_t> tail{0};           //!< Bytes pushed so far (written by the writer)
+    alignas(CACHE_LINE) atomic<bool> writer_closed{false};  //!< Set by close_writer()
+    atomic<bool> reader_closed{false};                      //!< Set by close_reader()
+};
+
+//! Smallest power of two that is at least `n`
+static size_t round_up(const size_t n) {
+    size_t ret = 1;
+    while (ret < n) {
+        ret <<= 1;
+    }
+    return ret;
+}
+
+static FileDescriptor make_eventfd() { return FileDescriptor{SystemCall("eventfd", ::eventfd(0, EFD_NONBLOCK))}; }
+
+//! \param[in] capacity is rounded up to a power of two, and to at least one page
+ShmRing::ShmRing(const size_t capacity)
+    : _header(nullptr)
+    , _data(nullptr)
+    , _capacity(round_up(max(capacity, size_t(SystemCall("sysconf", ::sysconf(_SC_PAGESIZE))))))
+    , _mapping_size(round_up(sizeof(Header)) + _capacity)
+    , _data_ready(make_eventfd())
+    , _space_ready(make_eventfd()) {
+    void *mapping = ::mmap(nullptr, _mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) {
+        throw unix_error("mmap");
+    }
+    _header = new (mapping) Header{};
+    _data = static_cast<char *>(mapping) + round_up(sizeof(Header));
+
+    _notify(_space_ready);  // an empty ring has room
+}
+
+ShmRing::~ShmRing() {
+    _header->~Header();
+    ::munmap(_header, _mapping_size);
+}
+
+void ShmRing::_notify(const FileDescriptor &fd) { SystemCall("eventfd_write", ::eventfd_write(fd.fd_num(), 1)); }
+
+void ShmRing::_clear(const FileDescriptor &fd) {
+    eventfd_t value = 0;
+    SystemCall("eventfd_read", ::eventfd_read(fd.fd_num(), &value), EAGAIN);
+}
+
+//! \details After publishing the new tail, the writer wakes the reader only if the reader had
+//! already consumed everything before this push; otherwise data_ready() is still readable.
+//! If the push fills the ring, the writer clears space_ready() and then checks again, so a pop
+//! that races with the clear cannot be lost.
+size_t ShmRing::push(const string_view data) {
+    Header &h = *_header;
+    if (h.reader_closed) {
+        throw unix_error("write", EPIPE);
+    }
+
+    const uint64_t tail = h.tail.load(memory_order_relaxed);
+    const size_t n = min(data.size(), _capacity - size_t(tail - h.head.load(memory_order_acquire)));
+    if (n > 0) {
+        const size_t offset = tail & (_capacity - 1);
+        const size_t first = min(n, _capacity - offset);
+        memcpy(_data + offset, data.data(), first);
+        memcpy(_data, data.data() + first, n - first);
+        h.tail.store(tail + n);
+
+        if (h.head.load() == tail) {
+            _notify(_data_ready);
+        }
+    }
+
+    if (h.tail.load(memory_order_relaxed) - h.head.load() == _capacity) {
+        _clear(_space_ready);
+        if (h.tail.load(memory_order_relaxed) - h.head.load() < _capacity or h.reader_closed) {
+            _notify(_space_ready);
+        }
+    }
+
+    return n;
+}
+
+//! \details Mirror image of push(): the reader wakes the writer only if the ring was full, and
+//! clears data_ready() (then checks again) when it empties the ring.
+size_t ShmRing::pop(string &out, const size_t limit) {
+    Header &h = *_header;
+    const uint64_t head = h.head.load(memory_order_relaxed);
+    const size_t n = min(limit, size_t(h.tail.load(memory_order_acquire) - head));
+    if (n > 0) {
+        const size_t offset = head & (_capacity - 1);
+        const size_t first = min(n, _capacity - offset);
+        out.append(_data + offset, first);
+        out.append(_data, n - first);
+        h.head.store(head + n);
+
+        if (h.tail.load() - head >= _capacity) {
+            _notify(_space_ready);
+        }
+    }
+
+    if (h.tail.load() == h.head.load(memory_order_relaxed) and not h.writer_closed and not h.reader_closed) {
+        _clear(_data_ready);
+        if (h.tail.load() != h.head.load(memory_order_relaxed) or h.writer_closed or h.reader_closed) {
+            _notify(_data_ready);
+        }
+    }
+
+    return n;
+}
+
+void ShmRing::close_writer() {
+    _header->writer_closed = true;
+    _notify(_data_ready);
+}
+
+void ShmRing::close_reader() {
+    _header->reader_closed = true;
+    _notify(_data_ready);
+    _notify(_space_ready);
+}
+
+bool ShmRing::writer_closed() const { return _header->writer_closed; }
+
+bool ShmRing::reader_closed() const { return _header->reader_closed; }
+
+size_t ShmRing::size() const { return _header->tail.load() - _header->head.load(); }
+
+//! Wait (without a timeout) until `fd` is readable
+static void wait_readable(const FileDescriptor &fd) {
+    pollfd pfd{fd.fd_num(), POLLIN, 0};
+    SystemCall("poll", ::poll(&pfd, 1, -1));
+}
+
+ShmStream::ShmStream(shared_ptr<ShmRing> inbound, shared_ptr<ShmRing> outbound)
+    : FileDescriptor(inbound->data_ready().duplicate())
+    , _inbound(move(inbound))
+    , _outbound(move(outbound))
+    , _writable(_outbound->space_ready().duplicate()) {}
+
+//! \param[in] capacity is the size of the ring in each direction (see ShmRing::ShmRing)
+pair<ShmStream, ShmStream> ShmStream::connected_pair(const size_t capacity) {
+    auto a_to_b = make_shared<ShmRing>(capacity);
+    auto b_to_a = make_shared<ShmRing>(capacity);
+    return {ShmStream(b_to_a, a_to_b), ShmStream(a_to_b, b_to_a)};
+}
+
+ShmStream::~ShmStream() {
+    if (_inbound) {
+        _inbound->close_reader();
+        _outbound->close_writer();
+    }
+}
+
+//! \param[in] limit is the maximum number of bytes to read; fewer bytes may be returned
+//! \param[out] str is the string to be read
+void ShmStream::read(string &str, const size_t limit) {
+    constexpr size_t BUFFER_SIZE = 1024 * 1024;  // maximum size of a read, as in FileDescriptor::read
+    const size_t size_to_read = min(BUFFER_SIZE, limit);
+    str.clear();
+
+    while (true) {
+        if (_inbound->pop(str, size_to_read) > 0 or size_to_read == 0) {
+            break;
+        }
+        // check the flags first: everything pushed before the ring was closed is then visible
+        const bool closed = _inbound->writer_closed() or _inbound->reader_closed();
+        if (closed and _inbound->size() == 0) {
+            register_eof();
+            break;
+        }
+        if (not _blocking) {
+            break;
+        }
+        wait_readable(_inbound->data_ready());
+    }
+
+    register_read();
+}
+
+//! \param[in] limit is the maximum number of bytes to read; fewer bytes may be returned
+string ShmStream::read(const size_t limit) {
+    string ret;
+
+    read(ret, limit);
+
+    return ret;
+}
+
+size_t ShmStream::write(BufferViewList buffer, const bool write_all) {
+    size_t total_bytes_written = 0;
+
+    while (buffer.size() > 0) {
+        size_t bytes_written = 0;
+        for (const auto &iov : buffer.as_iovecs()) {
+            const size_t n = _outbound->push({static_cast<const char *>(iov.iov_base), iov.iov_len});
+            bytes_written += n;
+            if (n < iov.iov_len) {
+                break;
+            }
+        }
+        buffer.remove_prefix(bytes_written);
+        total_bytes_written += bytes_written;
+
+        if (not _blocking or (bytes_written > 0 and not write_all)) {
+            break;
+        }
+        if (buffer.size() > 0) {
+            wait_readable(_outbound->space_ready());
+        }
+    }
+
+    register_write();
+    _writable.register_service();
+
+    return total_bytes_written;
+}
+
+//! \param[in] how can be `SHUT_RD`, `SHUT_WR`, or `SHUT_RDWR`, as in [shutdown(2)](\ref man2::shutdown)
+void ShmStream::shutdown(const int how) {
+    switch (how) {
+        case SHUT_RD:
+            _inbound->close_reader();
+            register_read();
+            break;
+        case SHUT_WR:
+            _outbound->close_writer();
+            register_write();
+            break;
+        case SHUT_RDWR:
+            _inbound->close_reader();
+            _outbound->close_writer();
+            register_read();
+            register_write();
+            break;
+        default:
+            throw runtime_error("ShmStream::shutdown() called with invalid `how`");
+    }
+}
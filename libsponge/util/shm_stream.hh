@@ -0,0 +1,163 @@
+#ifndef SPONGE_LIBSPONGE_SHM_STREAM_HH
+#define SPONGE_LIBSPONGE_SHM_STREAM_HH
+
+#include "buffer.hh"
+#include "eventloop.hh"
+#include "file_descriptor.hh"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+//! \brief A single-producer, single-consumer byte ring in a shared memory mapping
+//! \details The ring's indices and data live in one [mmap(2)](\ref man2::mmap)ed region. Moving
+//! bytes through the ring is a memcpy and an atomic store; the kernel is only involved to wake
+//! a thread that is waiting. For that, the ring keeps two [eventfd](\ref man2::eventfd)s in a
+//! level-triggered state:
+//!
+//! - data_ready() is readable whenever the ring holds data, or the writer has closed it
+//! - space_ready() is readable whenever the ring has free space, or the reader has closed it
+//!
+//! A side only touches an eventfd when the ring changes between empty and non-empty (or
+//! between full and not full), so a busy stream costs no system calls at all.
+class ShmRing {
+    //! Indices and flags, each on its own cache line
+    struct Header;
+
+    Header *_header;              //!< Start of the mapping
+    char *_data;                  //!< Ring storage, right after the header
+    size_t _capacity;             //!< Size of the ring storage (a power of two)
+    size_t _mapping_size;         //!< Size of the whole mapping
+    FileDescriptor _data_ready;   //!< Readable iff the reader has something to do
+    FileDescriptor _space_ready;  //!< Readable iff the writer has something to do
+
+    //! Make an eventfd readable
+    static void _notify(const FileDescriptor &fd);
+
+    //! Make an eventfd unreadable
+    static void _clear(const FileDescriptor &fd);
+
+  public:
+    //! Map a ring that holds at least `capacity` bytes
+    explicit ShmRing(const size_t capacity);
+
+    //! Unmap the ring
+    ~ShmRing();
+
+    //! \brief Copy as much of `data` as fits into the ring (writer only)
+    //! \returns the number of bytes copied; throws unix_error(EPIPE) if the reader has closed the ring
+    size_t push(const std::string_view data);
+
+    //! \brief Move up to `limit` bytes out of the ring and append them to `out` (reader only)
+    //! \returns the number of bytes moved
+    size_t pop(std::string &out, const size_t limit);
+
+    //! Stop writing: once the reader has drained the ring, it sees EOF
+    void close_writer();
+
+    //! Stop reading: later pushes fail, and the reader sees EOF once it has drained the ring
+    void close_reader();
+
+    //! \name Accessors
+    //!@{
+    bool writer_closed() const;
+    bool reader_closed() const;
+    size_t size() const;
+    size_t capacity() const { return _capacity; }
+    const FileDescriptor &data_ready() const { return _data_ready; }
+    const FileDescriptor &space_ready() const { return _space_ready; }
+    //!@}
+
+    //! \name
+    //! A ShmRing is shared by two threads through a std::shared_ptr; it cannot be copied or moved
+
+    //!@{
+    ShmRing(const ShmRing &other) = delete;
+    ShmRing &operator=(const ShmRing &other) = delete;
+    ShmRing(ShmRing &&other) = delete;
+    ShmRing &operator=(ShmRing &&other) = delete;
+    //!@}
+};
+
+//! \brief One end of a bidirectional byte stream over two ShmRing objects
+//! \details A ShmStream is used like a LocalStreamSocket: it has read(), write(), shutdown(),
+//! set_blocking() and eof(), with the same semantics. It is itself a FileDescriptor (the
+//! inbound ring's data_ready() eventfd), so an EventLoop can poll it with Direction::In as
+//! usual. Readiness to write is signaled on a separate descriptor, writable_fd(), which is
+//! polled with Direction::In; poll_for_write() picks the right pair for either kind of stream.
+class ShmStream : public FileDescriptor {
+    //! The outbound ring's space_ready() eventfd; writes count as servicing it
+    class WritableFD : public FileDescriptor {
+      public:
+        explicit WritableFD(FileDescriptor &&fd) : FileDescriptor(std::move(fd)) {}
+        void register_service() { register_read(); }
+    };
+
+    std::shared_ptr<ShmRing> _inbound;   //!< Ring this end reads from
+    std::shared_ptr<ShmRing> _outbound;  //!< Ring this end writes to
+    WritableFD _writable;                //!< Readable when _outbound has space
+    bool _blocking{true};                //!< Do read() and write() wait?
+
+    ShmStream(std::shared_ptr<ShmRing> inbound, std::shared_ptr<ShmRing> outbound);
+
+  public:
+    static constexpr size_t DEFAULT_CAPACITY = 1 << 20;  //!< Default size of each ring, in bytes
+
+    //! Create two connected ends, each direction buffered by a ring of `capacity` bytes
+    static std::pair<ShmStream, ShmStream> connected_pair(const size_t capacity = DEFAULT_CAPACITY);
+
+    //! Closes both directions of this end
+    ~ShmStream();
+
+    //! Read up to `limit` bytes (if blocking, wait until at least one byte is available or EOF)
+    std::string read(const size_t limit = std::numeric_limits<size_t>::max());
+
+    //! Read up to `limit` bytes into `str` (caller can allocate storage)
+    void read(std::string &str, const size_t limit = std::numeric_limits<size_t>::max());
+
+    //! Write a string, possibly blocking until all is written
+    size_t write(const char *str, const bool write_all = true) { return write(BufferViewList(str), write_all); }
+
+    //! Write a string, possibly blocking until all is written
+    size_t write(const std::string &str, const bool write_all = true) { return write(BufferViewList(str), write_all); }
+
+    //! Write a buffer (or list of buffers), possibly blocking until all is written
+    size_t write(BufferViewList buffer, const bool write_all = true);
+
+    //! Shut down this end for reading (`SHUT_RD`), writing (`SHUT_WR`), or both (`SHUT_RDWR`)
+    void shutdown(const int how);
+
+    //! Set blocking(true) or non-blocking(false)
+    void set_blocking(const bool blocking_state) { _blocking = blocking_state; }
+
+    //! Descriptor that is readable whenever write() can make progress
+    const FileDescriptor &writable_fd() const { return _writable; }
+
+    //! \name
+    //! A ShmStream can be move-constructed, but not copied or assigned
+
+    //!@{
+    ShmStream(ShmStream &&other) = default;
+    ShmStream &operator=(ShmStream &&other) = delete;
+    ShmStream(const ShmStream &other) = delete;
+    ShmStream &operator=(const ShmStream &other) = delete;
+    //!@}
+};
+
+//! \brief The FileDescriptor and Direction an EventLoop should poll to learn that `stream` is writable
+//! \details For an ordinary socket that is the socket itself, polled for Direction::Out.
+inline std::pair<const FileDescriptor &, Direction> poll_for_write(const FileDescriptor &stream) {
+    return {stream, Direction::Out};
+}
+
+//! For a ShmStream, it is ShmStream::writable_fd(), polled for Direction::In
+inline std::pair<const FileDescriptor &, Direction> poll_for_write(const ShmStream &stream) {
+    return {stream.writable_fd(), Direction::In};
+}
+
+#endif  // SPONGE_LIBSPONGE_SHM_STREAM_HH
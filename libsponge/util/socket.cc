@@ -3,6 +3,8 @@
 #include "util.hh"
 
 #include <cstddef>
+#include <cstring>
+#include <netinet/udp.h>
 #include <stdexcept>
 #include <unistd.h>
 
@@ -112,10 +114,12 @@ UDPSocket::received_datagram UDPSocket::recv(const size_t mtu) {
     return ret;
 }
 
+//! \param[in] segment_size if nonzero, the kernel splits the payload into datagrams of this many bytes (UDP GSO)
 void sendmsg_helper(const int fd_num,
                     const sockaddr *destination_address,
                     const socklen_t destination_address_len,
-                    const BufferViewList &payload) {
+                    const BufferViewList &payload,
+                    const uint16_t segment_size = 0) {
     auto iovecs = payload.as_iovecs();
 
     msghdr message{};
@@ -124,6 +128,17 @@ void sendmsg_helper(const int fd_num,
     message.msg_iov = iovecs.data();
     message.msg_iovlen = iovecs.size();
 
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(uint16_t))]{};
+    if (segment_size != 0) {
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+        cmsghdr *cmsg = CMSG_FIRSTHDR(&message);
+        cmsg->cmsg_level = SOL_UDP;
+        cmsg->cmsg_type = UDP_SEGMENT;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+        memcpy(CMSG_DATA(cmsg), &segment_size, sizeof(segment_size));
+    }
+
     const ssize_t bytes_sent = SystemCall("sendmsg", ::sendmsg(fd_num, &message, 0));
 
     if (size_t(bytes_sent) != payload.size()) {
@@ -136,6 +151,16 @@ void UDPSocket::sendto(const Address &destination, const BufferViewList &payload
     register_write();
 }
 
+//! \details See [udp(7)](\ref man7::udp) (UDP_SEGMENT). Every datagram but the last carries exactly
+//! `segment_size` bytes; the kernel limits how many one call may send (64 on older kernels) and the
+//! payload to one IP datagram's worth (65507 bytes).
+void UDPSocket::sendto_segmented(const Address &destination,
+                                 const BufferViewList &payload,
+                                 const uint16_t segment_size) {
+    sendmsg_helper(fd_num(), destination, destination.size(), payload, segment_size);
+    register_write();
+}
+
 void UDPSocket::send(const BufferViewList &payload) {
     sendmsg_helper(fd_num(), nullptr, 0, payload);
     register_write();
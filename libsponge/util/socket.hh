@@ -73,6 +73,9 @@ class UDPSocket : public Socket {
     //! Send a datagram to specified Address
     void sendto(const Address &destination, const BufferViewList &payload);
 
+    //! Send a run of datagrams of `segment_size` bytes each (the last may be shorter) with one system call
+    void sendto_segmented(const Address &destination, const BufferViewList &payload, const uint16_t segment_size);
+
     //! Send datagram to the socket's connected address (must call connect() first)
     void send(const BufferViewList &payload);
 };
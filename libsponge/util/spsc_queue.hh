@@ -0,0 +1,88 @@
+#ifndef SPONGE_LIBSPONGE_SPSC_QUEUE_HH
+#define SPONGE_LIBSPONGE_SPSC_QUEUE_HH
+
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+//! \brief A bounded, lock-free queue for exactly one producer thread and one consumer thread
+//! \details The queue is a ring of `capacity` slots (rounded up to a power of two). The producer
+//! only ever writes `_tail` and the consumer only ever writes `_head`, so the two threads
+//! synchronize through a single acquire/release pair per operation and never take a lock.
+//! Each index lives on its own cache line to avoid false sharing between the two threads.
+template <typename T>
+class SPSCQueue {
+  private:
+    static constexpr size_t CACHE_LINE = 64;  //!< Assumed size of a cache line, in bytes
+
+    std::vector<T> _slots;  //!< Ring storage; a slot is live iff it lies in [_head, _tail)
+    size_t _mask;           //!< `_slots.size() - 1`, used to map an index to a slot
+
+    alignas(CACHE_LINE) std::atomic<size_t> _head{0};  //!< Next slot to pop (written by the consumer)
+    alignas(CACHE_LINE) std::atomic<size_t> _tail{0};  //!< Next slot to push (written by the producer)
+
+    //! Smallest power of two that is at least `n`
+    static size_t round_up(const size_t n) {
+        size_t ret = 1;
+        while (ret < n) {
+            ret <<= 1;
+        }
+        return ret;
+    }
+
+  public:
+    //! Construct a queue that holds at least `capacity` elements
+    explicit SPSCQueue(const size_t capacity) : _slots(round_up(capacity)), _mask(_slots.size() - 1) {
+        if (capacity == 0) {
+            throw std::invalid_argument("SPSCQueue capacity must be positive");
+        }
+    }
+
+    //! \brief Append an element (producer only)
+    //! \returns `false`, leaving `item` untouched, if the queue is full
+    bool push(T &&item) {
+        const size_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail - _head.load(std::memory_order_acquire) == _slots.size()) {
+            return false;
+        }
+        _slots[tail & _mask] = std::move(item);
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    //! \brief Remove the oldest element into `item` (consumer only)
+    //! \returns `false` if the queue is empty
+    bool pop(T &item) {
+        const size_t head = _head.load(std::memory_order_relaxed);
+        if (head == _tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = std::move(_slots[head & _mask]);
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    //! Approximate number of queued elements (exact when called from the producer or consumer while the other is idle)
+    size_t size() const { return _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire); }
+
+    //! Approximate emptiness test (see SPSCQueue::size)
+    bool empty() const { return size() == 0; }
+
+    //! Number of elements the queue can hold
+    size_t capacity() const { return _slots.size(); }
+
+    //! \name
+    //! The indices are shared between two threads, so the queue is pinned in memory
+
+    //!@{
+    SPSCQueue(const SPSCQueue &other) = delete;
+    SPSCQueue &operator=(const SPSCQueue &other) = delete;
+    SPSCQueue(SPSCQueue &&other) = delete;
+    SPSCQueue &operator=(SPSCQueue &&other) = delete;
+    ~SPSCQueue() = default;
+    //!@}
+};
+
+#endif  // SPONGE_LIBSPONGE_SPSC_QUEUE_HH
@@ -0,0 +1,155 @@
+#ifndef SPONGE_LIBSPONGE_TASK_HH
+#define SPONGE_LIBSPONGE_TASK_HH
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+template <typename T>
+class Task;
+
+//! \brief The part of a Task's promise that does not depend on the result type
+class TaskPromiseBase {
+    std::coroutine_handle<> _continuation{};  //!< Coroutine to resume when this one finishes
+    std::exception_ptr _exception{};          //!< Exception that escaped from the coroutine body
+
+    //! On completion, transfer control straight to the awaiting coroutine (if there is one)
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+
+        template <typename PromiseT>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<PromiseT> handle) const noexcept {
+            const auto next = handle.promise()._continuation;
+            return next ? next : std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+  public:
+    //! \name Coroutine hooks
+    //!@{
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+    void unhandled_exception() { _exception = std::current_exception(); }
+    //!@}
+
+    //! Set the coroutine to resume when this one finishes
+    void set_continuation(const std::coroutine_handle<> continuation) { _continuation = continuation; }
+
+    //! Rethrow the exception that ended the coroutine, if any
+    void rethrow_if_failed() const {
+        if (_exception) {
+            std::rethrow_exception(_exception);
+        }
+    }
+};
+
+//! Promise of a Task that produces a T
+template <typename T>
+class TaskPromise : public TaskPromiseBase {
+    std::optional<T> _value{};  //!< The `co_return`ed value
+
+  public:
+    Task<T> get_return_object();
+
+    template <typename U>
+    void return_value(U &&value) {
+        _value.emplace(std::forward<U>(value));
+    }
+
+    //! The value the coroutine returned (or the exception it threw)
+    T result() {
+        rethrow_if_failed();
+        return std::move(_value).value();
+    }
+};
+
+//! Promise of a Task that produces nothing
+template <>
+class TaskPromise<void> : public TaskPromiseBase {
+  public:
+    Task<void> get_return_object();
+
+    void return_void() const noexcept {}
+
+    //! Rethrows the exception the coroutine threw, if any
+    void result() const { rethrow_if_failed(); }
+};
+
+//! \brief A lazily-started coroutine that produces a T
+//! \details A Task does nothing until it is `co_await`ed (or, at top level, handed to
+//! AsyncEventLoop::spawn()). When it finishes, the awaiting coroutine is resumed directly
+//! and receives the `co_return`ed value, or the exception that escaped from the Task.
+//! The Task owns its coroutine frame.
+template <typename T = void>
+class Task {
+  public:
+    using promise_type = TaskPromise<T>;  //!< Required by the coroutine machinery
+
+  private:
+    std::coroutine_handle<promise_type> _handle;  //!< The coroutine
+
+  public:
+    //! Take ownership of a coroutine (used by TaskPromise::get_return_object)
+    explicit Task(const std::coroutine_handle<promise_type> handle) : _handle(handle) {}
+
+    ~Task() {
+        if (_handle) {
+            _handle.destroy();
+        }
+    }
+
+    //! \name
+    //! A Task is move-only; moving transfers ownership of the coroutine frame
+
+    //!@{
+    Task(Task &&other) noexcept : _handle(std::exchange(other._handle, {})) {}
+    Task &operator=(Task &&other) noexcept {
+        if (this != &other) {
+            if (_handle) {
+                _handle.destroy();
+            }
+            _handle = std::exchange(other._handle, {});
+        }
+        return *this;
+    }
+    Task(const Task &other) = delete;
+    Task &operator=(const Task &other) = delete;
+    //!@}
+
+    //! \name Awaiter interface: `co_await task` runs the Task and yields its result
+    //!@{
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(const std::coroutine_handle<> awaiting) noexcept {
+        _handle.promise().set_continuation(awaiting);
+        return _handle;
+    }
+    T await_resume() { return _handle.promise().result(); }
+    //!@}
+
+    //! \name For top-level drivers (e.g. AsyncEventLoop)
+    //!@{
+
+    //! Run the Task until its first suspension point
+    void start() { _handle.resume(); }
+
+    //! Has the Task finished?
+    bool done() const { return not _handle or _handle.done(); }
+
+    //! The result of a finished Task (rethrows its exception, if any)
+    T result() { return _handle.promise().result(); }
+    //!@}
+};
+
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object() {
+    return Task<T>{std::coroutine_handle<TaskPromise<T>>::from_promise(*this)};
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() {
+    return Task<void>{std::coroutine_handle<TaskPromise<void>>::from_promise(*this)};
+}
+
+#endif  // SPONGE_LIBSPONGE_TASK_HH
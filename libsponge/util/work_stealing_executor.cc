@@ -0,0 +1,188 @@
+#include "work_stealing_executor.hh"
+
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+
+using namespace std;
+
+WorkStealingExecutor::WorkStealingExecutor(const size_t n_workers, const bool stealing, const size_t batch)
+    : _stealing(stealing), _batch(batch) {
+    if (n_workers == 0 or batch == 0) {
+        throw runtime_error("WorkStealingExecutor: need at least one worker and a positive batch size");
+    }
+    for (size_t i = 0; i < n_workers; i++) {
+        _workers.push_back(make_unique<Worker>());
+    }
+    for (size_t i = 0; i < n_workers; i++) {
+        _workers[i]->thread = thread(&WorkStealingExecutor::_worker_main, this, i);
+    }
+}
+
+WorkStealingExecutor::~WorkStealingExecutor() {
+    try {
+        wait_idle();
+        {
+            lock_guard<mutex> lock(_idle_mutex);
+            _stopping = true;
+        }
+        _work_available.notify_all();
+        for (auto &worker : _workers) {
+            worker->thread.join();
+        }
+    } catch (const exception &e) {
+        cerr << "Exception destructing WorkStealingExecutor: " << e.what() << endl;
+    }
+}
+
+shared_ptr<WorkStealingExecutor::Strand> WorkStealingExecutor::make_strand(const size_t home) {
+    const size_t worker = home == SIZE_MAX ? _next_home++ % _workers.size() : home;
+    if (worker >= _workers.size()) {
+        throw runtime_error("WorkStealingExecutor: no such worker");
+    }
+    return make_shared<Strand>(worker);
+}
+
+void WorkStealingExecutor::post(const shared_ptr<Strand> &strand, TaskT &&task) {
+    _pending_tasks++;
+
+    bool newly_ready = false;
+    {
+        lock_guard<mutex> lock(strand->_mutex);
+        strand->_tasks.push_back(move(task));
+        if (not strand->_scheduled) {
+            strand->_scheduled = true;
+            newly_ready = true;
+        }
+    }
+
+    // a Strand that is already scheduled will pick up the new task when it runs
+    if (newly_ready) {
+        _make_ready(strand, strand->_home);
+    }
+}
+
+void WorkStealingExecutor::_make_ready(shared_ptr<Strand> strand, const size_t worker) {
+    {
+        // counted in the same critical section as the push, so that _take() can never pop (and
+        // decrement) a Strand that has not been counted yet
+        Worker &w = *_workers[worker];
+        lock_guard<mutex> lock(w.mutex);
+        _ready_strands++;
+        w.ready.push_back(move(strand));
+    }
+    {
+        // a worker checks for work under _idle_mutex before it waits: taking it here means that
+        // the worker either sees the new Strand or is already waiting for the notification
+        lock_guard<mutex> lock(_idle_mutex);
+    }
+    // without stealing, only the owner of that queue can make progress
+    if (_stealing) {
+        _work_available.notify_one();
+    } else {
+        _work_available.notify_all();
+    }
+}
+
+shared_ptr<WorkStealingExecutor::Strand> WorkStealingExecutor::_take(const size_t self) {
+    {
+        Worker &w = *_workers[self];
+        lock_guard<mutex> lock(w.mutex);
+        if (not w.ready.empty()) {
+            auto strand = move(w.ready.front());
+            w.ready.pop_front();
+            _ready_strands--;
+            return strand;
+        }
+    }
+
+    if (not _stealing) {
+        return {};
+    }
+
+    // steal a whole Strand from the back of some other worker's queue
+    for (size_t i = 1; i < _workers.size(); i++) {
+        Worker &victim = *_workers[(self + i) % _workers.size()];
+        lock_guard<mutex> lock(victim.mutex);
+        if (not victim.ready.empty()) {
+            auto strand = move(victim.ready.back());
+            victim.ready.pop_back();
+            _ready_strands--;
+            _workers[self]->stats.steals++;
+            return strand;
+        }
+    }
+
+    return {};
+}
+
+void WorkStealingExecutor::_run(const shared_ptr<Strand> &strand, const size_t self) {
+    for (size_t i = 0; i < _batch; i++) {
+        TaskT task;
+        {
+            lock_guard<mutex> lock(strand->_mutex);
+            if (strand->_tasks.empty()) {
+                strand->_scheduled = false;
+                return;
+            }
+            task = move(strand->_tasks.front());
+            strand->_tasks.pop_front();
+        }
+
+        task();
+        _workers[self]->stats.tasks_run++;
+
+        if (--_pending_tasks == 0) {
+            lock_guard<mutex> lock(_idle_mutex);
+            _all_done.notify_all();
+        }
+    }
+
+    // batch exhausted: requeue behind the other ready Strands (on this worker, where it is now warm)
+    bool more = false;
+    {
+        lock_guard<mutex> lock(strand->_mutex);
+        more = not strand->_tasks.empty();
+        strand->_scheduled = more;
+    }
+    if (more) {
+        _make_ready(strand, _stealing ? self : strand->_home);
+    }
+}
+
+void WorkStealingExecutor::_worker_main(const size_t self) {
+    try {
+        while (true) {
+            auto strand = _take(self);
+            if (strand) {
+                _run(strand, self);
+                continue;
+            }
+
+            unique_lock<mutex> lock(_idle_mutex);
+            if (_stopping) {
+                return;
+            }
+            _work_available.wait(lock, [&] {
+                if (_stopping) {
+                    return true;
+                }
+                if (_stealing) {
+                    return _ready_strands.load() > 0;
+                }
+                Worker &w = *_workers[self];
+                lock_guard<mutex> ready_lock(w.mutex);
+                return not w.ready.empty();
+            });
+        }
+    } catch (const exception &e) {
+        cerr << "Exception in WorkStealingExecutor worker thread: " << e.what() << "\n";
+        throw;
+    }
+}
+
+void WorkStealingExecutor::wait_idle() {
+    unique_lock<mutex> lock(_idle_mutex);
+    _all_done.wait(lock, [&] { return _pending_tasks.load() == 0; });
+}
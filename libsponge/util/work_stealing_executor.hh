@@ -0,0 +1,127 @@
+#ifndef SPONGE_LIBSPONGE_WORK_STEALING_EXECUTOR_HH
+#define SPONGE_LIBSPONGE_WORK_STEALING_EXECUTOR_HH
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//! \brief A thread pool that runs tasks in per-connection serial queues ("strands")
+//! \details Tasks posted to the same Strand run one at a time, in the order they were posted,
+//! but possibly on different worker threads over time. This is the ordering a TCPConnection
+//! needs: its `segment_received()` and `tick()` calls must never overlap or be reordered.
+//!
+//! Each Strand has a home worker. When a Strand gets new work it is placed on its home
+//! worker's ready queue. A worker takes ready Strands from the front of its own queue and
+//! runs up to `batch` tasks from each. If work stealing is enabled, a worker whose queue is
+//! empty takes a whole Strand from the back of another worker's queue, so a few busy
+//! connections cannot pin one core while the others sit idle. With stealing disabled, the
+//! executor degenerates to static sharding (every Strand always runs on its home worker).
+class WorkStealingExecutor {
+  public:
+    using TaskT = std::function<void()>;  //!< A unit of work
+
+    //! \brief A serial queue of tasks (typically, one per connection)
+    class Strand {
+        friend class WorkStealingExecutor;
+
+        std::mutex _mutex{};         //!< Protects _tasks and _scheduled
+        std::deque<TaskT> _tasks{};  //!< Tasks not yet started
+        bool _scheduled{false};      //!< Is the Strand in a ready queue or being run by a worker?
+        const size_t _home;          //!< Index of the home worker
+
+      public:
+        //! Construct a Strand whose home is worker `home`
+        explicit Strand(const size_t home) : _home(home) {}
+
+        //! Index of the home worker
+        size_t home() const { return _home; }
+    };
+
+    //! Per-worker counters
+    struct WorkerStats {
+        std::atomic<uint64_t> tasks_run{0};  //!< Tasks executed by the worker
+        std::atomic<uint64_t> steals{0};     //!< Strands taken from another worker's ready queue
+    };
+
+  private:
+    //! State of one worker thread
+    struct Worker {
+        std::mutex mutex{};                           //!< Protects `ready`
+        std::deque<std::shared_ptr<Strand>> ready{};  //!< Strands with pending tasks
+        WorkerStats stats{};                          //!< Counters
+        std::thread thread{};                         //!< The worker thread
+    };
+
+    std::vector<std::unique_ptr<Worker>> _workers{};  //!< The workers
+    const bool _stealing;                             //!< May idle workers take Strands from other workers?
+    const size_t _batch;                              //!< Maximum tasks run from a Strand before moving on
+
+    std::mutex _idle_mutex{};                   //!< Protects sleeping and waking
+    std::condition_variable _work_available{};  //!< Signaled when a Strand becomes ready (or on shutdown)
+    std::condition_variable _all_done{};        //!< Signaled when the last pending task finishes
+    std::atomic<size_t> _ready_strands{0};      //!< Strands sitting in some ready queue
+    std::atomic<size_t> _pending_tasks{0};      //!< Tasks posted and not yet finished
+    std::atomic<size_t> _next_home{0};          //!< Round-robin home assignment for make_strand()
+    bool _stopping{false};                      //!< Set (under _idle_mutex) by the destructor
+
+    //! Place a Strand on a worker's ready queue and wake a worker to run it
+    void _make_ready(std::shared_ptr<Strand> strand, const size_t worker);
+
+    //! Take a ready Strand for worker `self`, stealing if allowed
+    std::shared_ptr<Strand> _take(const size_t self);
+
+    //! Run up to _batch tasks from a Strand on worker `self`
+    void _run(const std::shared_ptr<Strand> &strand, const size_t self);
+
+    //! Main loop of a worker thread
+    void _worker_main(const size_t self);
+
+  public:
+    static constexpr size_t DEFAULT_BATCH = 16;  //!< Default number of tasks run from a Strand per turn
+
+    //! \brief Start `n_workers` worker threads
+    //! \param[in] n_workers is the number of threads
+    //! \param[in] stealing enables work stealing (otherwise every Strand runs only on its home worker)
+    //! \param[in] batch is the maximum number of tasks to run from one Strand before servicing another
+    explicit WorkStealingExecutor(const size_t n_workers,
+                                  const bool stealing = true,
+                                  const size_t batch = DEFAULT_BATCH);
+
+    //! Finish every task already posted, then stop the workers
+    ~WorkStealingExecutor();
+
+    //! \brief Create a new Strand
+    //! \param[in] home is the home worker; by default, homes are assigned round-robin
+    std::shared_ptr<Strand> make_strand(const size_t home = SIZE_MAX);
+
+    //! \brief Append a task to a Strand (may be called from any thread, including from inside a task)
+    void post(const std::shared_ptr<Strand> &strand, TaskT &&task);
+
+    //! Block until every task posted so far has finished
+    void wait_idle();
+
+    //! \name Accessors
+    //!@{
+    size_t worker_count() const { return _workers.size(); }
+    const WorkerStats &stats(const size_t worker) const { return _workers.at(worker)->stats; }
+    //!@}
+
+    //! \name
+    //! The executor owns running threads, so it cannot be copied or moved
+
+    //!@{
+    WorkStealingExecutor(const WorkStealingExecutor &other) = delete;
+    WorkStealingExecutor &operator=(const WorkStealingExecutor &other) = delete;
+    WorkStealingExecutor(WorkStealingExecutor &&other) = delete;
+    WorkStealingExecutor &operator=(WorkStealingExecutor &&other) = delete;
+    //!@}
+};
+
+#endif  // SPONGE_LIBSPONGE_WORK_STEALING_EXECUTOR_HH
@@ -0,0 +1,269 @@
+#include "async_eventloop.hh"
+#include "async_tcp_socket.hh"
+#include "socket.hh"
+#include "task.hh"
+#include "tcp_config.hh"
+#include "tcp_sponge_socket.hh"
+#include "test_should_be.hh"
+#include "util.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <poll.h>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+using AsyncLocalSocket = AsyncTCPSocket<LocalStreamSocket>;
+
+static pair<FileDescriptor, FileDescriptor> make_socket_pair() {
+    int fds[2];
+    SystemCall("socketpair", ::socketpair(AF_UNIX, SOCK_STREAM, 0, static_cast<int *>(fds)));
+    return {FileDescriptor(fds[0]), FileDescriptor(fds[1])};
+}
+
+static Task<int> add_later(AsyncEventLoop &loop, const FileDescriptor &fd, const int x, const int y) {
+    co_await loop.readable(fd);
+    co_return x + y;
+}
+
+static Task<int> fail_later(AsyncEventLoop &loop, const FileDescriptor &fd) {
+    co_await loop.readable(fd);
+    throw runtime_error("expected failure");
+}
+
+//! Echo everything back until EOF, then end the outbound stream
+static Task<> echo(AsyncLocalSocket sock) {
+    while (true) {
+        const string data = co_await sock.read();
+        if (sock.eof()) {
+            break;
+        }
+        co_await sock.write(data);
+    }
+    sock.shutdown(SHUT_WR);
+}
+
+static Task<> send_all(AsyncLocalSocket sock, const string &data) {
+    co_await sock.write(data);
+    sock.shutdown(SHUT_WR);
+}
+
+static Task<> receive_all(AsyncLocalSocket sock, string &received) {
+    while (not sock.eof()) {
+        received += co_await sock.read();
+    }
+}
+
+//! Echo one connection on `server` (listening at `config.source`), on a thread of its own
+static thread echo_server(TCPOverUDPSpongeSocket &server, const TCPConfig &tcp_config, const FdAdapterConfig &config) {
+    return thread([&server, tcp_config, config] {
+        server.listen_and_accept(tcp_config, config);
+        while (not server.eof()) {
+            server.write(server.read());
+        }
+        server.wait_until_closed();
+    });
+}
+
+int main() {
+    try {
+        // Task results and exceptions propagate through co_await
+        {
+            AsyncEventLoop loop;
+            auto [a, b] = make_socket_pair();
+            LocalStreamSocket reader{move(a)}, writer{move(b)};
+            int sum = 0;
+            bool caught = false;
+
+            // (the lambda must outlive the coroutine, which refers to its captures)
+            auto body = [&]() -> Task<> {
+                sum = co_await add_later(loop, reader, 2, 3);
+                try {
+                    co_await fail_later(loop, reader);
+                } catch (const runtime_error &) {
+                    caught = true;
+                }
+            };
+            loop.spawn(body());
+            test_should_be(sum, 0);  // suspended: nothing to read yet
+
+            writer.write("x");
+            loop.run();
+            test_should_be(sum, 5);
+            test_should_be(caught, true);
+        }
+
+        // one thread drives many concurrent connections; the payload is larger than the socket buffers,
+        // so writers, readers and echoers all have to suspend and resume many times
+        {
+            constexpr size_t N_CONNECTIONS = 100;
+            const string payload = [] {
+                string ret(256 * 1024, 0);
+                for (size_t i = 0; i < ret.size(); i++) {
+                    ret[i] = char(i * 7 + i / 1000);
+                }
+                return ret;
+            }();
+
+            AsyncEventLoop loop;
+            vector<unique_ptr<LocalStreamSocket>> sockets;
+            vector<string> received(N_CONNECTIONS);
+            for (size_t i = 0; i < N_CONNECTIONS; i++) {
+                auto [a, b] = make_socket_pair();
+                auto &client = *sockets.emplace_back(make_unique<LocalStreamSocket>(move(a)));
+                auto &server = *sockets.emplace_back(make_unique<LocalStreamSocket>(move(b)));
+
+                loop.spawn(echo(AsyncLocalSocket{loop, server}));
+                loop.spawn(send_all(AsyncLocalSocket{loop, client}, payload));
+                loop.spawn(receive_all(AsyncLocalSocket{loop, client}, received[i]));
+            }
+            test_should_be(loop.pending(), 3 * N_CONNECTIONS);
+
+            loop.run();
+            test_should_be(loop.pending(), size_t(0));
+            for (const auto &r : received) {
+                test_should_be(r == payload, true);
+            }
+        }
+
+        // two coroutines may not wait on the same fd in the same direction
+        {
+            AsyncEventLoop loop;
+            auto [a, b] = make_socket_pair();
+            LocalStreamSocket reader{move(a)}, writer{move(b)};
+            auto wait = [&]() -> Task<> { co_await loop.readable(reader); };
+            loop.spawn(wait());
+            loop.spawn(wait());
+            writer.write("x");
+            bool threw = false;
+            try {
+                loop.run();
+            } catch (const runtime_error &) {
+                threw = true;
+            }
+            test_should_be(threw, true);
+        }
+
+        // co_await connect() on a TCPSpongeSocket, against a blocking peer on another thread
+        {
+            UDPSocket server_udp;
+            server_udp.bind(Address("127.0.0.1", "0"));
+            FdAdapterConfig server_config;
+            server_config.source = server_udp.local_address();
+            FdAdapterConfig client_config;
+            client_config.destination = server_config.source;
+            TCPConfig tcp_config;
+            tcp_config.rt_timeout = 100;
+
+            TCPOverUDPSpongeSocket server{TCPOverUDPSocketAdapter(move(server_udp))};
+            thread server_thread = echo_server(server, tcp_config, server_config);
+
+            AsyncEventLoop loop;
+            TCPOverUDPSpongeSocket client{TCPOverUDPSocketAdapter(UDPSocket{})};
+            const string request(100000, 'q');
+            string reply;
+            auto body = [&]() -> Task<> {
+                AsyncTCPSocket<TCPOverUDPSpongeSocket> sock{loop, client};
+                co_await sock.connect(tcp_config, client_config);
+                co_await sock.write(request);
+                sock.shutdown(SHUT_WR);
+                while (not sock.eof()) {
+                    reply += co_await sock.read();
+                }
+            };
+            loop.spawn(body());
+            loop.run();
+            client.wait_until_closed();
+            server_thread.join();
+
+            test_should_be(reply == request, true);
+        }
+
+        // two connects in a row: the second notification eventfd reuses the number of the first
+        {
+            TCPConfig tcp_config;
+            tcp_config.rt_timeout = 100;
+            vector<unique_ptr<TCPOverUDPSpongeSocket>> servers, clients;
+            vector<FdAdapterConfig> client_configs;
+            vector<thread> server_threads;
+            for (size_t i = 0; i < 2; i++) {
+                UDPSocket server_udp;
+                server_udp.bind(Address("127.0.0.1", "0"));
+                FdAdapterConfig server_config;
+                server_config.source = server_udp.local_address();
+                client_configs.emplace_back().destination = server_config.source;
+                servers.push_back(make_unique<TCPOverUDPSpongeSocket>(TCPOverUDPSocketAdapter(move(server_udp))));
+                server_threads.push_back(echo_server(*servers.back(), tcp_config, server_config));
+                clients.push_back(make_unique<TCPOverUDPSpongeSocket>(TCPOverUDPSocketAdapter(UDPSocket{})));
+            }
+
+            AsyncEventLoop loop;
+            vector<string> replies(2);
+            auto body = [&]() -> Task<> {
+                AsyncTCPSocket<TCPOverUDPSpongeSocket> first{loop, *clients[0]}, second{loop, *clients[1]};
+                co_await first.connect(tcp_config, client_configs[0]);
+                co_await second.connect(tcp_config, client_configs[1]);
+                for (auto *sock : {&first, &second}) {
+                    co_await sock->write("hello");
+                    sock->shutdown(SHUT_WR);
+                }
+                for (size_t i = 0; i < 2; i++) {
+                    while (not(i == 0 ? first : second).eof()) {
+                        replies[i] += co_await (i == 0 ? first : second).read();
+                    }
+                }
+            };
+            loop.spawn(body());
+            loop.run();
+            for (size_t i = 0; i < 2; i++) {
+                clients[i]->wait_until_closed();
+                server_threads[i].join();
+                test_should_be(replies[i] == "hello", true);
+            }
+        }
+
+        // an fd awaited right after an awaited fd with the same number was closed waits for itself
+        {
+            AsyncEventLoop loop;
+            auto [a, b] = make_socket_pair();
+            LocalStreamSocket reader{move(a)}, writer{move(b)};
+            bool reused = false, ready_when_resumed = false;
+            thread late_writer;
+            auto body = [&]() -> Task<> {
+                co_await loop.readable(reader);
+                const int number = reader.fd_num();
+                reader.close();
+                writer.close();
+                auto [c, d] = make_socket_pair();
+                LocalStreamSocket new_reader{move(c)}, new_writer{move(d)};
+                reused = new_reader.fd_num() == number;
+                late_writer = thread([&new_writer] {
+                    this_thread::sleep_for(chrono::milliseconds(50));
+                    new_writer.write("y");
+                });
+                co_await loop.readable(new_reader);
+                pollfd pfd{new_reader.fd_num(), POLLIN, 0};
+                ready_when_resumed = ::poll(&pfd, 1, 0) == 1;
+                late_writer.join();
+            };
+            loop.spawn(body());
+            writer.write("x");
+            loop.run();
+            test_should_be(reused, true);
+            test_should_be(ready_when_resumed, true);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,71 @@
+#include "buffer.hh"
+#include "byte_stream.hh"
+#include "tcp_config.hh"
+#include "tcp_sender.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+int main() {
+    try {
+        // a slice of a Buffer shares its storage
+        {
+            const Buffer whole{string("hello, world")};
+            const Buffer middle = whole.substr(7, 3);
+            test_should_be(middle.copy() == "wor", true);
+            test_should_be(middle.str().data() == whole.str().data() + 7, true);
+            test_should_be(whole.substr(7, 100).copy() == "world", true);
+            test_should_be(whole.substr(12, 1).size(), size_t(0));
+            Buffer rest = middle;
+            rest.remove_prefix(1);
+            test_should_be(rest.copy() == "or", true);
+        }
+
+        // reads within one write are views of it; a read across writes is a copy
+        {
+            ByteStream stream{100};
+            stream.write("abcdef");
+            stream.write("ghij");
+            test_should_be(stream.peek_output(8) == "abcdefgh", true);
+            const Buffer first = stream.read_buffer(4);
+            test_should_be(first.copy() == "abcd", true);
+            const Buffer second = stream.read_buffer(4);
+            test_should_be(second.copy() == "efgh", true);
+            test_should_be(stream.read_buffer(100).copy() == "ij", true);
+            test_should_be(stream.buffer_empty(), true);
+            test_should_be(stream.bytes_read(), size_t(10));
+            test_should_be(stream.read_buffer(100).size(), size_t(0));
+        }
+
+        // the sender's segments are slices of what the application wrote
+        {
+            TCPConfig cfg;
+            cfg.fixed_isn = WrappingInt32{0};
+            TCPSender sender{cfg};
+            sender.fill_window();
+            sender.segments_out().pop();
+            sender.ack_received(WrappingInt32{1}, 60000);
+            sender.stream_in().write(string(64 * MSS, 'x'));
+            sender.fill_window();
+            test_should_be(sender.segments_out().size(), size_t(60));
+            const char *data = sender.segments_out().front().payload().str().data();
+            for (size_t i = 0; i < 60; i++) {
+                test_should_be(sender.segments_out().front().payload().str().data() == data + i * MSS, true);
+                sender.segments_out().pop();
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,304 @@
+#include "congestion_control.hh"
+#include "path_simulator.hh"
+#include "tcp_config.hh"
+#include "tcp_sender.hh"
+#include "test_should_be.hh"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <string>
+
+using namespace std;
+
+static constexpr uint64_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+//! A sender that has completed the handshake with a peer advertising `window`
+static TCPSender established_sender(const CongestionControlAlgorithm algorithm, const uint16_t window) {
+    TCPConfig cfg;
+    cfg.fixed_isn = WrappingInt32{0};
+    cfg.send_capacity = 200000;
+    cfg.congestion_control = algorithm;
+    TCPSender sender{cfg};
+    sender.fill_window();
+    sender.segments_out().pop();
+    sender.ack_received(WrappingInt32{1}, window);
+    return sender;
+}
+
+int main() {
+    try {
+        // Reno: slow start, halving on loss, congestion avoidance, collapse on timeout
+        {
+            RenoCongestionControl reno{MSS, 10 * MSS};
+            test_should_be(reno.on_ack({0, 1001, MSS, 9 * MSS}), 11 * MSS);
+            test_should_be(reno.on_ack({0, 3001, 2 * MSS, 9 * MSS}), 12 * MSS);  // at most one MSS per ack
+
+            test_should_be(reno.on_loss(0, 20 * MSS, 40001), 13 * MSS);  // ssthresh + the three dupacks
+            test_should_be(reno.ssthresh(), 10 * MSS);
+            test_should_be(reno.in_recovery(), true);
+            test_should_be(reno.on_dupack(0), 14 * MSS);  // window inflation
+            test_should_be(reno.on_ack({0, 5001, MSS, 15 * MSS}), 10 * MSS);  // any new ack deflates and ends recovery
+            test_should_be(reno.in_recovery(), false);
+
+            for (int i = 0; i < 9; i++) {
+                reno.on_ack({0, 0, MSS, 9 * MSS});
+            }
+            test_should_be(reno.cwnd(), 10 * MSS);  // one window's worth of acks for one MSS of growth
+            test_should_be(reno.on_ack({0, 0, MSS, 9 * MSS}), 11 * MSS);
+
+            for (int i = 0; i < 30; i++) {
+                reno.on_ack({0, 0, MSS, 2 * MSS});
+            }
+            test_should_be(reno.cwnd(), 11 * MSS);  // the window isn't the limit, so it doesn't grow
+
+            test_should_be(reno.on_timeout(0, 11 * MSS), MSS);
+            test_should_be(reno.ssthresh(), uint64_t(5500));
+            test_should_be(reno.on_ack({0, 0, MSS, 0}), 2 * MSS);
+
+            test_should_be(reno.on_timeout(0, MSS), MSS);
+            test_should_be(reno.ssthresh(), 2 * MSS);  // never below two segments
+        }
+
+        // NewReno stays in recovery through partial acks, so two losses in a window halve it once
+        {
+            NewRenoCongestionControl newreno{MSS, 20 * MSS};
+            RenoCongestionControl reno{MSS, 20 * MSS};
+            for (RenoCongestionControl *cc : {static_cast<RenoCongestionControl *>(&newreno), &reno}) {
+                cc->on_loss(0, 20 * MSS, 20001);
+                cc->on_ack({0, 5001, MSS, 16 * MSS});  // partial ack
+                if (not cc->in_recovery()) {
+                    cc->on_loss(0, 16 * MSS, 20001);  // Reno sees the second loss as a new event
+                }
+            }
+            test_should_be(newreno.ssthresh(), 10 * MSS);
+            test_should_be(reno.ssthresh(), 8 * MSS);
+            test_should_be(newreno.cwnd(), 13 * MSS);  // the partial ack deflated by one MSS and added one back
+            test_should_be(newreno.on_ack({0, 9001, 4 * MSS, 12 * MSS}), 10 * MSS);  // deflated by 4, plus 1
+            test_should_be(newreno.on_ack({0, 20001, 15 * MSS, 0}), 2 * MSS);  // full ack: min(ssthresh, flight + MSS)
+            test_should_be(newreno.in_recovery(), false);
+        }
+
+        // CUBIC: decrease by beta, then a cubic climb that regains W_max after K seconds
+        {
+            CubicCongestionControl cubic{MSS, 100 * MSS};
+            test_should_be(cubic.on_loss(0, 100 * MSS, 100001), 73 * MSS);
+            test_should_be(cubic.w_max(), 100.0);
+            test_should_be(cubic.on_ack({0, 100001, MSS, 69 * MSS, 0, 100001}), 70 * MSS);  // recovery ends
+
+            // one window of acks per 100 ms round trip, with the sender keeping the window full
+            const uint64_t rtt = 100'000;
+            uint64_t now = 0;
+            uint64_t ackno = 100001;
+            const auto run_until = [&](const uint64_t end_us) {
+                for (; now < end_us; now += rtt) {
+                    for (uint64_t acks = cubic.cwnd() / MSS; acks > 0; acks--) {
+                        ackno += MSS;
+                        cubic.on_ack({now, ackno, MSS, cubic.cwnd() - MSS, rtt, ackno + cubic.cwnd()});
+                    }
+                }
+            };
+            const double k = cbrt(30 / CubicCongestionControl::C);
+            run_until(uint64_t(k / 2 * 1e6));
+            test_should_be(cubic.cwnd() > 90 * MSS, true);  // concave: most of the way back after K/2
+            run_until(uint64_t(k * 1e6));
+            test_should_be(cubic.cwnd() >= 98 * MSS and cubic.cwnd() <= 102 * MSS, true);
+            run_until(uint64_t(k * 1e6) + 2'000'000);
+            test_should_be(cubic.cwnd() > 103 * MSS, true);  // convex: probing beyond W_max
+
+            // a loss below the previous W_max releases bandwidth (fast convergence)
+            CubicCongestionControl converging{MSS, 100 * MSS};
+            converging.on_loss(0, 100 * MSS, 100001);
+            converging.on_ack({0, 100001, MSS, 69 * MSS, 0, 100001});
+            converging.on_loss(0, 70 * MSS, 200001);
+            test_should_be(converging.w_max(), 70 * (1 + CubicCongestionControl::BETA) / 2);
+            test_should_be(converging.ssthresh(), 49 * MSS);
+        }
+
+        // HyStart: slow start ends when a round's RTT rises clearly above the previous round's
+        {
+            for (const uint64_t second_rtt : {100'000, 125'000}) {
+                CubicCongestionControl cubic{MSS, 10 * MSS};
+                uint64_t ackno = 1;
+                for (const uint64_t rtt : {uint64_t(100'000), second_rtt}) {
+                    for (uint64_t acks = cubic.cwnd() / MSS; acks > 0; acks--) {
+                        ackno += MSS;
+                        cubic.on_ack({0, ackno, MSS, cubic.cwnd() - MSS, rtt, ackno + cubic.cwnd()});
+                    }
+                }
+                test_should_be(cubic.ssthresh() <= cubic.cwnd(), second_rtt > 100'000);  // left slow start
+            }
+        }
+
+        // BBR: Startup until the bandwidth stops growing, Drain, then ProbeBW; ProbeRTT when RTprop is stale
+        {
+            BbrCongestionControl bbr{MSS, 10 * MSS};
+            uint64_t now = 0;
+            uint64_t ackno = 1;
+            // a 1 MB/s path with a 10 ms RTT; every ack carries a rate sample. Unless `flight` is
+            // given, the sender keeps the window full.
+            const auto ack_round = [&](const uint64_t rtt, const optional<uint64_t> flight = {}) {
+                const uint64_t round_end = ackno + bbr.cwnd();
+                for (uint64_t acks = bbr.cwnd() / MSS; acks > 0; acks--) {
+                    ackno += MSS;
+                    now += 1000;
+                    AckSample ack{now, ackno, MSS, flight.value_or(bbr.cwnd() - MSS), rtt, round_end};
+                    ack.delivered = 10 * MSS;
+                    ack.interval_us = 10'000;
+                    bbr.on_ack(ack);
+                }
+            };
+            ack_round(10'000);
+            test_should_be(bbr.bandwidth(), uint64_t(1'000'000));
+            test_should_be(bbr.min_rtt_us(), uint64_t(10'000));
+            test_should_be(bbr.mode() == BbrCongestionControl::Mode::Startup, true);
+            for (int round = 0; round < 4; round++) {
+                ack_round(10'000);
+            }
+            test_should_be(bbr.mode() == BbrCongestionControl::Mode::Drain, true);  // 3 rounds without growth
+            ack_round(10'000, 9 * MSS);  // the queue Startup built has drained
+            test_should_be(bbr.mode() == BbrCongestionControl::Mode::ProbeBW, true);
+            test_should_be(bbr.cwnd(), uint64_t(2 * 10'000));  // two BDPs
+            test_should_be(bbr.pacing_rate() <= uint64_t(1'250'000), true);
+
+            // a loss holds the window at the flight size until recovery ends; the model is untouched
+            test_should_be(bbr.on_loss(now, 5 * MSS, ackno + 10 * MSS), 6 * MSS);
+            test_should_be(bbr.bandwidth(), uint64_t(1'000'000));
+
+            while (now < BbrCongestionControl::MIN_RTT_WINDOW_US + 200'000) {
+                ack_round(12'000);
+            }
+            test_should_be(bbr.mode() == BbrCongestionControl::Mode::ProbeRTT, true);
+            test_should_be(bbr.cwnd(), BbrCongestionControl::MIN_CWND_SEGMENTS * MSS);
+        }
+
+        // delivery-rate sampling and pacing in the TCPSender
+        {
+            TCPSender sender = established_sender(CongestionControlAlgorithm::Bbr, 60000);
+            const auto *bbr = dynamic_cast<const BbrCongestionControl *>(sender.congestion_control());
+            test_should_be(bbr != nullptr, true);
+            sender.stream_in().write(string(10 * MSS, 'x'));
+            sender.fill_window();
+            test_should_be(sender.segments_out().size(), size_t(10));  // no RTT sample yet: no pacing
+            while (not sender.segments_out().empty()) {
+                sender.segments_out().pop();
+            }
+            sender.tick_us(10'000);
+            sender.ack_received(WrappingInt32{uint32_t(1 + 10 * MSS)}, 60000);
+            test_should_be(bbr->bandwidth(), uint64_t(1'000'000));  // 10 segments in 10 ms
+            test_should_be(bbr->min_rtt_us(), uint64_t(10'000));
+
+            // Startup paces at 2.885 MB/s: about one segment per 350 us
+            sender.stream_in().write(string(20 * MSS, 'x'));
+            sender.fill_window();
+            test_should_be(sender.segments_out().size() <= 2, true);
+            for (int i = 0; i < 3; i++) {
+                sender.tick_us(1000);
+            }
+            test_should_be(sender.segments_out().size() >= 8 and sender.segments_out().size() <= 11, true);
+            for (int i = 0; i < 5; i++) {
+                sender.tick_us(1000);
+            }
+            test_should_be(sender.segments_out().size(), size_t(20));
+        }
+
+        // on a simulated path with a deep buffer, BBR keeps the queue short where CUBIC fills it
+        {
+            PathConfig path;
+            path.rate_bps = 4'000'000;
+            path.rtt_us = 40'000;
+            path.queue_bytes = 64'000;
+            path.step_us = 100;
+            double queue_delay[2];
+            uint64_t delivered[2];
+            const CongestionControlAlgorithm algorithms[2] = {CongestionControlAlgorithm::Cubic,
+                                                              CongestionControlAlgorithm::Bbr};
+            for (size_t i = 0; i < 2; i++) {
+                TCPConfig sender_cfg;
+                sender_cfg.congestion_control = algorithms[i];
+                sender_cfg.send_capacity = 1'000'000;
+                PathSimulator sim{sender_cfg, TCPConfig{}, path};
+                sim.run_for(10'000'000);
+                queue_delay[i] = sim.stats().mean_queue_delay_us();
+                delivered[i] = sim.stats().bytes_delivered;
+            }
+            test_should_be(queue_delay[1] * 3 < queue_delay[0], true);
+            test_should_be(delivered[1] * 10 > delivered[0] * 9, true);  // at (nearly) the same goodput
+        }
+
+        // without congestion control the receiver's window is the limit; with it, min(cwnd, rwnd)
+        {
+            TCPSender plain = established_sender(CongestionControlAlgorithm::None, 60000);
+            plain.stream_in().write(string(100000, 'x'));
+            plain.fill_window();
+            test_should_be(plain.bytes_in_flight(), size_t(60000));
+            test_should_be(plain.congestion_control() == nullptr, true);
+
+            TCPSender sender = established_sender(CongestionControlAlgorithm::Reno, 60000);
+            const uint64_t cwnd = sender.congestion_control()->cwnd();
+            sender.stream_in().write(string(100000, 'x'));
+            sender.fill_window();
+            test_should_be(sender.bytes_in_flight(), size_t(cwnd / MSS * MSS));  // whole segments only
+
+            TCPSender small_rwnd = established_sender(CongestionControlAlgorithm::Reno, 3000);
+            small_rwnd.stream_in().write(string(100000, 'x'));
+            small_rwnd.fill_window();
+            test_should_be(small_rwnd.bytes_in_flight(), size_t(3000));
+        }
+
+        // three duplicate ACKs: fast retransmit, then NewReno retransmits again on a partial ack
+        {
+            TCPSender sender = established_sender(CongestionControlAlgorithm::NewReno, 60000);
+            sender.stream_in().write(string(8 * MSS, 'x'));
+            sender.fill_window();
+            test_should_be(sender.segments_out().size(), size_t(8));
+            while (not sender.segments_out().empty()) {
+                sender.segments_out().pop();
+            }
+
+            // the first segment is lost; the next ones each produce a duplicate ACK
+            sender.ack_received(WrappingInt32{1}, 60000);
+            sender.ack_received(WrappingInt32{1}, 60000, false);  // carried data: not a duplicate ACK
+            sender.ack_received(WrappingInt32{1}, 60000);
+            test_should_be(sender.segments_out().size(), size_t(0));
+            sender.ack_received(WrappingInt32{1}, 60000);
+            test_should_be(sender.segments_out().size(), size_t(1));
+            test_should_be(sender.segments_out().front().header().seqno, WrappingInt32{1});
+            sender.segments_out().pop();
+            test_should_be(sender.congestion_control()->in_recovery(), true);
+            test_should_be(sender.congestion_control()->ssthresh(), 4 * MSS);  // half of the flight
+            test_should_be(sender.congestion_control()->cwnd(), 7 * MSS);       // plus the three dupacks
+
+            // more duplicates don't trigger another retransmission; they inflate the window, which
+            // lets new data out once it exceeds the flight
+            sender.stream_in().write(string(2 * MSS, 'x'));
+            sender.ack_received(WrappingInt32{1}, 60000);
+            test_should_be(sender.segments_out().size(), size_t(0));
+            test_should_be(sender.congestion_control()->cwnd(), 8 * MSS);
+            sender.ack_received(WrappingInt32{1}, 60000);
+            sender.fill_window();
+            test_should_be(sender.segments_out().size(), size_t(1));
+            test_should_be(sender.segments_out().front().header().seqno, WrappingInt32{uint32_t(1 + 8 * MSS)});
+            sender.segments_out().pop();
+
+            // the retransmission fills the first hole, but the third segment was lost as well
+            sender.ack_received(WrappingInt32{uint32_t(1 + 2 * MSS)}, 60000);
+            test_should_be(sender.segments_out().size(), size_t(1));
+            test_should_be(sender.segments_out().front().header().seqno, WrappingInt32{uint32_t(1 + 2 * MSS)});
+            sender.segments_out().pop();
+
+            sender.ack_received(WrappingInt32{uint32_t(1 + 9 * MSS)}, 60000);
+            test_should_be(sender.segments_out().size(), size_t(0));
+            test_should_be(sender.congestion_control()->in_recovery(), false);
+            test_should_be(sender.bytes_in_flight(), size_t(0));
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,203 @@
+#include "aqm_fd_adapter.hh"
+#include "fd_adapter.hh"
+#include "ipv4_header.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_connection_pair.hh"
+#include "tcp_over_ip.hh"
+#include "tcp_segment.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <queue>
+#include <string>
+#include <utility>
+
+using namespace std;
+
+//! Stands in for a real FD adapter: what is written is queued for the test to pass on
+class QueueAdapter : public FdAdapterBase {
+    shared_ptr<queue<TCPSegment>> _written;
+
+  public:
+    explicit QueueAdapter(shared_ptr<queue<TCPSegment>> written) : _written(move(written)) {}
+    optional<TCPSegment> read() { return {}; }
+    void write(TCPSegment &seg) { _written->push(seg); }
+};
+
+//! Payload bytes the server received in `duration_us` of a bulk transfer over a path with a 10 ms
+//! RTT, with `aqm` in front of the data direction (it writes to `wire`)
+static size_t transfer(const bool ecn, AqmFdAdapter<QueueAdapter> &aqm, const shared_ptr<queue<TCPSegment>> &wire,
+                       const uint64_t duration_us, uint64_t &retransmitted) {
+    constexpr uint64_t step_us = 500, one_way_us = 5'000;
+    TCPConfig cfg;
+    cfg.congestion_control = CongestionControlAlgorithm::NewReno;
+    cfg.ecn = ecn;
+    TCPConnection client{cfg}, server{cfg};
+    handshake(client, server);
+
+    deque<pair<uint64_t, TCPSegment>> data_path, ack_path;
+    optional<WrappingInt32> next_seqno{};
+    retransmitted = 0;
+    for (uint64_t now_us = 0; now_us < duration_us; now_us += step_us) {
+        while (client.remaining_outbound_capacity() > 0) {
+            client.write(string(client.remaining_outbound_capacity(), 'x'));
+        }
+        for (; not client.segments_out().empty(); client.segments_out().pop()) {
+            aqm.write(client.segments_out().front());
+        }
+        for (; not wire->empty(); wire->pop()) {
+            const WrappingInt32 seqno = wire->front().header().seqno;
+            if (wire->front().payload().size() > 0) {
+                if (next_seqno && seqno - *next_seqno < 0) {
+                    retransmitted++;  // not beyond what was sent before
+                } else {
+                    next_seqno = seqno + uint32_t(wire->front().length_in_sequence_space());
+                }
+            }
+            data_path.emplace_back(now_us + one_way_us, wire->front());
+        }
+        for (; not data_path.empty() && data_path.front().first <= now_us; data_path.pop_front()) {
+            server.segment_received(data_path.front().second);
+        }
+        for (; not server.segments_out().empty(); server.segments_out().pop()) {
+            ack_path.emplace_back(now_us + one_way_us, server.segments_out().front());
+        }
+        for (; not ack_path.empty() && ack_path.front().first <= now_us; ack_path.pop_front()) {
+            client.segment_received(ack_path.front().second);
+        }
+        server.inbound_stream().pop_output(server.inbound_stream().buffer_size());
+        client.tick_us(step_us);
+        server.tick_us(step_us);
+        aqm.tick_us(step_us);
+    }
+    return server.inbound_stream().bytes_written();
+}
+
+int main() {
+    try {
+        // the ECN flags survive serialization, and the codepoint travels in the IPv4 header
+        {
+            TCPSegment seg;
+            seg.header().ece = true;
+            seg.header().cwr = true;
+            seg.set_ecn(IPv4Header::ECN_CE);
+            TCPOverIPv4Adapter a, b;
+            a.config_mut().source = {"10.0.0.1", 1000};
+            a.config_mut().destination = {"10.0.0.2", 2000};
+            b.config_mut().source = a.config().destination;
+            b.config_mut().destination = a.config().source;
+            InternetDatagram dgram;
+            test_should_be(dgram.parse(a.wrap_tcp_in_ip(seg).serialize().concatenate()) == ParseResult::NoError, true);
+            test_should_be(dgram.header().ecn(), IPv4Header::ECN_CE);
+            const optional<TCPSegment> parsed = b.unwrap_tcp_in_ip(dgram);
+            test_should_be(parsed.has_value(), true);
+            test_should_be(parsed->header().ece, true);
+            test_should_be(parsed->header().cwr, true);
+            test_should_be(parsed->ecn(), IPv4Header::ECN_CE);
+
+            IPv4Header header;
+            header.tos = 0b1011'1000;  // a DSCP value, not ECN-capable
+            header.set_ecn(IPv4Header::ECN_ECT0);
+            test_should_be(header.tos, uint8_t(0b1011'1010));
+        }
+
+        // negotiation: data is ECN-capable only if both SYNs agreed
+        for (const bool server_ecn : {false, true}) {
+            TCPConfig cfg, server_cfg;
+            cfg.ecn = true;
+            server_cfg.ecn = server_ecn;
+            TCPConnection client{cfg}, server{server_cfg};
+            client.connect();
+            test_should_be(client.segments_out().front().header().ece, true);
+            test_should_be(client.segments_out().front().header().cwr, true);
+            deliver(client, server);
+            test_should_be(server.segments_out().front().header().ece, server_ecn);
+            test_should_be(server.segments_out().front().header().cwr, false);
+            deliver(server, client);
+            deliver(client, server);
+            client.write("data");
+            test_should_be(client.segments_out().front().ecn(),
+                           server_ecn ? IPv4Header::ECN_ECT0 : IPv4Header::ECN_NOT_ECT);
+        }
+
+        // a CE mark is echoed until CWR; the sender reduces its window once, and retransmits nothing
+        {
+            TCPConfig cfg;
+            cfg.ecn = true;
+            cfg.quickack = false;
+            cfg.congestion_control = CongestionControlAlgorithm::NewReno;
+            TCPConnection client{cfg}, server{cfg};
+            handshake(client, server);
+            const uint64_t cwnd = client.sender().congestion_control()->cwnd();
+
+            client.write(string(4 * TCPConfig::MAX_PAYLOAD_SIZE, 'x'));
+            test_should_be(client.segments_out().size(), size_t(4));
+            client.segments_out().front().set_ecn(IPv4Header::ECN_CE);  // a congested queue marks it
+            deliver(client, server);
+            // the mark is acknowledged at once, not delayed
+            test_should_be(server.segments_out().empty(), false);
+            test_should_be(server.segments_out().back().header().ece, true);
+            test_should_be(server.receiver().ece(), true);
+            deliver(server, client);
+            test_should_be(client.sender().congestion_control()->cwnd() < cwnd, true);
+            const uint64_t reduced = client.sender().congestion_control()->cwnd();
+            test_should_be(client.segments_out().empty(), true);
+            // the delayed ACK for the rest still echoes, but the window was already reduced for this data
+            server.tick_us(cfg.delayed_ack_us);
+            test_should_be(server.segments_out().back().header().ece, true);
+            deliver(server, client);
+            test_should_be(client.bytes_in_flight(), size_t(0));
+            test_should_be(client.sender().congestion_control()->cwnd(), reduced);
+
+            // the next data carries CWR (and is ECN-capable); its ack no longer echoes
+            client.write("more");
+            test_should_be(client.segments_out().front().header().cwr, true);
+            test_should_be(client.segments_out().front().ecn(), IPv4Header::ECN_ECT0);
+            deliver(client, server);
+            test_should_be(server.receiver().ece(), false);
+            server.tick_us(cfg.delayed_ack_us);
+            test_should_be(server.segments_out().back().header().ece, false);
+            deliver(server, client);
+            test_should_be(client.sender().congestion_control()->cwnd() >= reduced, true);
+
+            client.write("again");
+            test_should_be(client.segments_out().front().header().cwr, false);
+        }
+
+        // an AQM queue: with ECN, congestion is signaled by marks, without losses; without it, by drops
+        {
+            constexpr uint64_t rate = 1'000'000;  // 8 Mbit/s
+            for (const bool ecn : {true, false}) {
+                const auto wire = make_shared<queue<TCPSegment>>();
+                AqmFdAdapter<QueueAdapter> aqm{QueueAdapter{wire}};
+                aqm.config_mut().aqm_rate = rate;
+                aqm.config_mut().aqm_threshold = 15'000;
+                uint64_t retransmitted = 0;
+                const size_t received = transfer(ecn, aqm, wire, 2'000'000, retransmitted);
+                if (ecn) {
+                    test_should_be(aqm.marked() > 0, true);
+                    test_should_be(aqm.aqm_dropped(), uint64_t(0));
+                    test_should_be(retransmitted, uint64_t(0));
+                } else {
+                    test_should_be(aqm.marked(), uint64_t(0));
+                    test_should_be(aqm.aqm_dropped() > 0, true);
+                    test_should_be(retransmitted > 0, true);
+                }
+                // either way, the flow keeps the bottleneck mostly busy
+                test_should_be(received > 2 * rate * 6 / 10, true);
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
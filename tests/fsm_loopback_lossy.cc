@@ -0,0 +1,83 @@
+#include "tcp_config.hh"
+#include "tcp_expectation.hh"
+#include "tcp_fsm_test_harness.hh"
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace std;
+using State = TCPTestHarness::State;
+
+static constexpr unsigned NREPS = 32;
+static constexpr size_t MAX_MS = 600'000;
+static constexpr uint32_t DROP_SEED = 3;  //!< The losses are the same on every run
+
+//! \brief Loop `cfg.recv_capacity` bytes back into one FSM, dropping each data segment with probability `loss`
+//! \returns the number of milliseconds the transfer took
+static size_t lossy_loopback(const TCPConfig &cfg, const double loss, mt19937 &rd, mt19937 &drops) {
+    const WrappingInt32 rx_offset(rd());
+    TCPTestHarness test = TCPTestHarness::in_established(cfg, rx_offset - 1, rx_offset - 1);
+    test.send_ack(rx_offset, rx_offset, 65000);
+
+    string d(cfg.recv_capacity, 0);
+    generate(d.begin(), d.end(), [&] { return rd(); });
+    test.execute(Write{d}.with_bytes_written(d.size()));
+
+    bernoulli_distribution drop{loss};
+    size_t ms = 0;
+    while (true) {
+        // deliver (or lose) everything the FSM sent, including the acks its own segments produce
+        while (test.can_read()) {
+            TCPSegment seg = test.expect_seg(ExpectSegment{});
+            if (seg.payload().size() > 0 and drop(drops)) {
+                continue;
+            }
+            test.execute(SendSegment{move(seg)});
+        }
+        if (test._fsm.bytes_in_flight() == 0 and test._fsm.inbound_stream().buffer_size() == d.size()) {
+            break;
+        }
+        test_err_if(++ms > MAX_MS, "transfer did not complete");
+        test.execute(Tick(1));
+    }
+
+    test.execute(ExpectData{}.with_data(d), "got back the wrong data");
+    return ms;
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // every loss costs the legacy sender a full RTO; with congestion control, losses that
+        // produce three duplicate ACKs are repaired by a fast retransmission instead
+        for (const double loss : {0.01, 0.03, 0.05}) {
+            size_t ms[2] = {0, 0};
+            for (size_t fast_retx = 0; fast_retx < 2; fast_retx++) {
+                TCPConfig cfg{};
+                cfg.recv_capacity = 65000;
+                cfg.send_capacity = 65000;
+                cfg.congestion_control =
+                    fast_retx ? CongestionControlAlgorithm::NewReno : CongestionControlAlgorithm::None;
+                mt19937 drops{DROP_SEED};
+                for (unsigned rep_no = 0; rep_no < NREPS; ++rep_no) {
+                    ms[fast_retx] += lossy_loopback(cfg, loss, rd, drops);
+                }
+            }
+            test_err_if(ms[1] * 4 > ms[0], "fast retransmit should repair most losses without a timeout");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
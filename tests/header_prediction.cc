@@ -0,0 +1,183 @@
+#include "congestion_control.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_connection_pair.hh"
+#include "tcp_segment.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+//! Every segment both ends of a transfer sent, as it went on the wire, and how many segments took each path
+struct Transfer {
+    vector<string> wire{};
+    HeaderPredictionStats client{}, server{};
+    size_t received{0};
+};
+
+//! \brief A 1 MB upload from the client, with a short reply from the server every 50 ms, over a path with
+//! a 10 ms RTT that loses every 97th data segment; then both ends close
+static Transfer transfer(TCPConfig cfg, const bool header_prediction) {
+    constexpr size_t total = 1024 * 1024;
+    constexpr uint64_t one_way_ms = 5;
+    cfg.header_prediction = header_prediction;
+    cfg.fixed_isn = WrappingInt32{0xffff'0000};  // wraps during the transfer
+    TCPConnection client{cfg}, server{cfg};
+    Transfer result;
+    deque<pair<uint64_t, TCPSegment>> data_path, ack_path;
+    size_t written = 0, data_segments = 0;
+
+    // queue what `from` sent on `path`, recording it (and dropping some of the data)
+    const auto send = [&](TCPConnection &from, deque<pair<uint64_t, TCPSegment>> &path, const uint64_t now_ms) {
+        for (; not from.segments_out().empty(); from.segments_out().pop()) {
+            const TCPSegment &seg = from.segments_out().front();
+            result.wire.push_back(seg.serialize().concatenate() + char(seg.ecn()));
+            if (&from == &client && seg.payload().size() > 0 && ++data_segments % 97 == 0) {
+                continue;
+            }
+            path.emplace_back(now_ms + one_way_ms, seg);
+        }
+    };
+    const auto arrive = [](deque<pair<uint64_t, TCPSegment>> &path, TCPConnection &to, const uint64_t now_ms) {
+        for (; not path.empty() && path.front().first <= now_ms; path.pop_front()) {
+            to.segment_received(path.front().second);
+        }
+    };
+
+    client.connect();
+    for (uint64_t now_ms = 0; now_ms < 20'000 && (client.active() || server.active()); now_ms++) {
+        if (written < total && client.remaining_outbound_capacity() > 0) {
+            written += client.write(string(min(total - written, client.remaining_outbound_capacity()), 'x'));
+            if (written == total) {
+                client.end_input_stream();
+            }
+        }
+        if (now_ms % 50 == 0 && not server.inbound_stream().input_ended()) {
+            server.write("reply");
+        }
+        if (server.inbound_stream().eof() && not server.sender().stream_in().input_ended()) {
+            server.end_input_stream();
+        }
+        send(client, data_path, now_ms);
+        send(server, ack_path, now_ms);
+        arrive(data_path, server, now_ms);
+        arrive(ack_path, client, now_ms);
+        send(client, data_path, now_ms);
+        send(server, ack_path, now_ms);
+        result.received += server.inbound_stream().buffer_size();
+        server.inbound_stream().pop_output(server.inbound_stream().buffer_size());
+        client.inbound_stream().pop_output(client.inbound_stream().buffer_size());
+        client.tick(1);
+        server.tick(1);
+    }
+    result.client = client.header_prediction();
+    result.server = server.header_prediction();
+    return result;
+}
+
+int main() {
+    try {
+        // the fast path changes nothing on the wire, whatever else is enabled
+        vector<TCPConfig> configs(4);
+        configs[1].timestamps = true;
+        configs[1].sack = true;
+        configs[1].window_scaling = true;
+        configs[1].quickack = false;
+        configs[1].congestion_control = CongestionControlAlgorithm::NewReno;
+        configs[2].sack = true;
+        configs[2].rack_tlp = true;
+        configs[2].ecn = true;
+        configs[2].congestion_control = CongestionControlAlgorithm::Cubic;
+        configs[3].recv_autotune = true;
+        configs[3].sws_avoidance = true;
+        configs[3].persist_timer = true;
+        configs[3].adaptive_rto = true;
+        for (const TCPConfig &cfg : configs) {
+            const Transfer general = transfer(cfg, false);
+            const Transfer fast = transfer(cfg, true);
+            test_should_be(general.received, size_t(1024 * 1024));
+            test_should_be(fast.wire.size(), general.wire.size());
+            for (size_t i = 0; i < general.wire.size(); i++) {
+                test_should_be(fast.wire[i] == general.wire[i], true);
+            }
+            test_should_be(general.client.pure_acks + general.server.pure_data, uint64_t(0));
+            // (segments around a loss, and data while the reply is in flight, take the general path)
+            test_should_be(fast.client.pure_acks > 0, true);
+            test_should_be(fast.server.pure_data > 0, true);
+            test_should_be(fast.client.pure_acks + fast.client.misses,
+                           general.client.pure_acks + general.client.misses);
+        }
+
+        // which segments are predicted
+        {
+            TCPConfig cfg;
+            cfg.header_prediction = true;
+            TCPConnection client{cfg}, server{cfg};
+            handshake(client, server);
+            test_should_be(client.header_prediction().misses, uint64_t(1));    // the SYN/ACK
+            test_should_be(server.header_prediction().misses, uint64_t(1));    // the SYN
+            test_should_be(server.header_prediction().pure_acks, uint64_t(1));  // the ACK of the SYN/ACK
+
+            // in-order data for an idle sender; then the ACK for it
+            client.write("abc");
+            deliver(client, server);
+            test_should_be(server.header_prediction().pure_data, uint64_t(1));
+            test_should_be(server.inbound_stream().read(3) == "abc", true);
+            TCPSegment ack = server.segments_out().front();
+            deliver(server, client);
+            test_should_be(client.header_prediction().pure_acks, uint64_t(1));
+            test_should_be(client.bytes_in_flight(), size_t(0));
+
+            // a duplicate ACK acknowledges nothing new
+            client.segment_received(ack);
+            test_should_be(client.header_prediction().pure_acks, uint64_t(1));
+            test_should_be(client.header_prediction().misses, uint64_t(2));
+
+            // data out of order, and then the data that fills the hole
+            client.write("def");
+            TCPSegment first = client.segments_out().front();
+            client.segments_out().pop();
+            client.write("ghi");
+            deliver(client, server);
+            test_should_be(server.header_prediction().misses, uint64_t(2));
+            server.segment_received(first);
+            test_should_be(server.header_prediction().misses, uint64_t(3));
+            test_should_be(server.inbound_stream().read(6) == "defghi", true);
+            deliver(server, client);
+
+            // data for a sender with data of its own in flight
+            server.write("jkl");
+            client.write("mno");
+            deliver(client, server);
+            test_should_be(server.header_prediction().misses, uint64_t(4));
+            test_should_be(server.header_prediction().pure_data, uint64_t(1));
+            deliver(server, client);
+            deliver(client, server);
+
+            // after the peer's FIN, ACKs for our data are still predicted
+            server.end_input_stream();
+            deliver(server, client);
+            deliver(client, server);
+            const HeaderPredictionStats before = client.header_prediction();
+            client.write("pqr");
+            deliver(client, server);
+            test_should_be(server.header_prediction().pure_data, uint64_t(2));
+            deliver(server, client);
+            test_should_be(client.header_prediction().pure_acks, before.pure_acks + 1);
+            test_should_be(client.header_prediction().misses, before.misses);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,121 @@
+#include "eventloop.hh"
+#include "pacer.hh"
+#include "path_simulator.hh"
+#include "tcp_config.hh"
+#include "tcp_sender.hh"
+#include "test_should_be.hh"
+#include "util.hh"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <sys/socket.h>
+
+using namespace std;
+
+static constexpr uint64_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+int main() {
+    try {
+        // the release schedule: a burst after an idle period, then one segment per transmission time
+        {
+            Pacer pacer{1'000'000, 2 * MSS};  // 1 MB/s: one segment per millisecond
+            test_should_be(pacer.may_send(10'000), true);
+            pacer.on_send(10'000, MSS);
+            test_should_be(pacer.may_send(10'000), true);
+            pacer.on_send(10'000, MSS);
+            test_should_be(pacer.may_send(10'000), false);
+            test_should_be(pacer.wait_us(10'000), uint64_t(1000));
+            test_should_be(pacer.may_send(11'000), true);
+            pacer.on_send(11'000, MSS);
+            test_should_be(pacer.wait_us(11'500), uint64_t(500));
+
+            // falling behind by more than the burst allowance only earns the allowance...
+            pacer.on_send(20'000, MSS);
+            pacer.on_send(20'000, MSS);
+            test_should_be(pacer.may_send(20'000), false);
+            // ...unless the caller allows catching up (coarse ticks)
+            pacer.on_send(30'000, MSS, 5000);
+            test_should_be(pacer.wait_us(30'000), uint64_t(0));
+
+            Pacer unpaced{0, 2 * MSS};
+            unpaced.on_send(0, 100 * MSS);
+            test_should_be(unpaced.may_send(0), true);
+        }
+
+        // a configured pacing rate holds back what fill_window() would otherwise send at once
+        {
+            TCPConfig cfg;
+            cfg.fixed_isn = WrappingInt32{0};
+            cfg.pacing_rate = 1'000'000;
+            cfg.pacing_burst = 2 * MSS;
+            TCPSender sender{cfg};
+            sender.fill_window();  // the SYN is never held back
+            test_should_be(sender.segments_out().size(), size_t(1));
+            sender.segments_out().pop();
+            sender.ack_received(WrappingInt32{1}, 60000);
+            test_should_be(sender.time_until_release_us().has_value(), false);
+
+            sender.tick_us(10'000);
+            sender.stream_in().write(string(10 * MSS, 'x'));
+            sender.fill_window();
+            test_should_be(sender.segments_out().size(), size_t(2));  // the burst allowance
+            test_should_be(sender.time_until_release_us(), optional<uint64_t>{1000});
+
+            sender.tick_us(1000);
+            test_should_be(sender.segments_out().size(), size_t(3));
+            sender.tick_us(5000);  // a coarse tick releases everything that is due
+            test_should_be(sender.segments_out().size(), size_t(8));
+            sender.tick_us(5000);
+            test_should_be(sender.segments_out().size(), size_t(10));
+            test_should_be(sender.time_until_release_us().has_value(), false);
+        }
+
+        // the event loop can sleep for less than a millisecond
+        {
+            EventLoop loop;
+            int fds[2];
+            SystemCall("socketpair", ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+            FileDescriptor readable{fds[0]}, writer{fds[1]};
+            loop.add_rule(readable, Direction::In, [&] { readable.read(); });
+            const auto start = chrono::steady_clock::now();
+            test_should_be(loop.wait_next_event(chrono::microseconds{300}) == EventLoop::Result::Timeout, true);
+            test_should_be(chrono::steady_clock::now() - start >= chrono::microseconds{300}, true);
+        }
+
+        // on a shallow queue, an unpaced window overflows the buffer; a paced one doesn't
+        {
+            PathConfig path;
+            path.rate_bps = 10'000'000;
+            path.rtt_us = 20'000;
+            path.queue_bytes = 8000;
+            path.step_us = 100;
+            TCPConfig receiver_cfg;
+            receiver_cfg.recv_capacity = 25'000;
+
+            uint64_t dropped[2], delivered[2];
+            for (size_t paced = 0; paced < 2; paced++) {
+                TCPConfig sender_cfg;
+                sender_cfg.send_capacity = 1'000'000;
+                sender_cfg.congestion_control = CongestionControlAlgorithm::Reno;
+                sender_cfg.pacing_rate = paced ? 1'200'000 : 0;
+                PathSimulator sim{sender_cfg, receiver_cfg, path};
+                sim.run_for(5'000'000);
+                dropped[paced] = sim.stats().segments_dropped;
+                delivered[paced] = sim.stats().bytes_delivered;
+            }
+            test_should_be(dropped[0] > 0, true);
+            test_should_be(dropped[1], uint64_t(0));
+            test_should_be(delivered[1] > delivered[0], true);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,218 @@
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_segment.hh"
+#include "tcp_sender.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+//! Segments a sender sends into a window that stays zero for `duration_us`
+static size_t probes_in(const bool persist_timer, const uint64_t duration_us) {
+    TCPConfig cfg;
+    cfg.fixed_isn = WrappingInt32{0};
+    cfg.persist_timer = persist_timer;
+    TCPSender sender{cfg};
+    sender.fill_window();
+    sender.segments_out().pop();
+    sender.ack_received(WrappingInt32{1}, 0);
+    sender.stream_in().write("data");
+    sender.fill_window();
+    size_t probes = 0;
+    for (uint64_t t = 0; t < duration_us; t += 10'000) {
+        sender.tick_us(10'000);
+        for (; not sender.segments_out().empty(); probes++) {
+            sender.segments_out().pop();
+        }
+    }
+    return probes;
+}
+
+int main() {
+    try {
+        // probes of a zero window back off exponentially; only the unanswered ones count as retransmissions
+        {
+            TCPConfig cfg;
+            cfg.fixed_isn = WrappingInt32{0};
+            cfg.persist_timer = true;
+            TCPSender sender{cfg};
+            sender.fill_window();
+            sender.segments_out().pop();
+            sender.ack_received(WrappingInt32{1}, 0);
+            test_should_be(sender.persisting(), false);  // nothing to send yet
+            sender.stream_in().write(string(5 * MSS, 'x'));
+            sender.fill_window();
+            test_should_be(sender.segments_out().size(), size_t(0));
+            test_should_be(sender.persisting(), true);
+
+            const uint64_t rto_us = sender.rto_us();
+            test_should_be(sender.persist_timeout_us(), rto_us);
+            sender.tick_us(rto_us - 1);
+            test_should_be(sender.segments_out().size(), size_t(0));
+            sender.tick_us(1);
+            test_should_be(sender.segments_out().size(), size_t(1));
+            test_should_be(sender.segments_out().front().payload().size(), size_t(1));
+            sender.segments_out().pop();
+            test_should_be(sender.persist_timeout_us(), 2 * rto_us);
+
+            // the probe is resent when its time comes, not on the RTO
+            sender.tick_us(2 * rto_us - 1);
+            test_should_be(sender.segments_out().size(), size_t(0));
+            sender.tick_us(1);
+            test_should_be(sender.segments_out().size(), size_t(1));
+            sender.segments_out().pop();
+            test_should_be(sender.persist_timeout_us(), 4 * rto_us);
+            test_should_be(sender.consecutive_retransmissions(), 1u);
+
+            // the receiver takes the byte but its window stays zero: the backoff goes on
+            sender.ack_received(WrappingInt32{2}, 0);
+            test_should_be(sender.consecutive_retransmissions(), 0u);
+            sender.fill_window();
+            test_should_be(sender.segments_out().size(), size_t(0));
+            sender.tick_us(4 * rto_us);
+            test_should_be(sender.segments_out().size(), size_t(1));
+            sender.segments_out().pop();
+            test_should_be(sender.persist_timeout_us(), 8 * rto_us);
+
+            // an open window ends the probing; the retransmission timer takes over again
+            sender.ack_received(WrappingInt32{3}, 10 * MSS);
+            test_should_be(sender.persisting(), false);
+            sender.fill_window();
+            test_should_be(sender.segments_out().size(), size_t(5));
+            while (not sender.segments_out().empty()) {
+                sender.segments_out().pop();
+            }
+            sender.tick_us(rto_us);
+            test_should_be(sender.segments_out().size(), size_t(1));
+            test_should_be(sender.consecutive_retransmissions(), 1u);
+        }
+
+        // a window that closes with data in flight: the persist timer resends the oldest segment
+        {
+            TCPConfig cfg;
+            cfg.fixed_isn = WrappingInt32{0};
+            cfg.persist_timer = true;
+            TCPSender sender{cfg};
+            sender.fill_window();
+            sender.segments_out().pop();
+            sender.ack_received(WrappingInt32{1}, 3 * MSS);
+            sender.stream_in().write(string(3 * MSS, 'x'));
+            sender.fill_window();
+            while (not sender.segments_out().empty()) {
+                sender.segments_out().pop();
+            }
+            sender.ack_received(WrappingInt32{1 + MSS}, 0);
+            test_should_be(sender.persisting(), true);
+            for (uint64_t interval = sender.rto_us(); interval <= 8 * sender.rto_us(); interval *= 2) {
+                sender.tick_us(interval);
+                test_should_be(sender.segments_out().size(), size_t(1));
+                test_should_be(sender.segments_out().front().header().seqno, WrappingInt32{1 + MSS});
+                sender.segments_out().pop();
+                sender.ack_received(WrappingInt32{1 + MSS}, 0);  // still zero, but the receiver is there
+            }
+            test_should_be(sender.consecutive_retransmissions(), 0u);
+        }
+
+        // with SWS avoidance too, a window update that is lost is recovered by the persist timer
+        {
+            TCPConfig cfg;
+            cfg.fixed_isn = WrappingInt32{0};
+            cfg.persist_timer = true;
+            cfg.sws_avoidance = true;
+            TCPSender sender{cfg};
+            sender.fill_window();
+            sender.segments_out().pop();
+            sender.ack_received(WrappingInt32{1}, 0);
+            sender.stream_in().write(string(5 * MSS, 'x'));
+            sender.fill_window();
+            test_should_be(sender.persisting(), true);
+            sender.tick_us(sender.persist_timeout_us());
+            test_should_be(sender.segments_out().size(), size_t(1));
+            test_should_be(sender.segments_out().front().payload().size(), size_t(1));
+            sender.segments_out().pop();
+            // the answer to the probe carries the window the lost update would have
+            sender.ack_received(WrappingInt32{2}, 10 * MSS);
+            sender.fill_window();
+            test_should_be(sender.segments_out().size(), size_t(5));
+        }
+
+        // a peer that stops answering the probes altogether is given up on
+        {
+            TCPConfig cfg;
+            cfg.persist_timer = true;
+            cfg.recv_capacity = 4 * MSS;
+            TCPConnection client{cfg}, server{cfg};
+            client.connect();
+            for (uint64_t ms = 0; ms < 100; ms++) {
+                client.write(string(client.remaining_outbound_capacity(), 'x'));
+                for (; not client.segments_out().empty(); client.segments_out().pop()) {
+                    server.segment_received(client.segments_out().front());
+                }
+                for (; not server.segments_out().empty(); server.segments_out().pop()) {
+                    client.segment_received(server.segments_out().front());
+                }
+                client.tick(1);
+                server.tick(1);
+            }
+            test_should_be(client.sender().persisting(), true);
+            // the server goes away: nothing it would send reaches the client any more
+            for (uint64_t ms = 0; ms < 600'000 && client.active(); ms += 100) {
+                client.tick(100);
+                while (not client.segments_out().empty()) {
+                    client.segments_out().pop();
+                }
+            }
+            test_should_be(client.active(), false);
+            test_should_be(client.sender().stream_in().error(), true);
+        }
+
+        // a minute of zero window: a probe every RTO without the timer, a handful with it
+        {
+            test_should_be(probes_in(false, 60'000'000) >= 59, true);
+            test_should_be(probes_in(true, 60'000'000) <= 6, true);
+        }
+
+        // a stalled reader is not waited out: its window update unblocks the sender (with SWS avoidance)
+        {
+            TCPConfig cfg;
+            cfg.persist_timer = true;
+            cfg.sws_avoidance = true;
+            TCPConnection client{cfg}, server{cfg};
+            client.connect();
+            size_t read = 0;
+            for (uint64_t ms = 0; ms < 30'000; ms++) {
+                client.write(string(client.remaining_outbound_capacity(), 'x'));
+                while (not client.segments_out().empty()) {
+                    server.segment_received(client.segments_out().front());
+                    client.segments_out().pop();
+                }
+                while (not server.segments_out().empty()) {
+                    client.segment_received(server.segments_out().front());
+                    server.segments_out().pop();
+                }
+                if (ms == 20'000) {
+                    test_should_be(client.sender().persisting(), true);
+                    read = server.inbound_stream().buffer_size();
+                    server.inbound_stream().pop_output(read);
+                }
+                if (ms == 20'002) {
+                    test_should_be(server.inbound_stream().buffer_size() > read / 2, true);
+                }
+                client.tick(1);
+                server.tick(1);
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,123 @@
+#include "path_simulator.hh"
+#include "pmtu_search.hh"
+#include "tcp_config.hh"
+#include "tcp_sender.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <string>
+
+using namespace std;
+
+static constexpr uint64_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+int main() {
+    try {
+        // the search: an acked probe raises the segment size, three lost ones lower the bound
+        {
+            PmtuSearch search{1000, 9000};
+            test_should_be(search.mss(), size_t(1000));
+            test_should_be(search.probe_size(), optional<size_t>{5000});
+            search.on_probe_acked(5000);
+            test_should_be(search.mss(), size_t(5000));
+            test_should_be(search.probe_size(), optional<size_t>{7000});
+            search.on_probe_lost(7000);
+            search.on_probe_lost(7000);
+            test_should_be(search.probe_size(), optional<size_t>{7000});  // may have been congestion
+            search.on_probe_lost(7000);
+            test_should_be(search.probe_size(), optional<size_t>{6000});
+            search.on_probe_acked(9000);  // outside the range: an old probe
+            test_should_be(search.mss(), size_t(5000));
+
+            // the bisection ends within SEARCH_GRANULARITY of the largest size that gets through
+            while (search.probe_size()) {
+                const size_t size = *search.probe_size();
+                if (size <= 5500)
+                    search.on_probe_acked(size);
+                else
+                    search.on_probe_lost(size);
+            }
+            test_should_be(search.mss() <= 5500, true);
+            test_should_be(search.mss() + PmtuSearch::SEARCH_GRANULARITY > 5500, true);
+
+            // a smaller maximum (the peer's MSS) caps the size in use
+            search.set_max(4000);
+            test_should_be(search.mss(), size_t(4000));
+            test_should_be(search.probe_size().has_value(), false);
+        }
+
+        // the sender starts at MAX_PAYLOAD_SIZE and sends one larger probe once the window allows
+        {
+            TCPConfig cfg;
+            cfg.fixed_isn = WrappingInt32{0};
+            cfg.mss = 8000;
+            cfg.plpmtud = true;
+            TCPSender sender{cfg};
+            test_should_be(sender.mss(), MSS);
+            sender.fill_window();
+            sender.segments_out().pop();
+            sender.ack_received(WrappingInt32{1}, 60000);
+            sender.stream_in().write(string(20 * MSS, 'x'));
+            sender.fill_window();
+            test_should_be(sender.segments_out().front().payload().size(), size_t(4500));
+            sender.segments_out().pop();
+            test_should_be(sender.segments_out().front().payload().size(), MSS);
+            test_should_be(sender.pmtu_search()->probe_size(), optional<size_t>{4500});
+        }
+
+        // on a path that drops datagrams above 1500 bytes, a sender that believes the peer's jumbo
+        // MSS delivers nothing; a searching one finds the largest size that gets through
+        {
+            PathConfig path;
+            path.rate_bps = 20'000'000;
+            path.rtt_us = 20'000;
+            path.queue_bytes = 100'000;
+            path.step_us = 100;
+            path.mtu = 1500;
+
+            for (const bool plpmtud : {false, true}) {
+                TCPConfig cfg;
+                cfg.send_capacity = 1'000'000;
+                cfg.recv_capacity = 1'000'000;
+                cfg.congestion_control = CongestionControlAlgorithm::NewReno;
+                cfg.sack = true;
+                cfg.window_scaling = true;
+                cfg.mss = 8960;
+                cfg.plpmtud = plpmtud;
+                PathSimulator sim{cfg, cfg, path};
+                sim.run_for(3'000'000);
+                if (!plpmtud) {
+                    test_should_be(sim.stats().bytes_delivered, uint64_t(0));
+                    continue;
+                }
+                const size_t mss = sim.sender().sender().mss();
+                test_should_be(mss > 1500 - 40 - 2 * PmtuSearch::SEARCH_GRANULARITY, true);
+                test_should_be(mss <= 1460, true);
+                test_should_be(sim.stats().bytes_delivered > 5'000'000, true);
+            }
+
+            // where jumbo frames get through, the search ends near the peer's MSS
+            path.mtu = 9000;
+            TCPConfig cfg;
+            cfg.send_capacity = 1'000'000;
+            cfg.recv_capacity = 1'000'000;
+            cfg.congestion_control = CongestionControlAlgorithm::NewReno;
+            cfg.sack = true;
+            cfg.window_scaling = true;
+            cfg.mss = 8960;
+            cfg.plpmtud = true;
+            PathSimulator sim{cfg, cfg, path};
+            sim.run_for(3'000'000);
+            test_should_be(sim.sender().sender().mss() + PmtuSearch::SEARCH_GRANULARITY > 8960, true);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,137 @@
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_segment.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <string>
+#include <utility>
+
+using namespace std;
+
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+static constexpr uint64_t ONE_WAY_US = 10'000;
+
+//! One direction of a path with a fixed delay, that drops the data segments `drop` picks, by
+//! their number in the stream (from 0) and how many times they were sent before
+class DelayLine {
+    using DropFunction = function<bool(size_t segment, size_t transmission)>;
+    deque<pair<uint64_t, TCPSegment>> _in_flight{};
+    DropFunction _drop;
+    optional<WrappingInt32> _isn{};
+    map<size_t, size_t> _transmissions{};
+
+  public:
+    explicit DelayLine(DropFunction drop = [](size_t, size_t) { return false; }) : _drop(move(drop)) {}
+
+    //! Take what `from` has sent, and hand `to` what has arrived by `now_us`
+    void run(TCPConnection &from, TCPConnection &to, const uint64_t now_us) {
+        for (; not from.segments_out().empty(); from.segments_out().pop()) {
+            const TCPSegment &seg = from.segments_out().front();
+            if (seg.header().syn)
+                _isn = seg.header().seqno;
+            if (seg.payload().size() > 0) {
+                const size_t segment = size_t(seg.header().seqno - *_isn - 1) / MSS;
+                if (_drop(segment, _transmissions[segment]++))
+                    continue;
+            }
+            _in_flight.emplace_back(now_us + ONE_WAY_US, seg);
+        }
+        for (; not _in_flight.empty() && _in_flight.front().first <= now_us; _in_flight.pop_front())
+            to.segment_received(_in_flight.front().second);
+    }
+};
+
+//! Microseconds until a burst of `segments` segments is all delivered, when the data segments
+//! `drop` picks are lost (and whether the server agrees to SACK)
+static uint64_t delivery_time_us(const bool rack_tlp,
+                                 const size_t segments,
+                                 function<bool(size_t, size_t)> drop,
+                                 const bool server_sack = true) {
+    TCPConfig cfg;
+    cfg.congestion_control = CongestionControlAlgorithm::NewReno;
+    cfg.sack = true;
+    cfg.adaptive_rto = true;
+    cfg.rack_tlp = rack_tlp;
+    TCPConfig server_cfg = cfg;
+    server_cfg.sack = server_sack;
+    TCPConnection client{cfg}, server{server_cfg};
+    DelayLine up{move(drop)}, down{};
+    uint64_t now_us = 0;
+    client.connect();
+    for (; now_us < 100'000; now_us += 1000) {  // handshake, and a first RTT sample
+        up.run(client, server, now_us);
+        down.run(server, client, now_us);
+        client.tick_us(1000);
+        server.tick_us(1000);
+    }
+    const uint64_t start_us = now_us;
+    client.write(string(segments * MSS, 'x'));
+    for (; server.inbound_stream().buffer_size() < segments * MSS; now_us += 1000) {
+        if (now_us - start_us > 10'000'000)
+            throw runtime_error("the burst was never delivered");
+        up.run(client, server, now_us);
+        down.run(server, client, now_us);
+        client.tick_us(1000);
+        server.tick_us(1000);
+    }
+    return now_us - start_us;
+}
+
+int main() {
+    try {
+        const uint64_t rtt_us = 2 * ONE_WAY_US;
+
+        // the last three segments of a burst are lost: the RTO recovers them after at least
+        // 200 ms (its lower bound); a tail loss probe and RACK in a few RTTs
+        {
+            const auto tail = [](size_t i, size_t sent) { return i >= 7 && sent == 0; };
+            test_should_be(delivery_time_us(false, 10, tail) > 200'000, true);
+            test_should_be(delivery_time_us(true, 10, tail) < 6 * rtt_us, true);
+        }
+
+        // a lone lost segment at the tail: the probe, the segment itself, waits longer for a delayed ACK
+        {
+            const auto last = [](size_t i, size_t sent) { return i == 4 && sent == 0; };
+            test_should_be(delivery_time_us(true, 5, last) < 4 * rtt_us + TCPConfig{}.delayed_ack_us, true);
+        }
+
+        // a hole in the middle is repaired about an RTT after the segments beyond it arrive
+        {
+            const auto middle = [](size_t i, size_t sent) { return i == 3 && sent == 0; };
+            test_should_be(delivery_time_us(true, 10, middle) < 3 * rtt_us, true);
+        }
+
+        // without SACK from the peer, the duplicate ACKs still trigger a fast retransmit
+        {
+            const auto middle = [](size_t i, size_t sent) { return i == 3 && sent == 0; };
+            test_should_be(delivery_time_us(false, 10, middle, false) < 200'000, true);
+            test_should_be(delivery_time_us(true, 10, middle, false) < 200'000, true);
+        }
+
+        // the retransmission is lost too: RACK tells that by time as well, once later segments arrive
+        {
+            const auto twice = [](size_t i, size_t sent) { return i == 3 && sent < 2; };
+            test_should_be(delivery_time_us(false, 30, twice) > 200'000, true);
+            test_should_be(delivery_time_us(true, 30, twice) < 6 * rtt_us, true);
+        }
+
+        // without losses, the probes are harmless
+        {
+            const auto none = [](size_t, size_t) { return false; };
+            test_should_be(delivery_time_us(true, 10, none) <= rtt_us, true);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
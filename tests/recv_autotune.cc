@@ -0,0 +1,106 @@
+#include "path_simulator.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_receiver.hh"
+#include "tcp_segment.hh"
+#include "test_should_be.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+//! A receiver fed up to `per_rtt` bytes per round trip of `rtt_us` (no more than a window), in
+//! segments of 1000 bytes, for `rounds` round trips; the application reads everything if `read` is set
+static size_t capacity_after(const size_t rounds, const size_t per_rtt, const bool read) {
+    const uint64_t rtt_us = 10'000;
+    TCPReceiver receiver{10'000, 1'000'000};
+    TCPSegment syn;
+    syn.header().syn = true;
+    syn.header().seqno = WrappingInt32{0};
+    receiver.segment_received(syn);
+    uint64_t now_us = 0;
+    uint64_t next = 1;
+    for (size_t round = 0; round < rounds; round++) {
+        const size_t budget = min(per_rtt, receiver.window_size());
+        for (size_t sent = 0; sent + 1000 <= budget; sent += 1000) {
+            TCPSegment seg;
+            seg.header().seqno = WrappingInt32{uint32_t(next)};
+            seg.payload() = string(1000, 'x');
+            next += 1000;
+            receiver.segment_received(seg);
+            receiver.tune_window(now_us);
+            now_us += rtt_us * 1000 / budget;
+            if (read) {
+                receiver.stream_out().pop_output(receiver.stream_out().buffer_size());
+            }
+        }
+        now_us = (round + 1) * rtt_us;
+    }
+    return receiver.capacity();
+}
+
+int main() {
+    try {
+        // the capacity grows while the application keeps up, but not beyond the ceiling
+        {
+            // at a steady rate, the capacity settles
+            test_should_be(capacity_after(50, 2'000, true), capacity_after(100, 2'000, true));
+            test_should_be(capacity_after(50, 2'000, true) < 100'000, true);
+            test_should_be(capacity_after(10, 10'000, true) > 20'000, true);
+            test_should_be(capacity_after(100, 500'000, true), size_t(1'000'000));
+            // an application that doesn't read gets no more buffer
+            test_should_be(capacity_after(10, 10'000, false), size_t(10'000));
+            // without a ceiling above the initial capacity, nothing is tuned
+            TCPReceiver fixed{10'000};
+            test_should_be(fixed.capacity(), size_t(10'000));
+        }
+
+        // the connection offers a window scale fit for the ceiling, and starts small
+        {
+            TCPConfig cfg;
+            cfg.window_scaling = true;
+            cfg.recv_autotune = true;
+            test_should_be(cfg.window_scale(), uint8_t(7));
+            TCPConnection conn{cfg};
+            test_should_be(conn.receiver().capacity(), TCPConfig::DEFAULT_CAPACITY);
+        }
+
+        // on a long fat path, the auto-tuned window grows to fill the pipe (the fixed one can't)
+        {
+            PathConfig path;
+            path.rate_bps = 20'000'000;
+            path.rtt_us = 100'000;
+            path.queue_bytes = 250'000;
+            path.step_us = 500;
+
+            uint64_t delivered[2];
+            for (size_t autotune = 0; autotune < 2; autotune++) {
+                TCPConfig cfg;
+                cfg.send_capacity = 2'000'000;
+                cfg.congestion_control = CongestionControlAlgorithm::NewReno;
+                cfg.sack = true;
+                cfg.window_scaling = true;
+                cfg.recv_autotune = autotune;
+                PathSimulator sim{cfg, cfg, path};
+                sim.run_for(5'000'000);
+                delivered[autotune] = sim.stats().bytes_delivered;
+                if (autotune) {
+                    const size_t capacity = sim.receiver().receiver().capacity();
+                    test_should_be(capacity >= 250'000, true);
+                    test_should_be(capacity <= cfg.recv_capacity_max, true);
+                }
+            }
+            test_should_be(delivered[1] > 2 * delivered[0], true);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
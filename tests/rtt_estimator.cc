@@ -0,0 +1,120 @@
+#include "path_simulator.hh"
+#include "tcp_config.hh"
+#include "tcp_sender.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static constexpr uint64_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+int main() {
+    try {
+        // RFC 6298: the first sample sets SRTT = R and RTTVAR = R/2, later ones are smoothed
+        {
+            RttEstimator rtt{1'000'000, 200'000, 60'000'000};
+            test_should_be(rtt.has_sample(), false);
+            test_should_be(rtt.rto_us(), uint64_t(1'000'000));
+            rtt.sample(100'000);
+            test_should_be(rtt.srtt_us(), uint64_t(100'000));
+            test_should_be(rtt.rttvar_us(), uint64_t(50'000));
+            test_should_be(rtt.rto_us(), uint64_t(300'000));
+            rtt.sample(200'000);
+            test_should_be(rtt.srtt_us(), uint64_t(112'500));
+            test_should_be(rtt.rttvar_us(), uint64_t(62'500));
+            test_should_be(rtt.rto_us(), uint64_t(362'500));
+        }
+
+        // the computed RTO is clamped to [min, max]
+        {
+            RttEstimator rtt{1'000'000, 200'000, 60'000'000};
+            rtt.sample(1000);
+            test_should_be(rtt.rto_us(), uint64_t(200'000));
+            RttEstimator slow{1'000'000, 200'000, 60'000'000};
+            slow.sample(100'000'000);
+            test_should_be(slow.rto_us(), uint64_t(60'000'000));
+        }
+
+        // the sender's timer follows the estimate, backs off on a timeout and (Karn) keeps the
+        // backed-off value until data that was sent only once is acked
+        {
+            TCPConfig cfg;
+            cfg.fixed_isn = WrappingInt32{0};
+            cfg.adaptive_rto = true;
+            cfg.rto_max_us = 1'000'000;
+            TCPSender sender{cfg};
+            test_should_be(sender.rtt_estimator() != nullptr, true);
+            sender.fill_window();
+            sender.tick_us(100'000);
+            sender.ack_received(WrappingInt32{1}, 60000);
+            test_should_be(sender.rto_us(), uint64_t(300'000));
+
+            sender.stream_in().write(string(2 * MSS, 'x'));
+            sender.fill_window();
+            sender.tick_us(200'000);
+            sender.ack_received(WrappingInt32{1 + MSS}, 60000);
+            test_should_be(sender.rto_us(), uint64_t(362'500));
+
+            while (!sender.segments_out().empty())
+                sender.segments_out().pop();
+            sender.tick_us(362'500);
+            test_should_be(sender.segments_out().size(), size_t(1));
+            test_should_be(sender.rto_us(), uint64_t(725'000));
+            sender.tick_us(725'000);
+            test_should_be(sender.rto_us(), uint64_t(1'000'000));  // clamped to rto_max_us
+            sender.ack_received(WrappingInt32{1 + 2 * MSS}, 60000);
+            test_should_be(sender.rto_us(), uint64_t(1'000'000));  // only retransmitted data was acked
+
+            sender.stream_in().write(string(MSS, 'x'));
+            sender.fill_window();
+            sender.tick_us(50'000);
+            sender.ack_received(WrappingInt32{1 + 3 * MSS}, 60000);
+            test_should_be(sender.rto_us(), sender.rtt_estimator()->rto_us());
+            test_should_be(sender.rto_us() < uint64_t(400'000), true);
+        }
+
+        // without adaptive_rto, the timer keeps the configured value
+        {
+            TCPConfig cfg;
+            cfg.fixed_isn = WrappingInt32{0};
+            TCPSender sender{cfg};
+            test_should_be(sender.rtt_estimator() == nullptr, true);
+            sender.fill_window();
+            sender.tick_us(100'000);
+            sender.ack_received(WrappingInt32{1}, 60000);
+            test_should_be(sender.rto_us(), cfg.initial_rto_us());
+        }
+
+        // on a path whose RTT exceeds the initial RTO, a fixed RTO retransmits every window
+        // spuriously; an adaptive one learns the RTT and lets the window grow
+        {
+            PathConfig path;
+            path.rate_bps = 2'000'000;
+            path.rtt_us = 1'500'000;
+            path.queue_bytes = 64'000;
+            path.step_us = 1000;
+
+            uint64_t delivered[2];
+            for (size_t adaptive = 0; adaptive < 2; adaptive++) {
+                TCPConfig sender_cfg;
+                sender_cfg.send_capacity = 1'000'000;
+                sender_cfg.congestion_control = CongestionControlAlgorithm::Reno;
+                sender_cfg.adaptive_rto = adaptive;
+                PathSimulator sim{sender_cfg, TCPConfig{}, path};
+                sim.run_for(20'000'000);
+                delivered[adaptive] = sim.stats().bytes_delivered;
+            }
+            test_should_be(delivered[1] > 2 * delivered[0], true);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
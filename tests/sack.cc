@@ -0,0 +1,186 @@
+#include "parser.hh"
+#include "stream_reassembler.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_header.hh"
+#include "tcp_receiver.hh"
+#include "tcp_segment.hh"
+#include "tcp_sender.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+static constexpr uint32_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+using Blocks = vector<pair<uint64_t, uint64_t>>;
+
+//! Sequence numbers [left, right) as a SACK block
+static TCPOptions::SackBlock block(const uint32_t left, const uint32_t right) {
+    return TCPOptions::SackBlock{WrappingInt32{left}, WrappingInt32{right}};
+}
+
+//! Seqnos of the segments a sender queued, which are then discarded
+static vector<uint32_t> sent_seqnos(TCPSender &sender) {
+    vector<uint32_t> seqnos;
+    while (not sender.segments_out().empty()) {
+        seqnos.push_back(sender.segments_out().front().header().seqno.raw_value());
+        sender.segments_out().pop();
+    }
+    return seqnos;
+}
+
+int main() {
+    try {
+        // the options survive a round trip through the wire format; unknown options are skipped
+        {
+            TCPSegment seg;
+            seg.header().ack = true;
+            seg.header().options.sack = {block(3001, 5001), block(7001, 8001), block(10001, 12001)};
+            seg.payload() = string("hello");
+            test_should_be(seg.header().length(), size_t(20 + 4 + 3 * 8));
+
+            TCPSegment parsed;
+            test_should_be(parsed.parse(seg.serialize().concatenate()) == ParseResult::NoError, true);
+            test_should_be(parsed.header().doff, uint8_t(12));
+            test_should_be(parsed.header().options == seg.header().options, true);
+            test_should_be(parsed.payload().copy() == "hello", true);
+
+            TCPHeader syn;
+            syn.syn = true;
+            syn.options.sack_permitted = true;
+            string wire = syn.serialize();
+            wire.insert(20, "\x02\x04\x05\xb4");  // MSS option: not ours to interpret
+            wire[12] = char((wire.size() / 4) << 4);
+            TCPHeader parsed_syn;
+            NetParser p{Buffer{string(wire)}};
+            test_should_be(parsed_syn.parse(p) == ParseResult::NoError, true);
+            test_should_be(parsed_syn.options.sack_permitted, true);
+
+            wire[21] = 40;  // an option running past the header
+            NetParser bad{Buffer{string(wire)}};
+            test_should_be(parsed_syn.parse(bad) == ParseResult::HeaderTooShort, true);
+        }
+
+        // the reassembler reports what it holds beyond the next byte it needs
+        {
+            StreamReassembler reassembler{100};
+            reassembler.push_substring("abc", 5, false);
+            reassembler.push_substring("xy", 10, false);
+            test_should_be((reassembler.unassembled_blocks() == Blocks{{5, 8}, {10, 12}}), true);
+            reassembler.push_substring("zz", 8, false);
+            test_should_be((reassembler.unassembled_blocks() == Blocks{{5, 12}}), true);
+            reassembler.push_substring("01234", 0, false);
+            test_should_be((reassembler.unassembled_blocks() == Blocks{}), true);
+        }
+
+        // the receiver's blocks are sequence numbers, most recently changed first
+        {
+            TCPReceiver receiver{10000};
+            TCPSegment syn;
+            syn.header().syn = true;
+            syn.header().seqno = WrappingInt32{1000};
+            receiver.segment_received(syn);
+            for (const uint64_t index : {1000, 3000, 2000}) {
+                TCPSegment seg;
+                seg.header().seqno = WrappingInt32{uint32_t(1001 + index)};
+                seg.payload() = string(500, 'x');
+                receiver.segment_received(seg);
+            }
+            const vector<TCPOptions::SackBlock> expected{block(3001, 3501), block(2001, 2501), block(4001, 4501)};
+            test_should_be(receiver.sack_blocks() == expected, true);
+        }
+
+        // the sender retransmits only the holes: segments 0 and 3 of 8 are lost
+        {
+            TCPConfig cfg;
+            cfg.fixed_isn = WrappingInt32{0};
+            cfg.congestion_control = CongestionControlAlgorithm::NewReno;
+            cfg.sack = true;
+            TCPSender sender{cfg};
+            sender.fill_window();
+            sent_seqnos(sender);
+            sender.ack_received(WrappingInt32{1}, 60000);
+            sender.stream_in().write(string(8 * MSS, 'x'));
+            sender.fill_window();
+            test_should_be(sent_seqnos(sender).size(), size_t(8));
+
+            const auto seq = [](const uint32_t segment) { return 1 + segment * MSS; };
+            sender.sack_received({block(seq(1), seq(3))});
+            sender.ack_received(WrappingInt32{1}, 60000);
+            test_should_be((sent_seqnos(sender) == vector<uint32_t>{}), true);
+            // more than two segments above the first hole are SACKed: it is lost (before three dupacks)
+            sender.sack_received({block(seq(4), seq(5)), block(seq(1), seq(3))});
+            sender.ack_received(WrappingInt32{1}, 60000);
+            test_should_be((sent_seqnos(sender) == vector<uint32_t>{seq(0)}), true);
+            test_should_be(sender.congestion_control()->in_recovery(), true);
+
+            // the next duplicate repairs the second hole, without waiting for a partial ack
+            sender.sack_received({block(seq(4), seq(6)), block(seq(1), seq(3))});
+            sender.ack_received(WrappingInt32{seq(0)}, 60000);
+            test_should_be((sent_seqnos(sender) == vector<uint32_t>{seq(3)}), true);
+
+            // no holes left: the next duplicates and the partial ack send nothing the receiver holds
+            sender.sack_received({block(seq(4), seq(8)), block(seq(1), seq(3))});
+            sender.ack_received(WrappingInt32{seq(0)}, 60000);
+            sender.sack_received({block(seq(4), seq(8))});
+            sender.ack_received(WrappingInt32{seq(3)}, 60000);
+            test_should_be((sent_seqnos(sender) == vector<uint32_t>{}), true);
+            sender.ack_received(WrappingInt32{seq(8)}, 60000);
+            test_should_be(sender.congestion_control()->in_recovery(), false);
+            test_should_be(sender.bytes_in_flight(), size_t(0));
+        }
+
+        // two connections negotiate SACK on their SYNs; then acks carry blocks
+        {
+            TCPConfig cfg;
+            cfg.sack = true;
+            TCPConnection client{cfg}, server{cfg};
+            const auto deliver = [](TCPConnection &from, TCPConnection &to) {
+                while (not from.segments_out().empty()) {
+                    to.segment_received(from.segments_out().front());
+                    from.segments_out().pop();
+                }
+            };
+            client.connect();
+            test_should_be(client.segments_out().front().header().options.sack_permitted, true);
+            deliver(client, server);
+            test_should_be(server.segments_out().front().header().options.sack_permitted, true);
+            deliver(server, client);
+            deliver(client, server);
+
+            client.write(string(3 * MSS, 'x'));
+            vector<TCPSegment> data;
+            while (not client.segments_out().empty()) {
+                data.push_back(client.segments_out().front());
+                client.segments_out().pop();
+            }
+            test_should_be(data.size(), size_t(3));
+            server.segment_received(data.at(2));  // the first two are late
+            const TCPHeader &ack = server.segments_out().back().header();
+            test_should_be(ack.options.sack.size(), size_t(1));
+            test_should_be(ack.options.sack.at(0).left, data.at(2).header().seqno);
+            test_should_be(ack.options.sack.at(0).right, data.at(2).header().seqno + MSS);
+
+            // without the offer, neither side sends SACK options
+            TCPConfig plain;
+            TCPConnection old_client{plain}, new_server{cfg};
+            old_client.connect();
+            test_should_be(old_client.segments_out().front().header().options.sack_permitted, false);
+            deliver(old_client, new_server);
+            test_should_be(new_server.segments_out().front().header().options.sack_permitted, false);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
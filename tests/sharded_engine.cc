@@ -0,0 +1,182 @@
+#include "address.hh"
+#include "spsc_queue.hh"
+#include "tcp_sharded_engine.hh"
+#include "test_should_be.hh"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+static constexpr uint16_t SERVER_PORT = 80;
+static constexpr uint16_t CLIENT_PORT_BASE = 20000;
+
+int main() {
+    try {
+        // RSS verification suite (Microsoft), IPv4 with TCP ports
+        {
+            const auto ip = [](const string &dotted_quad) { return Address(dotted_quad).ipv4_numeric(); };
+            test_should_be(RSSHash{}({ip("161.142.100.80"), ip("66.9.149.187"), 1766, 2794}), uint32_t(0x51ccc178));
+            test_should_be(RSSHash{}({ip("65.69.140.83"), ip("199.92.111.2"), 4739, 14230}), uint32_t(0xc626b0ea));
+        }
+
+        // SPSCQueue preserves order and reports full/empty
+        {
+            SPSCQueue<int> q{3};
+            test_should_be(q.capacity(), size_t(4));
+            for (int i = 0; i < 4; i++) {
+                test_should_be(q.push(int(i)), true);
+            }
+            test_should_be(q.push(4), false);
+            int out = -1;
+            for (int i = 0; i < 4; i++) {
+                test_should_be(q.pop(out), true);
+                test_should_be(out, i);
+            }
+            test_should_be(q.pop(out), false);
+        }
+
+        // SPSCQueue across two threads
+        {
+            constexpr int N = 200000;
+            SPSCQueue<int> q{64};
+            thread producer([&] {
+                for (int i = 0; i < N; i++) {
+                    while (not q.push(int(i))) {
+                        this_thread::yield();
+                    }
+                }
+            });
+            int expected = 0, out = 0;
+            while (expected < N) {
+                if (q.pop(out)) {
+                    if (out != expected) {
+                        producer.join();
+                        throw runtime_error("SPSCQueue reordered elements");
+                    }
+                    expected++;
+                } else {
+                    this_thread::yield();
+                }
+            }
+            producer.join();
+        }
+
+        // loopback transfer through a 4-shard engine: every byte arrives, in order, on every flow
+        {
+            constexpr size_t N_FLOWS = 16;
+            constexpr size_t N_SHARDS = 4;
+            vector<string> sent(N_FLOWS), received(N_FLOWS);
+            vector<atomic<bool>> done(N_FLOWS);
+            vector<char> written(N_FLOWS), closed(N_FLOWS);
+            for (size_t i = 0; i < N_FLOWS; i++) {
+                sent[i] = string(10000 + 997 * i, char('a' + i));
+            }
+
+            // the worker thread that services each endpoint; it must never change
+            mutex owner_mutex;
+            vector<thread::id> owner(N_FLOWS * 2);
+            atomic<bool> migrated{false};
+            const auto app = [&](const FlowKey &key, TCPConnection &conn) {
+                const bool server = key.local_port == SERVER_PORT;
+                const size_t flow = (server ? key.remote_port : key.local_port) - CLIENT_PORT_BASE;
+
+                {
+                    lock_guard<mutex> lock(owner_mutex);
+                    thread::id &recorded = owner[2 * flow + server];
+                    if (recorded == thread::id{}) {
+                        recorded = this_thread::get_id();
+                    } else if (recorded != this_thread::get_id()) {
+                        migrated = true;
+                    }
+                }
+
+                if (server) {
+                    received[flow].append(conn.inbound_stream().read(conn.inbound_stream().buffer_size()));
+                    if (conn.inbound_stream().eof() and not closed[flow]) {
+                        conn.end_input_stream();
+                        closed[flow] = true;
+                        done[flow] = true;
+                    }
+                } else if (not written[flow] and conn.remaining_outbound_capacity() >= sent[flow].size()) {
+                    conn.write(sent[flow]);
+                    conn.end_input_stream();
+                    written[flow] = true;
+                }
+            };
+
+            TCPConfig config;
+            config.rt_timeout = 10;
+            TCPShardedEngine engine{N_SHARDS, config, app};
+            engine.listen(SERVER_PORT);
+            engine.start();
+
+            const uint32_t client = Address("10.0.0.1").ipv4_numeric();
+            const uint32_t server = Address("10.0.0.2").ipv4_numeric();
+            for (size_t i = 0; i < N_FLOWS; i++) {
+                const FlowKey key{client, server, uint16_t(CLIENT_PORT_BASE + i), SERVER_PORT};
+                test_should_be(engine.shard_of(key) < N_SHARDS, true);
+                test_should_be(engine.connect(key), true);
+            }
+            // a second connect() to a flow that already exists is ignored, and counted
+            test_should_be(engine.connect({client, server, CLIENT_PORT_BASE, SERVER_PORT}), true);
+
+            const auto all_done = [&] {
+                for (const auto &d : done) {
+                    if (not d) {
+                        return false;
+                    }
+                }
+                return true;
+            };
+            const auto loop_back = [&] {
+                engine.poll_outbound([&](TCPShardedEngine::FlowSegment &&out) {
+                    engine.dispatch(out.key.reversed(), move(out.segment));
+                });
+            };
+            while (not all_done()) {
+                loop_back();
+            }
+            while (engine.active_connections() > 0) {
+                loop_back();
+            }
+            engine.stop();
+
+            uint64_t duplicate_connects = 0;
+            for (size_t shard = 0; shard < N_SHARDS; shard++) {
+                duplicate_connects += engine.stats(shard).duplicate_connects.load();
+            }
+            test_should_be(duplicate_connects, uint64_t(1));
+
+            // endpoints share a thread exactly when shard_of() puts them on the same shard
+            test_should_be(migrated.load(), false);
+            vector<FlowKey> endpoints;
+            for (size_t i = 0; i < N_FLOWS; i++) {
+                const FlowKey key{client, server, uint16_t(CLIENT_PORT_BASE + i), SERVER_PORT};
+                test_should_be(received[i] == sent[i], true);
+                endpoints.push_back(key);
+                endpoints.push_back(key.reversed());
+            }
+            for (size_t a = 0; a < endpoints.size(); a++) {
+                test_should_be(owner[a] != thread::id{}, true);
+                for (size_t b = 0; b < a; b++) {
+                    const bool same_shard = engine.shard_of(endpoints[a]) == engine.shard_of(endpoints[b]);
+                    test_should_be(owner[a] == owner[b], same_shard);
+                }
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
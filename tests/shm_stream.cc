@@ -0,0 +1,160 @@
+#include "eventloop.hh"
+#include "shm_stream.hh"
+#include "tcp_config.hh"
+#include "tcp_sponge_socket.hh"
+#include "test_should_be.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+
+using namespace std;
+
+int main() {
+    try {
+        // basic reads and writes in both directions, wrapping around the (one-page) rings
+        {
+            auto [a, b] = ShmStream::connected_pair(1);
+            test_should_be(a.write("hello"), size_t(5));
+            test_should_be(b.read() == string("hello"), true);
+            test_should_be(b.write("world"), size_t(5));
+            test_should_be(a.read(3) == string("wor"), true);
+            test_should_be(a.read() == string("ld"), true);
+
+            string big(10000, 0);
+            for (size_t i = 0; i < big.size(); i++) {
+                big[i] = char(i % 251);
+            }
+            a.set_blocking(false);
+            b.set_blocking(false);
+            const size_t first = a.write(big, false);
+            test_should_be(first < big.size(), true);  // the ring is smaller than the data
+            test_should_be(a.write(big.substr(first), false), size_t(0));
+            string received = b.read(first / 2);
+            received += b.read();
+            test_should_be(received.size(), first);
+            test_should_be(b.read() == string(), true);  // nothing there, but not EOF
+            test_should_be(b.eof(), false);
+            while (received.size() < big.size()) {
+                a.write(big.substr(received.size()), false);
+                received += b.read();
+            }
+            test_should_be(received == big, true);
+
+            a.shutdown(SHUT_WR);
+            test_should_be(b.read() == string(), true);
+            test_should_be(b.eof(), true);
+            test_should_be(a.eof(), false);
+
+            bool threw = false;
+            b.shutdown(SHUT_RD);
+            try {
+                a.write("x");
+            } catch (const unix_error &) {
+                threw = true;
+            }
+            test_should_be(threw, true);
+        }
+
+        // a bulk transfer between two threads, blocking on both sides
+        {
+            auto [a, b] = ShmStream::connected_pair(4096);
+            constexpr size_t len = 8 * 1024 * 1024;
+            thread writer([&] {
+                string chunk;
+                for (size_t sent = 0; sent < len; sent += chunk.size()) {
+                    chunk.assign(min(len - sent, size_t(3000)), char(sent / 3000));
+                    a.write(chunk);
+                }
+                a.shutdown(SHUT_WR);
+            });
+            size_t received = 0;
+            bool ok = true;
+            while (not b.eof()) {
+                const string data = b.read(1000);
+                for (const char c : data) {
+                    ok = ok and c == char((received++) / 3000);
+                }
+            }
+            writer.join();
+            test_should_be(received, len);
+            test_should_be(ok, true);
+        }
+
+        // driven by an EventLoop, with poll_for_write() for the outbound direction
+        {
+            auto [a, b] = ShmStream::connected_pair(4096);
+            a.set_blocking(false);
+            const string data(100000, 'e');
+            size_t written = 0, received = 0;
+            thread reader([&] {
+                while (not b.eof()) {
+                    received += b.read().size();
+                }
+            });
+
+            EventLoop loop;
+            const auto [fd, direction] = poll_for_write(a);
+            test_should_be(direction == Direction::In, true);
+            loop.add_rule(
+                fd,
+                direction,
+                [&] {
+                    written += a.write(data.substr(written), false);
+                    if (written == data.size()) {
+                        a.shutdown(SHUT_WR);
+                    }
+                },
+                [&] { return written < data.size(); });
+            while (loop.wait_next_event(-1) != EventLoop::Result::Exit) {
+            }
+            reader.join();
+            test_should_be(written, data.size());
+            test_should_be(received, data.size());
+        }
+
+        // a TCPSpongeSocket whose owner stream is a ShmStream
+        {
+            UDPSocket server_udp;
+            server_udp.bind(Address("127.0.0.1", "0"));
+            FdAdapterConfig server_config;
+            server_config.source = server_udp.local_address();
+            FdAdapterConfig client_config;
+            client_config.destination = server_config.source;
+            TCPConfig tcp_config;
+            tcp_config.rt_timeout = 100;
+
+            ShmTCPOverUDPSpongeSocket server{TCPOverUDPSocketAdapter(move(server_udp))};
+            thread server_thread([&] {
+                server.listen_and_accept(tcp_config, server_config);
+                while (not server.eof()) {
+                    server.write(server.read());
+                }
+                server.wait_until_closed();
+            });
+
+            ShmTCPOverUDPSpongeSocket client{TCPOverUDPSocketAdapter(UDPSocket{})};
+            client.connect(tcp_config, client_config);
+            const string request(200000, 'r');  // fits in the rings, so the echo cannot deadlock
+            client.write(request);
+            client.shutdown(SHUT_WR);
+            string reply;
+            while (not client.eof()) {
+                reply += client.read();
+            }
+            client.wait_until_closed();
+            server_thread.join();
+
+            test_should_be(reply == request, true);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
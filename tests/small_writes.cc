@@ -0,0 +1,158 @@
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_connection_pair.hh"
+#include "tcp_segment.hh"
+#include "tcp_sender.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        // Nagle: while "a" is unacknowledged, "b" and "c" wait, and go out together on the ack
+        {
+            TCPConfig cfg;
+            cfg.fixed_isn = WrappingInt32{0};
+            cfg.nodelay = false;
+            TCPSender sender{cfg};
+            sender.fill_window();
+            sender.segments_out().pop();
+            sender.ack_received(WrappingInt32{1}, 60000);
+            sender.stream_in().write("a");
+            sender.fill_window();
+            test_should_be(sender.segments_out().size(), size_t(1));
+            sender.segments_out().pop();
+            sender.stream_in().write("b");
+            sender.fill_window();
+            sender.stream_in().write("c");
+            sender.fill_window();
+            test_should_be(sender.segments_out().size(), size_t(0));
+            sender.ack_received(WrappingInt32{2}, 60000);
+            sender.fill_window();
+            test_should_be(sender.segments_out().size(), size_t(1));
+            test_should_be(sender.segments_out().front().payload().copy() == "bc", true);
+            sender.segments_out().pop();
+
+            // a full segment, or the end of the stream, is not held back
+            sender.stream_in().write(string(TCPConfig::MAX_PAYLOAD_SIZE + 1, 'x'));
+            sender.fill_window();
+            test_should_be(sender.segments_out().size(), size_t(1));
+            sender.segments_out().pop();
+            sender.stream_in().end_input();
+            sender.fill_window();
+            test_should_be(sender.segments_out().size(), size_t(1));
+            test_should_be(sender.segments_out().front().header().fin, true);
+
+            // with NODELAY set again, small segments go out at once
+            TCPSender eager{cfg};
+            eager.set_nodelay(true);
+            eager.fill_window();
+            eager.segments_out().pop();
+            eager.ack_received(WrappingInt32{1}, 60000);
+            for (const char *data : {"a", "b", "c"}) {
+                eager.stream_in().write(data);
+                eager.fill_window();
+            }
+            test_should_be(eager.segments_out().size(), size_t(3));
+        }
+
+        // delayed ACKs: one in-order segment waits for the timer, a second one is acked at once
+        {
+            TCPConfig cfg;
+            cfg.quickack = false;
+            TCPConnection client{TCPConfig{}}, server{cfg};
+            handshake(client, server);
+
+            client.write("one");
+            deliver(client, server);
+            test_should_be(server.segments_out().size(), size_t(0));
+            test_should_be(server.time_until_ack_us(), optional<uint64_t>{cfg.delayed_ack_us});
+            server.tick_us(cfg.delayed_ack_us - 1);
+            test_should_be(server.segments_out().size(), size_t(0));
+            server.tick_us(1);
+            test_should_be(server.segments_out().size(), size_t(1));
+            deliver(server, client);
+            test_should_be(client.bytes_in_flight(), size_t(0));
+            test_should_be(server.time_until_ack_us().has_value(), false);
+
+            client.write("two");
+            deliver(client, server);
+            test_should_be(server.segments_out().size(), size_t(0));
+            client.write("three");
+            deliver(client, server);
+            test_should_be(server.segments_out().size(), size_t(1));
+            deliver(server, client);
+            test_should_be(client.bytes_in_flight(), size_t(0));
+
+            // data of ours carries the pending ACK
+            client.write("four");
+            deliver(client, server);
+            server.write("reply");
+            test_should_be(server.segments_out().size(), size_t(1));
+            test_should_be(server.segments_out().front().header().ack, true);
+            test_should_be(server.time_until_ack_us().has_value(), false);
+            deliver(server, client);
+            deliver(client, server);
+        }
+
+        // a segment beyond a hole, and the one that fills it, are acked at once (for fast retransmit)
+        {
+            TCPConfig cfg;
+            cfg.quickack = false;
+            TCPConnection client{TCPConfig{}}, server{cfg};
+            handshake(client, server);
+
+            client.write("lost");
+            TCPSegment lost = client.segments_out().front();
+            client.segments_out().pop();
+            client.write("later");
+            deliver(client, server);
+            test_should_be(server.segments_out().size(), size_t(1));
+            deliver(server, client);
+            server.segment_received(lost);
+            test_should_be(server.segments_out().size(), size_t(1));
+            test_should_be(server.unassembled_bytes(), size_t(0));
+        }
+
+        // a chatty exchange of one-byte writes: Nagle and delayed ACKs together send far fewer segments
+        {
+            size_t segments[2];
+            for (size_t coalesce = 0; coalesce < 2; coalesce++) {
+                TCPConfig cfg;
+                cfg.nodelay = !coalesce;
+                cfg.quickack = !coalesce;
+                TCPConnection client{cfg}, server{cfg};
+                handshake(client, server);
+                segments[coalesce] = 0;
+                for (size_t i = 0; i < 1000; i++) {
+                    client.write("x");
+                    if (i % 10 == 9) {
+                        segments[coalesce] += deliver(client, server);
+                        segments[coalesce] += deliver(server, client);
+                    }
+                    client.tick_us(1000);
+                    server.tick_us(1000);
+                }
+                for (size_t i = 0; i < 100; i++) {
+                    segments[coalesce] += deliver(client, server) + deliver(server, client);
+                    client.tick_us(1000);
+                    server.tick_us(1000);
+                }
+                test_should_be(server.inbound_stream().buffer_size(), size_t(1000));
+            }
+            test_should_be(segments[1] * 10 < segments[0], true);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,137 @@
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_receiver.hh"
+#include "tcp_segment.hh"
+#include "tcp_sender.hh"
+#include "test_should_be.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+//! Mean payload of the data segments of a transfer to an application that reads 300 bytes per millisecond
+static size_t mean_payload(const bool sws_avoidance) {
+    TCPConfig cfg;
+    cfg.sws_avoidance = sws_avoidance;
+    TCPConnection client{cfg}, server{cfg};
+    client.connect();
+    size_t segments = 0, payload_bytes = 0;
+    for (size_t ms = 0; ms < 2000; ms++) {
+        client.write(string(client.remaining_outbound_capacity(), 'x'));
+        while (not client.segments_out().empty()) {
+            segments += client.segments_out().front().payload().size() > 0;
+            payload_bytes += client.segments_out().front().payload().size();
+            server.segment_received(client.segments_out().front());
+            client.segments_out().pop();
+        }
+        while (not server.segments_out().empty()) {
+            client.segment_received(server.segments_out().front());
+            server.segments_out().pop();
+        }
+        server.inbound_stream().pop_output(min<size_t>(300, server.inbound_stream().buffer_size()));
+        client.tick(1);
+        server.tick(1);
+    }
+    return payload_bytes / segments;
+}
+
+int main() {
+    try {
+        // the receiver opens its window only by whole segments (or half its buffer)
+        {
+            TCPReceiver receiver{10 * MSS};
+            TCPSegment syn;
+            syn.header().syn = true;
+            syn.header().seqno = WrappingInt32{0};
+            receiver.segment_received(syn);
+            test_should_be(receiver.advertise_window(MSS), 10 * MSS);
+            TCPSegment seg;
+            seg.header().seqno = WrappingInt32{1};
+            seg.payload() = string(10 * MSS, 'x');
+            receiver.segment_received(seg);
+            test_should_be(receiver.advertise_window(MSS), size_t(0));
+
+            receiver.stream_out().pop_output(300);
+            test_should_be(receiver.window_size(), size_t(300));
+            test_should_be(receiver.window_update_due(MSS), false);
+            test_should_be(receiver.advertise_window(MSS), size_t(0));
+            receiver.stream_out().pop_output(MSS - 300);
+            test_should_be(receiver.window_update_due(MSS), true);
+            test_should_be(receiver.advertise_window(MSS), MSS);
+            test_should_be(receiver.window_update_due(MSS), false);
+
+            // a small buffer opens by half of itself
+            TCPReceiver small{MSS};
+            small.segment_received(syn);
+            seg.payload() = string(MSS, 'x');
+            small.segment_received(seg);
+            test_should_be(small.advertise_window(MSS), size_t(0));
+            small.stream_out().pop_output(MSS / 2);
+            test_should_be(small.advertise_window(MSS), MSS / 2);
+        }
+
+        // the sender doesn't fill a sliver of window, unless the override timeout passes
+        {
+            TCPConfig cfg;
+            cfg.fixed_isn = WrappingInt32{0};
+            cfg.sws_avoidance = true;
+            TCPSender sender{cfg};
+            sender.fill_window();
+            sender.segments_out().pop();
+            sender.ack_received(WrappingInt32{1}, 4 * MSS);
+            sender.stream_in().write(string(10 * MSS, 'x'));
+            sender.fill_window();
+            test_should_be(sender.segments_out().size(), size_t(4));
+            while (not sender.segments_out().empty()) {
+                sender.segments_out().pop();
+            }
+
+            sender.ack_received(WrappingInt32{1 + MSS}, 3 * MSS + 300);
+            sender.fill_window();
+            test_should_be(sender.segments_out().size(), size_t(0));
+            sender.tick_us(TCPSender::SWS_OVERRIDE_US - 1);
+            test_should_be(sender.segments_out().size(), size_t(0));
+            sender.tick_us(1);
+            test_should_be(sender.segments_out().size(), size_t(1));
+            test_should_be(sender.segments_out().front().payload().size(), size_t(300));
+            sender.segments_out().pop();
+
+            // a zero window is probed only after the override timeout too
+            sender.ack_received(WrappingInt32{1 + 4 * MSS + 300}, 0);
+            sender.fill_window();
+            test_should_be(sender.segments_out().size(), size_t(0));
+            sender.tick_us(TCPSender::SWS_OVERRIDE_US);
+            test_should_be(sender.segments_out().size(), size_t(1));
+            test_should_be(sender.segments_out().front().payload().size(), size_t(1));
+            sender.segments_out().pop();
+
+            // the last of the data goes out even though it is small
+            sender.ack_received(WrappingInt32{1 + 4 * MSS + 301}, 10 * MSS);
+            sender.fill_window();
+            size_t sent = 0;
+            while (not sender.segments_out().empty()) {
+                sent += sender.segments_out().front().payload().size();
+                sender.segments_out().pop();
+            }
+            test_should_be(sent, 10 * MSS - 4 * MSS - 301);
+        }
+
+        // a slow reader: with SWS avoidance, segments stay full-sized
+        {
+            test_should_be(mean_payload(false) < MSS / 2, true);
+            test_should_be(mean_payload(true) > MSS * 9 / 10, true);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,126 @@
+#include "clock.hh"
+#include "network_interface.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_sender.hh"
+#include "tcp_sharded_engine.hh"
+#include "test_should_be.hh"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+using namespace std;
+
+int main() {
+    try {
+        // clocks and stopwatches
+        {
+            VirtualClock clock{5};
+            Stopwatch stopwatch{clock};
+            test_should_be(stopwatch.lap_us(), uint64_t(0));
+            clock.advance_us(250);
+            clock.advance_ms(2);
+            test_should_be(clock.now_us(), uint64_t(2255));
+            test_should_be(stopwatch.lap_us(), uint64_t(2250));
+            test_should_be(stopwatch.lap_us(), uint64_t(0));
+
+            const Clock &real = MonotonicClock::instance();
+            const uint64_t before = real.now_us();
+            this_thread::sleep_for(chrono::milliseconds(2));
+            test_should_be(real.now_us() - before >= 2000, true);
+        }
+
+        // the retransmission timer has microsecond resolution
+        {
+            TCPConfig cfg;
+            cfg.fixed_isn = WrappingInt32{0};
+            cfg.rt_timeout_us = 300;
+            test_should_be(cfg.initial_rto_us(), uint64_t(300));
+
+            TCPSender sender{cfg};
+            sender.fill_window();
+            test_should_be(sender.segments_out().size(), size_t(1));
+            sender.segments_out().pop();
+            sender.tick_us(299);
+            test_should_be(sender.segments_out().size(), size_t(0));
+            sender.tick_us(1);
+            test_should_be(sender.segments_out().size(), size_t(1));  // SYN retransmitted
+            test_should_be(sender.consecutive_retransmissions(), 1u);
+            sender.segments_out().pop();
+            sender.tick_us(599);  // backed off to 600 us
+            test_should_be(sender.segments_out().size(), size_t(0));
+            sender.tick_us(1);
+            test_should_be(sender.segments_out().size(), size_t(1));
+        }
+
+        // millisecond ticks still mean milliseconds
+        {
+            TCPConfig cfg;
+            cfg.rt_timeout = 5;
+            test_should_be(cfg.initial_rto_us(), uint64_t(5000));
+            TCPConnection conn{cfg};
+            conn.connect();
+            conn.segments_out().pop();
+            conn.tick(4);
+            conn.tick_us(999);
+            test_should_be(conn.segments_out().size(), size_t(0));
+            conn.tick_us(1);
+            test_should_be(conn.segments_out().size(), size_t(1));
+            test_should_be(conn.time_since_last_segment_received_us(), uint64_t(5000));
+            test_should_be(conn.time_since_last_segment_received(), size_t(5));
+        }
+
+        // ARP requests are throttled to one per 5 s, whichever unit time is given in
+        {
+            NetworkInterface iface{{0x02, 0, 0, 0, 0, 1}, Address("10.0.0.1")};
+            InternetDatagram dgram;
+            const Address next_hop{"10.0.0.2"};
+            iface.send_datagram(dgram, next_hop);
+            test_should_be(iface.frames_out().size(), size_t(1));
+            iface.tick(4999);
+            iface.tick_us(999);
+            iface.send_datagram(dgram, next_hop);
+            test_should_be(iface.frames_out().size(), size_t(1));
+            iface.tick_us(1);
+            iface.send_datagram(dgram, next_hop);
+            test_should_be(iface.frames_out().size(), size_t(2));
+        }
+
+        // a TCPShardedEngine's timers run on the configured Clock
+        {
+            auto clock = make_shared<VirtualClock>();
+            TCPConfig cfg;
+            cfg.rt_timeout_us = 500;
+            cfg.clock = clock;
+            TCPShardedEngine engine{1, cfg, [](const FlowKey &, TCPConnection &) {}};
+            engine.start();
+            engine.connect({1, 2, 1000, 80});
+
+            size_t syns = 0;
+            const auto wait_for_syns = [&](const size_t n) {
+                for (int i = 0; i < 2000 and syns < n; i++) {
+                    syns += engine.poll_outbound([](TCPShardedEngine::FlowSegment &&) {});
+                    this_thread::sleep_for(chrono::microseconds(100));
+                }
+            };
+            wait_for_syns(1);
+            test_should_be(syns, size_t(1));
+            wait_for_syns(2);  // no virtual time has passed: no retransmission, however long we wait
+            test_should_be(syns, size_t(1));
+            clock->advance_us(500);
+            wait_for_syns(2);
+            test_should_be(syns, size_t(2));
+            engine.stop();
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
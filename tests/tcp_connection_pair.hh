@@ -0,0 +1,26 @@
+#ifndef SPONGE_TESTS_TCP_CONNECTION_PAIR_HH
+#define SPONGE_TESTS_TCP_CONNECTION_PAIR_HH
+
+#include "tcp_connection.hh"
+
+#include <cstddef>
+
+//! Hand every segment `from` has queued to `to`, and return how many there were
+inline size_t deliver(TCPConnection &from, TCPConnection &to) {
+    size_t count = 0;
+    for (; not from.segments_out().empty(); count++) {
+        to.segment_received(from.segments_out().front());
+        from.segments_out().pop();
+    }
+    return count;
+}
+
+//! Open a connection between `client` and `server`, over a path that loses nothing
+inline void handshake(TCPConnection &client, TCPConnection &server) {
+    client.connect();
+    deliver(client, server);
+    deliver(server, client);
+    deliver(client, server);
+}
+
+#endif  // SPONGE_TESTS_TCP_CONNECTION_PAIR_HH
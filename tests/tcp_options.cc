@@ -0,0 +1,173 @@
+#include "parser.hh"
+#include "path_simulator.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_connection_pair.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "tcp_sender.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        // the options survive a round trip through the wire format
+        {
+            TCPHeader syn;
+            syn.syn = true;
+            syn.options.mss = 1460;
+            syn.options.window_scale = 7;
+            syn.options.sack_permitted = true;
+            syn.options.timestamps = TCPOptions::Timestamps{100, 0};
+            test_should_be(syn.length(), size_t(20 + 4 + 4 + 4 + 12));
+            TCPHeader parsed;
+            NetParser p{Buffer{syn.serialize()}};
+            test_should_be(parsed.parse(p) == ParseResult::NoError, true);
+            test_should_be(parsed.options == syn.options, true);
+
+            // a shift beyond 14 means 14
+            string wire = syn.serialize();
+            wire[4 + 3 + 20] = 20;
+            NetParser too_large{Buffer{string(wire)}};
+            test_should_be(parsed.parse(too_large) == ParseResult::NoError, true);
+            test_should_be(parsed.options.window_scale, optional<uint8_t>{TCPOptions::MAX_WINDOW_SCALE});
+
+            // next to timestamps, only three SACK blocks fit in the option space
+            TCPHeader ack;
+            ack.ack = true;
+            ack.options.timestamps = TCPOptions::Timestamps{200, 100};
+            for (uint32_t i = 0; i < TCPOptions::MAX_SACK_BLOCKS; i++) {
+                ack.options.sack.push_back({WrappingInt32{1000 * i + 500}, WrappingInt32{1000 * i + 600}});
+            }
+            test_should_be(ack.length(), size_t(60));
+            NetParser q{Buffer{ack.serialize()}};
+            test_should_be(parsed.parse(q) == ParseResult::NoError, true);
+            test_should_be(parsed.options.timestamps == ack.options.timestamps, true);
+            test_should_be(parsed.options.sack.size(), size_t(3));
+        }
+
+        // the shift is the smallest that lets the whole buffer be advertised
+        {
+            TCPConfig cfg;
+            test_should_be(cfg.window_scale(), uint8_t(0));
+            cfg.recv_capacity = 65536;
+            test_should_be(cfg.window_scale(), uint8_t(1));
+            cfg.recv_capacity = 1'000'000;
+            test_should_be(cfg.window_scale(), uint8_t(4));
+        }
+
+        // both ends offer everything: scaled windows, the larger MSS, and timestamps on every segment
+        {
+            TCPConfig cfg;
+            cfg.recv_capacity = 1'000'000;
+            cfg.send_capacity = 1'000'000;
+            cfg.mss = 1460;
+            cfg.window_scaling = true;
+            cfg.timestamps = true;
+            TCPConnection client{cfg}, server{cfg};
+            client.connect();
+            const TCPHeader client_syn = client.segments_out().front().header();
+            test_should_be(client_syn.options.mss, optional<uint16_t>{1460});
+            test_should_be(client_syn.options.window_scale, optional<uint8_t>{4});
+            deliver(client, server);
+            const TCPHeader syn_ack = server.segments_out().front().header();
+            test_should_be(syn_ack.win, uint16_t(65535));  // a SYN's window is never scaled
+            test_should_be(syn_ack.options.window_scale, optional<uint8_t>{4});
+            test_should_be(syn_ack.options.timestamps.has_value(), true);
+            deliver(server, client);
+            test_should_be(client.segments_out().front().header().win, uint16_t(1'000'000 >> 4));
+            deliver(client, server);
+
+            server.write(string(200'000, 'x'));
+            test_should_be(server.bytes_in_flight(), size_t(200'000));
+            test_should_be(server.segments_out().front().payload().size(), size_t(1460));
+            test_should_be(server.segments_out().front().header().options.timestamps.has_value(), true);
+        }
+
+        // without the peer's offers, windows stay below 64 KiB and payloads at MAX_PAYLOAD_SIZE
+        {
+            TCPConfig cfg;
+            cfg.send_capacity = 1'000'000;
+            cfg.mss = 1460;
+            cfg.window_scaling = true;
+            cfg.timestamps = true;
+            TCPConfig plain;
+            plain.recv_capacity = 1'000'000;
+            TCPConnection client{plain}, server{cfg};
+            client.connect();
+            deliver(client, server);
+            const TCPHeader syn_ack = server.segments_out().front().header();
+            test_should_be(syn_ack.options.mss, optional<uint16_t>{1460});
+            test_should_be(syn_ack.options.window_scale.has_value(), false);
+            test_should_be(syn_ack.options.timestamps.has_value(), false);
+            deliver(server, client);
+            deliver(client, server);
+
+            server.write(string(200'000, 'x'));
+            test_should_be(server.bytes_in_flight(), size_t(65535));
+            test_should_be(server.segments_out().front().payload().size(), TCPConfig::MAX_PAYLOAD_SIZE);
+            test_should_be(server.segments_out().front().header().options.timestamps.has_value(), false);
+        }
+
+        // a timestamp echo gives the RTO a sample even for retransmitted data (Karn's rule doesn't apply)
+        {
+            TCPConfig cfg;
+            cfg.fixed_isn = WrappingInt32{0};
+            cfg.adaptive_rto = true;
+            for (const bool echo : {false, true}) {
+                TCPSender sender{cfg};
+                sender.fill_window();
+                sender.tick_us(100'000);
+                sender.ack_received(WrappingInt32{1}, 60000);
+                test_should_be(sender.rto_us(), uint64_t(300'000));
+
+                sender.stream_in().write("hello");
+                sender.fill_window();
+                sender.tick_us(300'000);
+                test_should_be(sender.rto_us(), uint64_t(600'000));  // retransmitted, backed off
+                sender.tick_us(20'000);
+                if (echo) {
+                    sender.timestamp_echo_received(20'000);
+                }
+                sender.ack_received(WrappingInt32{6}, 60000);
+                test_should_be(sender.rto_us(), echo ? uint64_t(320'000) : uint64_t(600'000));
+            }
+        }
+
+        // on a long fat path, a window beyond 64 KiB fills the pipe
+        {
+            PathConfig path;
+            path.rate_bps = 20'000'000;
+            path.rtt_us = 100'000;
+            path.queue_bytes = 250'000;
+            path.step_us = 500;
+
+            uint64_t delivered[2];
+            for (size_t scaled = 0; scaled < 2; scaled++) {
+                TCPConfig cfg;
+                cfg.send_capacity = 1'000'000;
+                cfg.recv_capacity = 1'000'000;
+                cfg.congestion_control = CongestionControlAlgorithm::NewReno;
+                cfg.sack = true;
+                cfg.window_scaling = scaled;
+                PathSimulator sim{cfg, cfg, path};
+                sim.run_for(5'000'000);
+                delivered[scaled] = sim.stats().bytes_delivered;
+            }
+            test_should_be(delivered[1] > 2 * delivered[0], true);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,125 @@
+#include "address.hh"
+#include "fd_adapter.hh"
+#include "path_simulator.hh"
+#include "socket.hh"
+#include "tcp_config.hh"
+#include "tcp_segment.hh"
+#include "tcp_sender.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+int main() {
+    try {
+        // late segmentation: headers are copied, payloads sliced, and FIN moves to the last piece
+        {
+            TCPSegment seg;
+            seg.header().seqno = WrappingInt32{1000};
+            seg.header().ack = true;
+            seg.header().fin = true;
+            seg.payload() = string(2500, 'x');
+            test_should_be(seg.wire_segments().size(), size_t(1));  // not a super-segment
+            seg.set_tso_segment_size(1000);
+            const vector<TCPSegment> wire = seg.wire_segments();
+            test_should_be(wire.size(), size_t(3));
+            for (size_t i = 0; i < wire.size(); i++) {
+                test_should_be(wire[i].header().seqno, WrappingInt32{uint32_t(1000 + 1000 * i)});
+                test_should_be(wire[i].header().ack, true);
+                test_should_be(wire[i].header().fin, i == 2);
+                test_should_be(wire[i].tso_segment_size(), size_t(0));
+                test_should_be(wire[i].payload().str().data() == seg.payload().str().data() + 1000 * i, true);
+            }
+            test_should_be(wire[2].payload().size(), size_t(500));
+        }
+
+        // the sender emits a window as one super-segment, and splits it when part of it is acked or lost
+        {
+            TCPConfig cfg;
+            cfg.fixed_isn = WrappingInt32{0};
+            cfg.tso_max_size = 64 * 1024;
+            TCPSender sender{cfg};
+            sender.fill_window();
+            sender.segments_out().pop();
+            sender.ack_received(WrappingInt32{1}, 60000);
+            sender.stream_in().write(string(20 * MSS, 'x'));
+            sender.fill_window();
+            test_should_be(sender.segments_out().size(), size_t(1));
+            test_should_be(sender.segments_out().front().payload().size(), 20 * MSS);
+            test_should_be(sender.segments_out().front().tso_segment_size(), MSS);
+            sender.segments_out().pop();
+
+            sender.ack_received(WrappingInt32{1 + 5 * MSS}, 60000);
+            test_should_be(sender.bytes_in_flight(), 15 * MSS);
+            // a timeout resends one wire segment, not the rest of the burst
+            sender.tick(sender.rto_us() / 1000);
+            test_should_be(sender.segments_out().size(), size_t(1));
+            test_should_be(sender.segments_out().front().header().seqno, WrappingInt32{1 + 5 * MSS});
+            test_should_be(sender.segments_out().front().payload().size(), MSS);
+            test_should_be(sender.segments_out().front().tso_segment_size(), size_t(0));
+            sender.ack_received(WrappingInt32{1 + 20 * MSS}, 60000);
+            test_should_be(sender.bytes_in_flight(), size_t(0));
+        }
+
+        // over UDP, a super-segment becomes one datagram per wire segment (sent with UDP GSO where available)
+        {
+            UDPSocket receiver;
+            receiver.bind(Address{"127.0.0.1", 0});
+            UDPSocket sender_sock;
+            sender_sock.bind(Address{"127.0.0.1", 0});
+            TCPOverUDPSocketAdapter adapter{move(sender_sock)};
+            adapter.config_mut().destination = receiver.local_address();
+
+            const size_t count = TCPOverUDPSocketAdapter::GSO_MAX_SEGMENTS + 6;
+            TCPSegment seg;
+            seg.header().seqno = WrappingInt32{5};
+            seg.payload() = string(count * MSS, 'y');
+            seg.set_tso_segment_size(MSS);
+            adapter.write(seg);
+            for (size_t i = 0; i < count; i++) {
+                TCPSegment wire_seg;
+                test_should_be(wire_seg.parse(receiver.recv().payload) == ParseResult::NoError, true);
+                test_should_be(wire_seg.header().seqno, WrappingInt32{uint32_t(5 + i * MSS)});
+                test_should_be(wire_seg.payload().size(), MSS);
+            }
+        }
+
+        // on a path, super-segments are split at the bottleneck: the transfer is the same as without
+        {
+            PathConfig path;
+            path.rate_bps = 20'000'000;
+            path.rtt_us = 20'000;
+            path.queue_bytes = 100'000;
+            path.loss_rate = 0.001;
+            path.step_us = 100;
+
+            uint64_t delivered[2];
+            for (size_t tso = 0; tso < 2; tso++) {
+                TCPConfig cfg;
+                cfg.send_capacity = 1'000'000;
+                cfg.recv_capacity = 1'000'000;
+                cfg.congestion_control = CongestionControlAlgorithm::NewReno;
+                cfg.sack = true;
+                cfg.window_scaling = true;
+                cfg.tso_max_size = tso ? 64 * 1024 : 0;
+                PathSimulator sim{cfg, cfg, path};
+                sim.run_for(3'000'000);
+                delivered[tso] = sim.stats().bytes_delivered;
+            }
+            test_should_be(delivered[1] > delivered[0] * 9 / 10, true);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
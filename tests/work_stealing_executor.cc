@@ -0,0 +1,101 @@
+#include "test_should_be.hh"
+#include "work_stealing_executor.hh"
+
+#include <atomic>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+int main() {
+    try {
+        // tasks on one strand run in order and never overlap, whichever worker runs them
+        for (const bool stealing : {false, true}) {
+            constexpr size_t N_STRANDS = 32;
+            constexpr size_t N_TASKS = 2000;
+            WorkStealingExecutor executor{4, stealing, 3};
+
+            vector<shared_ptr<WorkStealingExecutor::Strand>> strands;
+            vector<size_t> next(N_STRANDS);
+            vector<atomic<int>> running(N_STRANDS);
+            atomic<bool> ok{true};
+            for (size_t s = 0; s < N_STRANDS; s++) {
+                strands.push_back(executor.make_strand(s % 2));  // deliberately unbalanced homes
+            }
+
+            for (size_t t = 0; t < N_TASKS; t++) {
+                for (size_t s = 0; s < N_STRANDS; s++) {
+                    executor.post(strands[s], [&, s, t] {
+                        if (running[s]++ != 0 or next[s] != t) {
+                            ok = false;
+                        }
+                        next[s] = t + 1;
+                        running[s]--;
+                    });
+                }
+            }
+            executor.wait_idle();
+
+            test_should_be(ok.load(), true);
+            for (size_t s = 0; s < N_STRANDS; s++) {
+                test_should_be(next[s], N_TASKS);
+            }
+
+            uint64_t total = 0;
+            for (size_t w = 0; w < executor.worker_count(); w++) {
+                total += executor.stats(w).tasks_run.load();
+                if (not stealing) {
+                    test_should_be(executor.stats(w).steals.load(), uint64_t(0));
+                }
+            }
+            test_should_be(total, uint64_t(N_STRANDS * N_TASKS));
+            if (not stealing) {
+                // static sharding: workers 2 and 3 are home to no strand, so they never run anything
+                test_should_be(executor.stats(2).tasks_run.load() + executor.stats(3).tasks_run.load(), uint64_t(0));
+            }
+        }
+
+        // an idle worker steals a strand that is stuck behind a blocked one on the same home worker
+        {
+            WorkStealingExecutor executor{2, true};
+            auto blocked = executor.make_strand(0);
+            auto stuck = executor.make_strand(0);
+            atomic<bool> released{false};
+
+            executor.post(blocked, [&] {
+                while (not released) {
+                    this_thread::yield();
+                }
+            });
+            executor.post(stuck, [&] { released = true; });
+            executor.wait_idle();
+
+            test_should_be(executor.stats(0).steals.load() + executor.stats(1).steals.load() > 0, true);
+        }
+
+        // tasks may post follow-up work to their own strand
+        {
+            WorkStealingExecutor executor{3};
+            auto strand = executor.make_strand();
+            size_t count = 0;
+            function<void()> step = [&] {
+                if (++count < 100) {
+                    executor.post(strand, function<void()>(step));
+                }
+            };
+            executor.post(strand, function<void()>(step));
+            executor.wait_idle();
+            test_should_be(count, size_t(100));
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,103 @@
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <initializer_list>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+// unwrap() is constexpr
+static_assert(unwrap(WrappingInt32{1}, WrappingInt32{0}, 0) == 1);
+static_assert(unwrap(WrappingInt32{UINT32_MAX}, WrappingInt32{0}, 0) == UINT32_MAX);
+static_assert(unwrap(WrappingInt32{15}, WrappingInt32{16}, 0) == UINT32_MAX);
+static_assert(unwrap(WrappingInt32{0}, WrappingInt32{0}, uint64_t{1} << 32) == uint64_t{1} << 32);
+static_assert(wrap(uint64_t{3} << 32, WrappingInt32{7}) == WrappingInt32{7});
+
+//! The absolute seqno that wraps to `n`, closest to `checkpoint` (the smaller one on a tie), by brute force
+static uint64_t reference_unwrap(const WrappingInt32 n, const WrappingInt32 isn, const uint64_t checkpoint) {
+    const uint64_t offset = uint32_t(n.raw_value() - isn.raw_value());
+    optional<uint64_t> best{};
+    uint64_t best_distance = 0;
+    for (int64_t wraps = int64_t(checkpoint >> 32) - 1; wraps <= int64_t(checkpoint >> 32) + 1; wraps++) {
+        if (wraps < 0) {
+            continue;
+        }
+        const uint64_t candidate = (uint64_t(wraps) << 32) + offset;
+        const uint64_t distance = candidate > checkpoint ? candidate - checkpoint : checkpoint - candidate;
+        if (not best or distance < best_distance) {  // candidates go up: a tie keeps the smaller
+            best = candidate;
+            best_distance = distance;
+        }
+    }
+    return *best;
+}
+
+static void check(const WrappingInt32 n, const WrappingInt32 isn, const uint64_t checkpoint) {
+    const uint64_t expected = reference_unwrap(n, isn, checkpoint);
+    const uint64_t actual = unwrap(n, isn, checkpoint);
+    if (actual != expected || wrap(actual, isn) != n) {
+        ostringstream ss;
+        ss << "unwrap(" << n << ", " << isn << ", " << checkpoint << ") returned " << actual << ", expected "
+           << expected;
+        throw runtime_error(ss.str());
+    }
+}
+
+int main() {
+    try {
+        constexpr uint64_t wrap_size = uint64_t{1} << 32, half = uint64_t{1} << 31;
+
+        // ISNs at the edges of the 32-bit space
+        const vector<uint32_t> isns{0, 1, uint32_t(half) - 1, uint32_t(half), uint32_t(half) + 1, UINT32_MAX - 1,
+                                    UINT32_MAX, 0x1234'5678};
+
+        // checkpoints at zero, and on either side of the first few wraps and half-wraps
+        vector<uint64_t> checkpoints;
+        for (uint64_t k = 0; k < 4; k++) {
+            for (const uint64_t edge : {k * wrap_size, k * wrap_size + half}) {
+                for (int64_t delta = -3; delta <= 3; delta++) {
+                    if (int64_t(edge) + delta >= 0) {
+                        checkpoints.push_back(edge + delta);
+                    }
+                }
+            }
+        }
+        checkpoints.push_back(uint64_t{1} << 62);
+
+        // targets within a few of the checkpoint, and on either side of half a wrap away (the tie)
+        vector<int64_t> steps;
+        for (int64_t delta = -3; delta <= 3; delta++) {
+            steps.push_back(delta);
+            steps.push_back(int64_t(half) + delta);
+            steps.push_back(-int64_t(half) + delta);
+            steps.push_back(int64_t(wrap_size) - 1 + delta);
+        }
+
+        for (const uint32_t isn : isns) {
+            for (const uint64_t checkpoint : checkpoints) {
+                for (const int64_t step : steps) {
+                    const uint64_t target = checkpoint + uint64_t(step);
+                    check(wrap(target, WrappingInt32{isn}), WrappingInt32{isn}, checkpoint);
+                }
+            }
+        }
+
+        // every relative seqno of a 2^16 window straddling the first wrap, checkpoint on both sides
+        for (const uint64_t checkpoint : {wrap_size - 1, wrap_size, wrap_size + 1}) {
+            for (uint64_t target = wrap_size - 32768; target < wrap_size + 32768; target++) {
+                check(wrap(target, WrappingInt32{7}), WrappingInt32{7}, checkpoint);
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}